@@ -0,0 +1,256 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Bench.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo micro-benchmarks
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Bench.h"
+#include "DHT.h"
+#include "LCD.h"
+#include "Thimo.h"
+
+#if defined(ESP32) && !defined(THIMO_SIMULATION)
+#include <Preferences.h>
+#endif
+
+// The last column is the baseline "bench cmp" checks against when none was
+// stored with "bench save": the cycles "bench" printed on the reference
+// unit, 0 until one is recorded. The host build compares against
+// host/fixtures/bench.json instead, its cycles aren't the ESP32 ones.
+const BenchModule::BenchCase BenchModule::s_cases[BENCH_CASES] = {
+	{ "lcd_line",				100,	&BenchModule::lcdString,	0, 0 },
+	{ "lcd_char",				100,	&BenchModule::lcdString,	1, 0 },
+	{ "render_environment",		20,		&BenchModule::renderView,	ENVIRONMENT, 0 },
+	{ "render_manual",			20,		&BenchModule::renderView,	MANUAL, 0 },
+	{ "render_clock",			20,		&BenchModule::renderView,	CLOCK, 0 },
+	{ "render_timetable1",		20,		&BenchModule::renderView,	TIMETABLE1, 0 },
+	{ "render_timetable2",		20,		&BenchModule::renderView,	TIMETABLE2, 0 },
+	{ "render_timetable3",		20,		&BenchModule::renderView,	TIMETABLE3, 0 },
+	{ "render_timetable4",		20,		&BenchModule::renderView,	TIMETABLE4, 0 },
+	{ "render_timetable5",		20,		&BenchModule::renderView,	TIMETABLE5, 0 },
+	{ "render_energy",			20,		&BenchModule::renderView,	ENERGY, 0 },
+	{ "render_override",		20,		&BenchModule::renderView,	OVERRIDE, 0 },
+	{ "dht_decode",				100,	&BenchModule::dhtDecode,	0, 0 },
+	{ "dew_point",				100,	&BenchModule::dewPoint,		0, 0 },
+	{ "heat_index",				100,	&BenchModule::heatIndex,	0, 0 },
+	{ "comfort_ratio",			100,	&BenchModule::comfortRatio,	0, 0 },
+	{ "perception",				100,	&BenchModule::perception,	0, 0 },
+	{ "setpoint",				100,	&BenchModule::setpoint,		0, 0 }
+};
+
+// Two frames of the 16x2 display per case: every cell of the first row
+// changes, or only one
+static const char *const lcdText[][2] = {
+	{ "Mon 19 Oct 12:00", "21.5C 48% AUTO *" },
+	{ "T 21.5C  H 48%  ", "T 21.6C  H 48%  " }
+};
+
+// Answers every read with the opposite level, so the capture loop sees one
+// edge per read: no time on the wire, all zero bits and a valid checksum
+struct BenchPin {
+	mutable uint8_t level;
+
+	inline BenchPin() : level(1) {}
+	inline int read() const { return level ^= 1; }
+	inline void output() const {}
+	inline void input() const {}
+};
+
+// the comfort math only needs a DHTBase, this one never touches its pin
+static DHTSensor<DHTBase::DHT_MODEL, DHT_PIN> dht;
+
+BenchModule::BenchModule() :
+	m_loaded(false),
+	m_sink(0.0f) {
+	for (uint8_t i = 0; i < BENCH_CASES; i++) {
+		m_baseline[i] = s_cases[i].baseline;
+	}
+}
+
+// The baselines stored by "bench save", if any, the first time they're
+// needed: nothing is read from flash at boot for them. A set stored for
+// another list of cases doesn't fit and is left alone.
+void BenchModule::load() {
+	m_loaded = true;
+#if defined(ESP32) && !defined(THIMO_SIMULATION)
+	Preferences preferences;
+	uint32_t stored[BENCH_CASES];
+
+	if (!preferences.begin("thimo", true)) {
+		return;
+	}
+	if (preferences.getBytes("bench", stored, sizeof(stored)) == sizeof(stored)) {
+		memcpy(m_baseline, stored, sizeof(m_baseline));
+	}
+	preferences.end();
+#endif
+}
+
+void BenchModule::store() {
+#if defined(ESP32) && !defined(THIMO_SIMULATION)
+	Preferences preferences;
+
+	if (!preferences.begin("thimo", false)) {
+		return;
+	}
+	preferences.putBytes("bench", m_baseline, sizeof(m_baseline));
+	preferences.end();
+#endif
+}
+
+void BenchModule::run(uint8_t index, BenchResult &result) {
+	const BenchCase &c = s_cases[index];
+
+	if (!m_loaded) {
+		load();
+	}
+
+	result.name = c.name;
+	result.iterations = c.iterations;
+	result.cycles = 0xffffffffUL;
+	result.bytes = 0;
+	result.transactions = 0;
+	result.baseline = m_baseline[index];
+
+	for (uint8_t r = 0; r < BENCH_RUNS; r++) {
+		uint32_t cost = (this->*c.run)(c.iterations, c.arg, result);
+		if (cost < result.cycles) {
+			result.cycles = cost;
+		}
+	}
+}
+
+void BenchModule::save(uint8_t index, const BenchResult &result) {
+	m_baseline[index] = result.cycles;
+}
+
+bool BenchModule::regression(const BenchResult &result) {
+	return result.baseline > 0 && (uint64_t)result.cycles * 100 > (uint64_t)result.baseline * (100 + BENCH_TOLERANCE);
+}
+
+// A case returns the cycles per iteration of one run of n iterations
+
+uint32_t BenchModule::lcdString(uint16_t n, uint8_t arg, BenchResult &result) {
+	RecordingBus bus;
+	LCDModule lcd(bus);
+	uint32_t bytes = 0;
+	uint32_t transactions = 0;
+
+	lcd.begin(16, 2);
+	bus.clear();
+
+	uint32_t start = cycles();
+	for (uint16_t i = 0; i < n; i++) {
+		lcd.frame();
+		lcd.print(lcdText[arg][i & 1]);
+		lcd.swap();
+		// the recording is capped, count it before it fills up
+		bytes += bus.count();
+		transactions += bus.transactions();
+		bus.clear();
+	}
+	uint32_t elapsed = cycles() - start;
+
+	result.bytes = bytes / n;
+	result.transactions = transactions / n;
+
+	return elapsed / n;
+}
+
+uint32_t BenchModule::renderView(uint16_t n, uint8_t arg, BenchResult &result) {
+	uint32_t start = cycles();
+	for (uint16_t i = 0; i < n; i++) {
+		Thimo.render(arg);
+	}
+
+	return (cycles() - start) / n;
+}
+
+uint32_t BenchModule::dhtDecode(uint16_t n, uint8_t arg, BenchResult &result) {
+	Environment env;
+	uint16_t rawHumidity;
+	uint16_t rawTemperature;
+
+	uint32_t start = cycles();
+	for (uint16_t i = 0; i < n; i++) {
+		if (::dhtCapture(BenchPin(), rawHumidity, rawTemperature) == Sensor::ERROR_NONE) {
+			DHTTraits<DHTBase::DHT_MODEL>::decode(rawHumidity, rawTemperature, &env);
+			m_sink = env.temperature;
+		}
+	}
+
+	return (cycles() - start) / n;
+}
+
+// An iteration of the comfort math is the whole sweep of 15..22.5 °C by
+// 30..65 %RH, BENCH_SWEEP inputs: one call alone takes a few cycles, less
+// than the clock of a host resolves. Constant inputs could be folded.
+
+uint32_t BenchModule::dewPoint(uint16_t n, uint8_t arg, BenchResult &result) {
+	uint32_t start = cycles();
+	for (uint16_t i = 0; i < n; i++) {
+		for (uint8_t j = 0; j < BENCH_SWEEP; j++) {
+			m_sink = dht.computeDewPoint(15.0f + (j & 15) * 0.5f, 30.0f + (j >> 4) * 5.0f);
+		}
+	}
+
+	return (cycles() - start) / n;
+}
+
+uint32_t BenchModule::heatIndex(uint16_t n, uint8_t arg, BenchResult &result) {
+	uint32_t start = cycles();
+	for (uint16_t i = 0; i < n; i++) {
+		for (uint8_t j = 0; j < BENCH_SWEEP; j++) {
+			m_sink = dht.computeHeatIndex(15.0f + (j & 15) * 0.5f, 30.0f + (j >> 4) * 5.0f);
+		}
+	}
+
+	return (cycles() - start) / n;
+}
+
+uint32_t BenchModule::comfortRatio(uint16_t n, uint8_t arg, BenchResult &result) {
+	ComfortState state;
+
+	uint32_t start = cycles();
+	for (uint16_t i = 0; i < n; i++) {
+		for (uint8_t j = 0; j < BENCH_SWEEP; j++) {
+			m_sink = dht.comfortRatio(state, 15.0f + (j & 15) * 0.5f, 30.0f + (j >> 4) * 5.0f);
+		}
+	}
+
+	return (cycles() - start) / n;
+}
+
+uint32_t BenchModule::perception(uint16_t n, uint8_t arg, BenchResult &result) {
+	uint32_t start = cycles();
+	for (uint16_t i = 0; i < n; i++) {
+		for (uint8_t j = 0; j < BENCH_SWEEP; j++) {
+			m_sink = dht.computePerception(15.0f + (j & 15) * 0.5f, 30.0f + (j >> 4) * 5.0f);
+		}
+	}
+
+	return (cycles() - start) / n;
+}
+
+// The timetable lookup of the shown zone, BENCH_SWEEP of them round the
+// clock an iteration; manual mode reads the pot
+uint32_t BenchModule::setpoint(uint16_t n, uint8_t arg, BenchResult &result) {
+	uint8_t z = Thimo.shownZone();
+
+	uint32_t start = cycles();
+	for (uint16_t i = 0; i < n; i++) {
+		for (uint8_t j = 0; j < BENCH_SWEEP; j++) {
+			m_sink = Thimo.setpoint(z, j % 24);
+		}
+	}
+
+	return (cycles() - start) / n;
+}
+
+BenchModule Bench;
@@ -0,0 +1,95 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Bench.h
+ * Created on: 19 Oct 2026
+ * Description: Thimo micro-benchmarks
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#ifndef _THIMO_BENCH_H_
+#define _THIMO_BENCH_H_
+
+#include <Arduino.h>
+#include "config.h"
+
+#if !defined(ESP32) && defined(__linux__)
+#include <time.h>
+#endif
+
+#define BENCH_CASES					18
+#define BENCH_SWEEP					128		// calls per iteration of the comfort math and setpoint cases
+
+// Every case times its hot path BENCH_RUNS times over its iteration count
+// and keeps the fastest run, so an interrupt or a task switch landing in
+// one of them doesn't count. Costs are CPU cycles per iteration: the cycle
+// counter on ESP32, the monotonic clock on Linux hosts and micros()
+// elsewhere, scaled by the clock.
+struct BenchResult {
+	const char *name;
+	uint16_t iterations;
+	uint32_t cycles;		// per iteration, fastest run
+	uint32_t bytes;			// display bytes per iteration, lcd cases only
+	uint32_t transactions;	// bus transactions per iteration, lcd cases only
+	uint32_t baseline;		// cycles, 0 if none was stored
+};
+
+class BenchModule {
+public:
+	BenchModule();
+
+	inline uint8_t cases() const { return BENCH_CASES; }
+	inline const char *name(uint8_t index) const { return s_cases[index].name; }
+	void run(uint8_t index, BenchResult &result);
+	void save(uint8_t index, const BenchResult &result);
+	void store();		// the saved baselines to flash, they outlive a reboot
+
+	// over the baseline by more than BENCH_TOLERANCE percent
+	static bool regression(const BenchResult &result);
+
+	static inline uint32_t cycles() {
+#ifdef ESP32
+		return ESP.getCycleCount();
+#elif defined(__linux__)
+		struct timespec now;
+
+		clock_gettime(CLOCK_MONOTONIC, &now);
+
+		return ((uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec) * (F_CPU / 1000000UL) / 1000ULL;
+#else
+		return micros() * (F_CPU / 1000000UL);
+#endif
+	}
+private:
+	struct BenchCase {
+		const char *name;
+		uint16_t iterations;
+		uint32_t (BenchModule::*run)(uint16_t n, uint8_t arg, BenchResult &result);
+		uint8_t arg;
+		uint32_t baseline;	// cycles, 0 if none
+	};
+
+	static const BenchCase s_cases[BENCH_CASES];
+
+	uint32_t lcdString(uint16_t n, uint8_t arg, BenchResult &result);
+	uint32_t renderView(uint16_t n, uint8_t arg, BenchResult &result);
+	uint32_t dhtDecode(uint16_t n, uint8_t arg, BenchResult &result);
+	uint32_t dewPoint(uint16_t n, uint8_t arg, BenchResult &result);
+	uint32_t heatIndex(uint16_t n, uint8_t arg, BenchResult &result);
+	uint32_t comfortRatio(uint16_t n, uint8_t arg, BenchResult &result);
+	uint32_t perception(uint16_t n, uint8_t arg, BenchResult &result);
+	uint32_t setpoint(uint16_t n, uint8_t arg, BenchResult &result);
+
+	void load();
+
+	uint32_t m_baseline[BENCH_CASES];
+	bool m_loaded;				// the stored baselines were looked for
+	volatile float m_sink;		// keeps results the compiler could drop
+};
+
+extern BenchModule Bench;
+
+#endif
@@ -0,0 +1,40 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Boot.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo boot timeline
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Boot.h"
+#include "Log.h"
+
+#ifdef ESP32
+#include <esp_system.h>
+#endif
+
+BootModule::BootModule() {
+	for (int i = 0; i < STEP_COUNT; i++) {
+		m_time[i] = 0UL;
+	}
+}
+
+// micros() counts from reset, so every mark is the time since power-on/reset
+void BootModule::mark(Step step) {
+	m_time[step] = micros();
+}
+
+void BootModule::report() {
+	for (int i = 0; i < STEP_COUNT; i++) {
+		LOG_INFO(LOG_BOOT_STEP, i, m_time[i]);
+	}
+#ifdef ESP32
+	LOG_INFO(LOG_RESET_REASON, esp_reset_reason());
+#endif
+}
+
+BootModule Boot;
@@ -0,0 +1,42 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Boot.h
+ * Created on: 19 Oct 2026
+ * Description: Thimo boot timeline
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#ifndef _THIMO_BOOT_H_
+#define _THIMO_BOOT_H_
+
+#include <Arduino.h>
+
+class BootModule {
+public:
+	typedef enum {
+		STEP_RTC,
+		STEP_SCHEDULE,
+		STEP_RELAY,
+		STEP_CONTROL,
+		STEP_UI,
+		STEP_LCD,
+		STEP_COUNT
+	} Step;
+
+	BootModule();
+
+	void mark(Step step);
+	void report();
+
+	inline unsigned long elapsed(Step step) const { return m_time[step]; }
+private:
+	unsigned long m_time[STEP_COUNT];
+};
+
+extern BootModule Boot;
+
+#endif
@@ -11,7 +11,26 @@
  */
  
 #include "Button.h"
+#include "Power.h"
+#include "Trace.h"
 
 Button ButtonS(BUTTON_S_PIN);
 Button ButtonN(BUTTON_N_PIN);
 Button ButtonP(BUTTON_P_PIN);
+
+static Button *const buttons[BUTTON_COUNT] = { &ButtonS, &ButtonN, &ButtonP };
+
+bool buttonPressed(ButtonId id) {
+#ifdef THIMO_SIMULATION
+	if (Trace.replaying()) {
+		return Trace.pressed(id);
+	}
+#endif
+	if (buttons[id]->toggled() && buttons[id]->read() == Button::PRESSED) {
+		Trace.button(id);
+		Power.pressed();
+		return true;
+	}
+
+	return false;
+}
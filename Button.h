@@ -20,4 +20,15 @@ extern Button ButtonS;
 extern Button ButtonN;
 extern Button ButtonP;
 
+typedef enum {
+	BUTTON_SELECT,
+	BUTTON_NEXT,
+	BUTTON_PREVIOUS,
+	BUTTON_COUNT
+} ButtonId;
+
+// A debounced press of the button, recorded in the trace. While a trace is
+// replayed the presses come from it instead.
+bool buttonPressed(ButtonId id);
+
 #endif
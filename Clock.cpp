@@ -0,0 +1,295 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Clock.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo time source
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Clock.h"
+#include "Trace.h"
+#include "Log.h"
+
+#if defined(ESP32) && !defined(THIMO_SIMULATION)
+#include <Preferences.h>
+#endif
+
+#define CLOCK_YEAR					31556952UL	// s, mean Gregorian year
+
+static const uint8_t monthDays[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+uint32_t ClockModule::toLocal(uint32_t utc) const {
+	return utc + (summer(utc) ? TIME_ZONE + TIME_DST : TIME_ZONE) * 60L;
+}
+
+// The hour skipped in spring is taken as standard time, the hour repeated
+// in autumn as its first occurrence
+uint32_t ClockModule::toUtc(uint32_t local) const {
+	uint32_t utc = local - (TIME_ZONE + TIME_DST) * 60L;
+
+	return summer(utc) ? utc : local - TIME_ZONE * 60L;
+}
+
+// The year is estimated from the mean year length, a day off at most around
+// new year: far from any transition, so either year gives the right answer
+bool ClockModule::summer(uint32_t utc) const {
+	uint32_t y = (utc - m_base) / CLOCK_YEAR;
+
+	if (TIME_DST == 0 || utc < m_base || y >= TIME_YEARS) {
+		return false;
+	}
+	if (m_summerStart[y] < m_summerEnd[y]) {
+		return utc >= m_summerStart[y] && utc < m_summerEnd[y];
+	}
+
+	// southern hemisphere: summer spans the new year
+	return utc >= m_summerStart[y] || utc < m_summerEnd[y];
+}
+
+// Daylight saving starts and ends of every year, in UTC
+void ClockModule::tabulate() {
+	m_base = DateTime(TIME_FIRST_YEAR, 1, 1).unixtime();
+	for (uint16_t y = 0; y < TIME_YEARS; y++) {
+		m_summerStart[y] = transition(TIME_FIRST_YEAR + y, TIME_DST_START_MONTH, TIME_DST_START_WEEK, TIME_DST_START_HOUR) - TIME_ZONE * 60L;
+		m_summerEnd[y] = transition(TIME_FIRST_YEAR + y, TIME_DST_END_MONTH, TIME_DST_END_WEEK, TIME_DST_END_HOUR) - (TIME_ZONE + TIME_DST) * 60L;
+	}
+}
+
+// Local unixtime of the hour on the week-th Sunday of the month, 5 the last
+uint32_t ClockModule::transition(uint16_t year, uint8_t month, uint8_t week, uint8_t hour) const {
+	uint8_t days = monthDays[month - 1] + (month == 2 && year % 4 == 0 && (year % 100 != 0 || year % 400 == 0));
+	uint8_t first = DateTime(year, month, 1).dayOfTheWeek();
+	uint8_t day = 1 + (7 - first) % 7 + (week - 1) * 7;
+
+	while (day > days) {
+		day -= 7;
+	}
+
+	return DateTime(year, month, day, hour).unixtime();
+}
+
+#ifdef THIMO_SIMULATION
+
+ClockModule::ClockModule() :
+	m_base(0),
+	m_millis(0UL),
+	m_epoch(SIM_EPOCH),
+	m_epochMillis(0UL),
+	m_real(0UL) {
+	tabulate();
+}
+
+// Moves the calendar, the millisecond counter keeps running so timers never
+// see time going backwards
+void ClockModule::set(uint32_t local) {
+	Trace.clock(local);
+	m_epoch = local;
+	m_epochMillis = m_millis;
+}
+
+int32_t ClockModule::sync(uint32_t utc, uint16_t ms, unsigned long at) {
+	int32_t offset = (int32_t)(toLocal(utc) - now().unixtime()) * 1000L;
+
+	set(toLocal(utc));
+
+	return offset;
+}
+
+// Catches up with the real time gone by since the last call
+void ClockModule::follow() {
+	unsigned long now = ::millis();
+
+	m_millis += now - m_real;
+	m_real = now;
+}
+
+// Forgets the real time a simulation or a replay took
+void ClockModule::resync() {
+	m_real = ::millis();
+}
+
+#else
+
+ClockModule::ClockModule() :
+	m_base(0),
+	m_anchor(0),
+	m_anchorMillis(0UL),
+	m_synced(0UL),
+	m_measured(0),
+	m_driftLow(-CLOCK_DRIFT_LIMIT),
+	m_driftHigh(CLOCK_DRIFT_LIMIT),
+	m_offset(0) {
+	memset(&m_record, 0, sizeof(m_record));
+	tabulate();
+}
+
+// The drift measured before the reboot, if any, then the RTC
+void ClockModule::begin() {
+#ifdef ESP32
+	Preferences preferences;
+
+	if (preferences.begin("thimo", true)) {
+		if (preferences.getBytes("clock", &m_record, sizeof(m_record)) != sizeof(m_record)) {
+			memset(&m_record, 0, sizeof(m_record));
+		}
+		preferences.end();
+	}
+#endif
+	read();
+}
+
+DateTime ClockModule::now() {
+	uint32_t local;
+
+	if (::millis() - m_synced >= CLOCK_RTC_PERIOD) {
+		read();
+	}
+	local = toLocal(utc());
+	Trace.clock(local);
+
+	return DateTime(local);
+}
+
+// Whole seconds are moved into the anchor well before millis() wraps
+uint32_t ClockModule::utc() {
+	unsigned long elapsed = ::millis() - m_anchorMillis;
+
+	if (elapsed >= 86400000UL) {
+		m_anchor += elapsed / 1000UL;
+		m_anchorMillis += elapsed / 1000UL * 1000UL;
+		elapsed %= 1000UL;
+	}
+
+	return m_anchor + elapsed / 1000UL;
+}
+
+// Set by hand: the drift still applies, but can't be measured from here
+void ClockModule::set(uint32_t local) {
+	uint32_t utc = toUtc(local);
+
+	RTC.adjust(DateTime(utc));
+	m_anchor = utc;
+	m_anchorMillis = ::millis();
+	m_synced = m_anchorMillis;
+	m_record.set = utc;
+	m_record.exact = 0;
+	m_record.phase = 0;
+	save();
+}
+
+// The time was utc seconds and ms milliseconds when millis() was at
+int32_t ClockModule::sync(uint32_t utc, uint16_t ms, unsigned long at) {
+	unsigned long elapsed = at - m_anchorMillis;
+	int32_t seconds = (int32_t)(utc - m_anchor - elapsed / 1000UL);
+
+	if (seconds > 2000000L || seconds < -2000000L) {
+		m_offset = seconds < 0 ? INT32_MIN : INT32_MAX;
+	} else {
+		m_offset = seconds * 1000L + ms - (int32_t)(elapsed % 1000UL);
+	}
+	m_anchor = utc;
+	m_anchorMillis = at - ms;
+	m_synced = at;
+	calibrate(utc, ms);
+
+	return m_offset;
+}
+
+// The RTC reading corrected for the drift and phase since it was set says
+// the time is within a second. The clock stays where it is if it's within
+// it, or moves to its nearest end. When it's off by more, as at boot, it
+// goes to the middle.
+void ClockModule::read() {
+	uint32_t rtc = RTC.now().unixtime();
+	unsigned long now = ::millis();
+	float ahead = m_record.phase * 1e-3f;
+	int32_t low;
+	int64_t clock;
+
+	if (rtc > m_record.set && m_record.set != 0) {
+		ahead += (rtc - m_record.set) * m_record.drift * 1e-6f;
+	}
+	low = -lroundf(ahead * 1000.0f);
+	clock = (int64_t)(int32_t)(m_anchor - rtc) * 1000 + (int64_t)(now - m_anchorMillis);
+	m_synced = now;
+
+	if (clock >= low && clock < low + 1000) {
+		return;
+	}
+	if (clock < low - 1000 || clock >= low + 2000) {
+		clock = low + 500;
+	} else {
+		clock = clock < low ? low : low + 999;
+	}
+
+	int32_t seconds = clock >= 0 ? clock / 1000 : -((999 - clock) / 1000);
+	m_anchor = rtc + seconds;
+	m_anchorMillis = now - (unsigned long)(clock - seconds * 1000LL);
+}
+
+// Against the time server: a reading says by how much the RTC is ahead to
+// within a second, so over the span since it was set exactly, where it was
+// the phase ahead, it bounds the drift. The bounds of every reading since
+// are kept, each one narrows them down; if they rule each other out the
+// drift has changed and they start again. Once the span is a day or more,
+// the middle of them is the drift. The RTC is set again when it's off by
+// too much or was never set exactly, which restarts the measurement.
+void ClockModule::calibrate(uint32_t utc, uint16_t ms) {
+	float ahead = (int32_t)(RTC.now().unixtime() - utc) - ms / 1000.0f;
+	float error = ahead + 0.5f;
+	uint32_t span = utc - m_record.set;
+
+	if (m_record.exact && utc > m_record.set) {
+		float low = (ahead - m_record.phase * 1e-3f) * 1e6f / span;
+		float high = low + 1e6f / span;
+
+		if (low > m_driftHigh || high < m_driftLow) {
+			m_driftLow = low;
+			m_driftHigh = high;
+		} else {
+			if (low > m_driftLow) {
+				m_driftLow = low;
+			}
+			if (high < m_driftHigh) {
+				m_driftHigh = high;
+			}
+		}
+		if (span >= CLOCK_DRIFT_SPAN && utc - m_measured >= CLOCK_DRIFT_SPAN) {
+			m_record.drift = (m_driftLow + m_driftHigh) / 2.0f;
+			m_measured = utc;
+			LOG_INFO(LOG_RTC_DRIFT, (int32_t)(m_record.drift * 1000.0f), (int32_t)error);
+			save();
+		}
+	}
+	if (!m_record.exact || error > CLOCK_RTC_LIMIT || error < -CLOCK_RTC_LIMIT) {
+		RTC.adjust(DateTime(ms >= 500 ? utc + 1 : utc));
+		m_record.set = utc;
+		m_record.exact = 1;
+		m_record.phase = (ms >= 500 ? 1000 : 0) - ms;
+		m_measured = utc;
+		m_driftLow = -CLOCK_DRIFT_LIMIT;
+		m_driftHigh = CLOCK_DRIFT_LIMIT;
+		LOG_INFO(LOG_RTC_SET, (int32_t)error);
+		save();
+	}
+}
+
+void ClockModule::save() {
+#ifdef ESP32
+	Preferences preferences;
+
+	if (!preferences.begin("thimo", false)) {
+		return;
+	}
+	preferences.putBytes("clock", &m_record, sizeof(m_record));
+	preferences.end();
+#endif
+}
+
+#endif
+
+ClockModule Clock;
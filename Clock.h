@@ -0,0 +1,104 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Clock.h
+ * Created on: 19 Oct 2026
+ * Description: Thimo time source
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#ifndef _THIMO_CLOCK_H_
+#define _THIMO_CLOCK_H_
+
+#include <Arduino.h>
+#include "RTC.h"
+#include "config.h"
+
+// What is kept in flash about the DS1307
+struct ClockRecord {
+	uint32_t set;			// UTC the RTC was last set
+	float drift;			// ppm the RTC runs fast, measured against a time server
+	uint8_t exact;			// set by a time server, the drift is measured from then
+	int16_t phase;			// ms the RTC was ahead when set, it only takes whole seconds
+};
+
+// Time as seen by Thimo: sensors, controllers, schedule and views. now() is
+// local time, the time zone and daylight saving rules are turned into a
+// table of transitions at construction, so a conversion is a lookup.
+//
+// On the device the RTC keeps UTC and is only read at boot: from then on
+// the time runs on millis(), corrected by the time server when there is
+// one (see Ntp.h) or by reading the RTC again every CLOCK_RTC_PERIOD when
+// there is none. Each RTC reading is corrected for the drift measured
+// since it was last set, the RTC is written again only when it is off by
+// more than CLOCK_RTC_LIMIT. The RTC only counts seconds: every reading
+// narrows down the drift, and the clock is only moved when a reading
+// rules out the time it keeps. Every local time handed out goes to the
+// trace.
+//
+// With THIMO_SIMULATION it is virtual: it follows real time while idle and
+// is moved forward by the simulator or a trace replay.
+class ClockModule {
+public:
+	ClockModule();
+
+#ifdef THIMO_SIMULATION
+	inline void begin() {}
+	inline unsigned long millis() const { return m_millis; }
+	inline DateTime now() const { return DateTime(m_epoch + (m_millis - m_epochMillis) / 1000UL); }
+	inline uint32_t utc() const { return toUtc(now().unixtime()); }
+	void set(uint32_t local);
+	int32_t sync(uint32_t utc, uint16_t ms, unsigned long at);
+	inline void advance(unsigned long ms) { m_millis += ms; }
+	void follow();
+	void resync();
+#else
+	void begin();
+	inline unsigned long millis() const { return ::millis(); }
+	DateTime now();
+	uint32_t utc();
+	void set(uint32_t local);
+	int32_t sync(uint32_t utc, uint16_t ms, unsigned long at);	// ms the clock moved
+
+	inline const ClockRecord &record() const { return m_record; }
+	inline int32_t offset() const { return m_offset; }	// ms the last sync moved the clock
+	inline unsigned long synced() const { return m_synced; }	// millis() of the last sync or RTC reading
+#endif
+
+	uint32_t toLocal(uint32_t utc) const;
+	uint32_t toUtc(uint32_t local) const;
+	bool summer(uint32_t utc) const;
+private:
+	void tabulate();
+	uint32_t transition(uint16_t year, uint8_t month, uint8_t week, uint8_t hour) const;
+
+	uint32_t m_base;						// UTC at the start of TIME_FIRST_YEAR
+	uint32_t m_summerStart[TIME_YEARS];		// UTC daylight saving starts, per year
+	uint32_t m_summerEnd[TIME_YEARS];
+#ifdef THIMO_SIMULATION
+	unsigned long m_millis;
+	uint32_t m_epoch;			// local unixtime at m_epochMillis
+	unsigned long m_epochMillis;
+	unsigned long m_real;		// millis() when last followed
+#else
+	void read();
+	void calibrate(uint32_t utc, uint16_t ms);
+	void save();
+
+	uint32_t m_anchor;			// UTC at m_anchorMillis
+	unsigned long m_anchorMillis;
+	unsigned long m_synced;
+	uint32_t m_measured;		// UTC of the last drift measurement
+	float m_driftLow;			// ppm the drift is within, from the readings since the RTC was set
+	float m_driftHigh;
+	int32_t m_offset;
+	ClockRecord m_record;
+#endif
+};
+
+extern ClockModule Clock;
+
+#endif
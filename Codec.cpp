@@ -0,0 +1,326 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Codec.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo sample stream codec
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Codec.h"
+
+uint8_t codecPutVarint(uint8_t *dst, uint32_t value) {
+	uint8_t n = 0;
+
+	while (value >= 0x80) {
+		dst[n++] = (uint8_t)value | 0x80;
+		value >>= 7;
+	}
+	dst[n++] = (uint8_t)value;
+
+	return n;
+}
+
+uint8_t codecGetVarint(const uint8_t *src, const uint8_t *end, uint32_t &value) {
+	uint8_t n = 0;
+	uint8_t shift = 0;
+
+	value = 0;
+	while (src + n < end && shift < 35) {
+		uint8_t b = src[n++];
+		value |= (uint32_t)(b & 0x7f) << shift;
+		if (!(b & 0x80)) {
+			return n;
+		}
+		shift += 7;
+	}
+
+	return 0; // truncated or overlong
+}
+
+// CRC-8, polynomial 0x07
+uint8_t crc8(const uint8_t *data, size_t length, uint8_t crc) {
+	while (length--) {
+		crc ^= *data++;
+		for (uint8_t i = 0; i < 8; i++) {
+			crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+		}
+	}
+
+	return crc;
+}
+
+size_t cobsEncode(const uint8_t *src, size_t n, uint8_t *dst) {
+	size_t code = 0;
+	size_t out = 1;
+
+	for (size_t i = 0; i < n; i++) {
+		if (src[i] != 0) {
+			dst[out++] = src[i];
+		}
+		if (src[i] == 0 || out - code == 0xff) {
+			dst[code] = out - code;
+			code = out++;
+		}
+	}
+	dst[code] = out - code;
+
+	return out;
+}
+
+// Returns the decoded length, 0 for a malformed frame. Works in place.
+size_t cobsDecode(const uint8_t *src, size_t n, uint8_t *dst) {
+	size_t in = 0;
+	size_t out = 0;
+
+	while (in < n) {
+		uint8_t code = src[in++];
+		if (code == 0 || in + code - 1 > n) {
+			return 0;
+		}
+		for (uint8_t i = 1; i < code; i++) {
+			dst[out++] = src[in++];
+		}
+		if (code != 0xff && in < n) {
+			dst[out++] = 0;
+		}
+	}
+
+	return out;
+}
+
+SampleEncoder::SampleEncoder() :
+	m_buffer(NULL),
+	m_size(0),
+	m_length(0),
+	m_period(1),
+	m_samples(0),
+	m_run(0),
+	m_started(false) {
+}
+
+void SampleEncoder::begin(uint8_t *buffer, size_t size, uint16_t period) {
+	m_buffer = buffer;
+	m_size = size;
+	m_length = 0;
+	m_period = period ? period : 1;
+	m_samples = 0;
+	m_run = 0;
+	m_started = false;
+}
+
+bool SampleEncoder::push(const Sample &sample) {
+	uint8_t record[CODEC_MAX_RECORD];
+	uint8_t n = 0;
+	uint32_t slots = 0;
+
+	if (m_started && sample.time + m_period / 2 >= m_last.time) {
+		slots = (sample.time - m_last.time + m_period / 2) / m_period;
+		if (slots == 0) {
+			slots = 1; // early sample, keep it in the next slot
+		}
+	}
+
+	if (slots == 0 || slots > 0xffff) {
+		// first sample, clock moved backwards or a long outage: restart from a keyframe
+		n = putRun(record);
+		record[n++] = CODEC_TAG_KEY;
+		n += codecPutVarint(record + n, sample.time);
+		n += codecPutVarint(record + n, codecZigzag(sample.temperature));
+		n += codecPutVarint(record + n, codecZigzag(sample.humidity));
+		n += codecPutVarint(record + n, m_period);
+		if (!commit(record, n)) {
+			return false;
+		}
+		m_run = 0;
+		m_started = true;
+		m_last = sample;
+		m_samples++;
+		return true;
+	}
+
+	int32_t dt = (int32_t)sample.temperature - m_last.temperature;
+	int32_t dh = (int32_t)sample.humidity - m_last.humidity;
+	uint8_t run = 0;
+
+	if (slots == 1 && dt == 0 && dh == 0) {
+		if (m_run == CODEC_MAX_RUN) {
+			// close the full run before opening the next one
+			n = putRun(record);
+			if (!commit(record, n)) {
+				return false;
+			}
+			m_run = 0;
+		}
+		// a pending run costs nothing until it's closed, commit() keeps one byte spare for it
+		m_run++;
+		m_last.time += m_period;
+		m_samples++;
+		return true;
+	}
+
+	n = putRun(record);
+	if (slots > 1) {
+		record[n++] = CODEC_TAG_GAP;
+		n += codecPutVarint(record + n, slots - 1);
+	}
+	if (dt == 0 && dh == 0) {
+		run = 1; // unchanged reading after a gap opens a new run
+	} else if (dt >= -4 && dt <= 3 && dh >= -4 && dh <= 3) {
+		record[n++] = CODEC_TAG_SMALL | ((dt & 0x07) << 3) | (dh & 0x07);
+	} else {
+		record[n++] = CODEC_TAG_DELTA;
+		n += codecPutVarint(record + n, codecZigzag(dt));
+		n += codecPutVarint(record + n, codecZigzag(dh));
+	}
+
+	if (!commit(record, n)) {
+		return false;
+	}
+	m_run = run;
+	m_last.time += slots * m_period;
+	m_last.temperature = sample.temperature;
+	m_last.humidity = sample.humidity;
+	m_samples++;
+
+	return true;
+}
+
+bool SampleEncoder::relay(bool state) {
+	uint8_t record[2];
+	uint8_t n = putRun(record);
+
+	if (!m_started) {
+		return false; // a transition needs a sample to hang on
+	}
+
+	record[n++] = CODEC_TAG_RELAY | (state ? 1 : 0);
+	if (!commit(record, n)) {
+		return false;
+	}
+	m_run = 0;
+
+	return true;
+}
+
+bool SampleEncoder::flush() {
+	uint8_t record[1];
+	uint8_t n = putRun(record);
+
+	if (n == 0) {
+		return true;
+	}
+
+	// the spare byte reserved by commit() guarantees this fits
+	m_buffer[m_length++] = record[0];
+	m_run = 0;
+
+	return true;
+}
+
+bool SampleEncoder::commit(const uint8_t *record, uint8_t n) {
+	// always keep room for the byte closing a pending run
+	if (m_buffer == NULL || m_length + n + 1 > m_size) {
+		return false;
+	}
+
+	memcpy(m_buffer + m_length, record, n);
+	m_length += n;
+
+	return true;
+}
+
+uint8_t SampleEncoder::putRun(uint8_t *dst) {
+	if (m_run == 0) {
+		return 0;
+	}
+
+	dst[0] = CODEC_TAG_RUN | (m_run - 1);
+
+	return 1;
+}
+
+SampleDecoder::SampleDecoder(const uint8_t *buffer, size_t length) :
+	m_pos(buffer),
+	m_end(buffer + length),
+	m_period(1),
+	m_repeat(0),
+	m_error(false) {
+	m_last.time = 0;
+	m_last.temperature = 0;
+	m_last.humidity = 0;
+}
+
+bool SampleDecoder::next(SampleRecord &record) {
+	uint32_t v;
+	uint8_t n;
+
+	while (m_repeat == 0) {
+		if (m_pos >= m_end || m_error) {
+			return false;
+		}
+
+		uint8_t tag = *m_pos++;
+
+		if ((tag & 0xc0) == CODEC_TAG_RUN) {
+			m_repeat = (tag & 0x3f) + 1;
+		} else if ((tag & 0xc0) == CODEC_TAG_SMALL) {
+			// sign extend the two 3 bit fields
+			m_last.temperature += (int8_t)((tag & 0x38) << 2) >> 5;
+			m_last.humidity += (int8_t)((tag & 0x07) << 5) >> 5;
+			m_repeat = 1;
+		} else if (tag == CODEC_TAG_DELTA) {
+			if ((n = codecGetVarint(m_pos, m_end, v)) == 0) break;
+			m_pos += n;
+			m_last.temperature += codecUnzigzag(v);
+			if ((n = codecGetVarint(m_pos, m_end, v)) == 0) break;
+			m_pos += n;
+			m_last.humidity += codecUnzigzag(v);
+			m_repeat = 1;
+		} else if (tag == CODEC_TAG_KEY) {
+			if ((n = codecGetVarint(m_pos, m_end, v)) == 0) break;
+			m_pos += n;
+			m_last.time = v;
+			if ((n = codecGetVarint(m_pos, m_end, v)) == 0) break;
+			m_pos += n;
+			m_last.temperature = codecUnzigzag(v);
+			if ((n = codecGetVarint(m_pos, m_end, v)) == 0) break;
+			m_pos += n;
+			m_last.humidity = codecUnzigzag(v);
+			if ((n = codecGetVarint(m_pos, m_end, v)) == 0) break;
+			m_pos += n;
+			m_period = v ? v : 1;
+			record.type = SampleRecord::SAMPLE;
+			record.sample = m_last;
+			record.relay = false;
+			return true;
+		} else if (tag == CODEC_TAG_GAP) {
+			if ((n = codecGetVarint(m_pos, m_end, v)) == 0) break;
+			m_pos += n;
+			m_last.time += v * m_period;
+		} else if ((tag & 0xfe) == CODEC_TAG_RELAY) {
+			record.type = SampleRecord::RELAY;
+			record.sample = m_last;
+			record.relay = tag & 1;
+			return true;
+		} else {
+			break;
+		}
+	}
+
+	if (m_repeat == 0) {
+		m_error = true;
+		return false;
+	}
+
+	m_repeat--;
+	m_last.time += m_period;
+	record.type = SampleRecord::SAMPLE;
+	record.sample = m_last;
+	record.relay = false;
+
+	return true;
+}
@@ -0,0 +1,112 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Codec.h
+ * Created on: 19 Oct 2026
+ * Description: Thimo sample stream codec
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#ifndef _THIMO_CODEC_H_
+#define _THIMO_CODEC_H_
+
+#include <Arduino.h>
+
+// Stream layout: every record starts with a tag byte.
+//   00nnnnnn                    previous sample repeated n+1 times
+//   01tttHHH                    temperature/humidity deltas in -4..3 (3 bit signed)
+//   10000000 dT dH              zigzag varint deltas
+//   10000001 time T H period    keyframe: varint time, zigzag varints, varint period
+//   10000010 n                  n sampling periods without samples
+//   1000010s                    relay switched to state s
+#define CODEC_TAG_RUN				0x00
+#define CODEC_TAG_SMALL				0x40
+#define CODEC_TAG_DELTA				0x80
+#define CODEC_TAG_KEY				0x81
+#define CODEC_TAG_GAP				0x82
+#define CODEC_TAG_RELAY				0x84
+
+#define CODEC_MAX_RUN				64
+#define CODEC_MAX_RECORD			24		// worst case bytes written by a single push
+
+struct Sample {
+	uint32_t time;			// seconds since epoch
+	int16_t temperature;	// tenths of °C
+	int16_t humidity;		// tenths of %RH
+};
+
+struct SampleRecord {
+	typedef enum {
+		SAMPLE,
+		RELAY
+	} Type;
+
+	Type type;
+	Sample sample;			// for RELAY, the sample the transition follows
+	bool relay;
+};
+
+uint8_t codecPutVarint(uint8_t *dst, uint32_t value);
+uint8_t codecGetVarint(const uint8_t *src, const uint8_t *end, uint32_t &value);
+
+uint8_t crc8(const uint8_t *data, size_t length, uint8_t crc = 0);
+
+// Consistent overhead byte stuffing: the encoded frame contains no zero bytes,
+// so 0x00 can delimit frames on the wire. Encoding needs n + n / 254 + 1 bytes.
+size_t cobsEncode(const uint8_t *src, size_t n, uint8_t *dst);
+size_t cobsDecode(const uint8_t *src, size_t n, uint8_t *dst);
+
+inline uint32_t codecZigzag(int32_t value) {
+	return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+inline int32_t codecUnzigzag(uint32_t value) {
+	return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+class SampleEncoder {
+public:
+	SampleEncoder();
+
+	void begin(uint8_t *buffer, size_t size, uint16_t period);
+	bool push(const Sample &sample);
+	bool relay(bool state);
+	bool flush();
+
+	inline size_t length() const { return m_length; }
+	inline uint16_t samples() const { return m_samples; }
+	inline bool started() const { return m_started; }
+private:
+	bool commit(const uint8_t *record, uint8_t n);
+	uint8_t putRun(uint8_t *dst);
+
+	uint8_t *m_buffer;
+	size_t m_size;
+	size_t m_length;
+	uint16_t m_period;
+	uint16_t m_samples;
+	uint8_t m_run;
+	bool m_started;
+	Sample m_last;
+};
+
+class SampleDecoder {
+public:
+	SampleDecoder(const uint8_t *buffer, size_t length);
+
+	bool next(SampleRecord &record);
+
+	inline bool error() const { return m_error; }
+private:
+	const uint8_t *m_pos;
+	const uint8_t *m_end;
+	uint16_t m_period;
+	uint8_t m_repeat;
+	bool m_error;
+	Sample m_last;
+};
+
+#endif
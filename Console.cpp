@@ -0,0 +1,892 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Console.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo serial console
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Console.h"
+#include "Bench.h"
+#include "Codec.h"
+#include "Ntp.h"
+#include "Power.h"
+#include "Thimo.h"
+
+ConsoleModule::ConsoleModule() :
+	m_inLength(0),
+	m_state(STATE_TEXT),
+	m_outLength(0),
+	m_outPos(0),
+	m_cut(false),
+	m_dumpType(CONSOLE_FRAME_HISTORY),
+	m_dumpBlock(-1),
+	m_dumpOffset(0),
+	m_inputTime(0UL),
+	m_frames(0),
+	m_errors(0),
+	m_zone(0),
+	m_listing(LIST_NONE),
+	m_listLine(0),
+	m_bench(-1),
+	m_benchMode(BENCH_PRINT),
+	m_regressions(0) {
+}
+
+// Never blocks: input is parsed as it arrives, output only goes out as far
+// as the UART transmit FIFO has room, and a new request is only taken once
+// the previous response has been sent completely.
+void ConsoleModule::poll(HardwareSerial &io) {
+	flush(io);
+	if (m_outPos < m_outLength) {
+		return;
+	}
+	m_outPos = m_outLength = 0;
+	m_cut = false;
+
+	if (m_dumpBlock >= 0) {
+		sendBlocks();
+	} else if (m_listing != LIST_NONE) {
+		printList();
+	} else if (m_bench >= 0) {
+		printBench();
+	} else {
+		for (int i = 0; i < CONSOLE_POLL_BYTES && io.available() > 0; i++) {
+			m_inputTime = millis();
+			receive(io.read());
+			if (m_outLength > 0) {
+				break;
+			}
+		}
+	}
+
+	flush(io);
+}
+
+// What doesn't fit is dropped, the response then ends with a marker
+size_t ConsoleModule::write(uint8_t c) {
+	static const char cut[] = " [cut]\r\n";
+
+	if (m_outLength >= CONSOLE_OUT_SIZE - (sizeof(cut) - 1)) {
+		if (!m_cut) {
+			memcpy(m_out + m_outLength, cut, sizeof(cut) - 1);
+			m_outLength += sizeof(cut) - 1;
+			m_cut = true;
+		}
+		return 0;
+	}
+	m_out[m_outLength++] = c;
+
+	return 1;
+}
+
+void ConsoleModule::flush(HardwareSerial &io) {
+	size_t n = m_outLength - m_outPos;
+	int room = io.availableForWrite();
+
+	if (room <= 0 || n == 0) {
+		return;
+	}
+	if (n > (size_t)room) {
+		n = room;
+	}
+	io.write(m_out + m_outPos, n);
+	m_outPos += n;
+}
+
+void ConsoleModule::receive(uint8_t c) {
+	switch (m_state) {
+		case STATE_TEXT:
+			if (c == 0) {
+				// frame delimiter: drop any partial text line
+				m_inLength = 0;
+				m_state = STATE_FRAME;
+			} else if (c == '\n') {
+				m_in[m_inLength] = 0;
+				execute((char *)m_in);
+				m_inLength = 0;
+			} else if (c != '\r') {
+				if (m_inLength < CONSOLE_LINE_SIZE - 1) {
+					m_in[m_inLength++] = c;
+				} else {
+					m_inLength = 0;
+					m_errors++;
+					m_state = STATE_DISCARD;
+				}
+			}
+			break;
+		case STATE_FRAME:
+			if (c == 0) {
+				if (m_inLength > 0) {
+					dispatch(m_in, m_inLength);
+					m_inLength = 0;
+					m_state = STATE_TEXT;
+				}
+			} else if (m_inLength < CONSOLE_FRAME_SIZE) {
+				m_in[m_inLength++] = c;
+			} else {
+				m_inLength = 0;
+				m_errors++;
+				m_state = STATE_DISCARD;
+			}
+			break;
+		case STATE_DISCARD:
+			// resynchronize on the next line or frame boundary
+			if (c == '\n') {
+				print("error: line too long\r\n");
+				m_state = STATE_TEXT;
+			} else if (c == 0) {
+				m_state = STATE_FRAME;
+			}
+			break;
+	}
+}
+
+void ConsoleModule::execute(char *line) {
+	char *save;
+	char *cmd = strtok_r(line, " ", &save);
+	char *arg = strtok_r(NULL, " ", &save);
+
+	if (cmd == NULL) {
+		return;
+	}
+
+	if (!strcmp(cmd, "help")) {
+		print("stat | zones | zone [n] | views | tt [hour temp] | mode [auto|manual [temp]] | ctl [hyst|pid] | time [yyyy mm dd hh mm ss] | trace | wdt | model | meter | power | cpu [80|160|240|auto] | bench [cmp|save] | ovr [cmd]");
+#ifdef THIMO_SIMULATION
+		print(" | sim days [hyst|pid] | replay");
+#endif
+		print("\r\n");
+	} else if (!strcmp(cmd, "stat")) {
+		printStatus();
+	} else if (!strcmp(cmd, "zones")) {
+		m_listing = LIST_ZONES;
+		m_listLine = 0;
+		printList();
+	} else if (!strcmp(cmd, "zone")) {
+		// selects the zone tt, mode and stat refer to
+		if (arg != NULL) {
+			int z = atoi(arg);
+			if (z < 0 || z >= ZONE_COUNT) {
+				print("error: zone <0-");
+				print(ZONE_COUNT - 1);
+				print(">\r\n");
+				return;
+			}
+			m_zone = z;
+		}
+		print("zone ");
+		print(m_zone);
+		print("\r\n");
+	} else if (!strcmp(cmd, "views")) {
+		printViews();
+	} else if (!strcmp(cmd, "tt")) {
+		if (arg != NULL) {
+			char *value = strtok_r(NULL, " ", &save);
+			if (value == NULL || !Thimo.timetable(m_zone, atoi(arg), atoi(value))) {
+				print("error: tt <0-23> <0-30>\r\n");
+				return;
+			}
+		}
+		printTimetable();
+	} else if (!strcmp(cmd, "mode")) {
+		if (arg != NULL) {
+			if (!strcmp(arg, "auto")) {
+				Thimo.manualMode(m_zone, false);
+			} else if (!strcmp(arg, "manual")) {
+				char *value = strtok_r(NULL, " ", &save);
+				if (value != NULL && !Thimo.manualSetpoint(m_zone, (int16_t)lroundf(atof(value) * 10.0f))) {
+					print("error: mode manual <0-30>\r\n");
+					return;
+				}
+				Thimo.manualMode(m_zone, true);
+			} else {
+				print("error: mode auto|manual [temp]\r\n");
+				return;
+			}
+		}
+		print(Thimo.manualMode(m_zone) ? "manual " : "auto ");
+		print(Thimo.manualSetpoint(m_zone) / 10.0f, 1);
+		print("\r\n");
+	} else if (!strcmp(cmd, "ctl")) {
+		if (arg != NULL) {
+			if (!strcmp(arg, "hyst")) {
+				Thimo.controlMode(m_zone, Controller::HYSTERESIS);
+			} else if (!strcmp(arg, "pid")) {
+				Thimo.controlMode(m_zone, Controller::PID);
+			} else {
+				print("error: ctl hyst|pid\r\n");
+				return;
+			}
+		}
+		const Controller &controller = Thimo.zone(m_zone).controller;
+		print(controller.mode() == Controller::PID ? "pid duty " : "hyst duty ");
+		print(controller.duty() / 10);
+		print("% cycles ");
+		print(controller.cycles());
+		print("\r\n");
+	} else if (!strcmp(cmd, "time")) {
+		if (arg != NULL) {
+			int v[6] = { atoi(arg), 0, 0, 0, 0, 0 };
+			for (int i = 1; i < 6; i++) {
+				char *p = strtok_r(NULL, " ", &save);
+				if (p == NULL) {
+					print("error: time yyyy mm dd hh mm ss\r\n");
+					return;
+				}
+				v[i] = atoi(p);
+			}
+			Clock.set(DateTime(v[0], v[1], v[2], v[3], v[4], v[5]).unixtime());
+		}
+		printTime();
+	} else if (!strcmp(cmd, "ovr")) {
+		// the rest of the line is the override, see ThimoClass::override()
+		if (arg != NULL) {
+			char command[CONSOLE_LINE_SIZE];
+			snprintf(command, sizeof(command), "%s %s", arg, save != NULL ? save : "");
+			if (!Thimo.override(m_zone, command)) {
+				print("error: ovr boost|hold|away|holiday|clear ...\r\n");
+				return;
+			}
+		}
+		printOverrides();
+	} else if (!strcmp(cmd, "trace")) {
+		printTrace();
+	} else if (!strcmp(cmd, "wdt")) {
+		printWatchdog();
+	} else if (!strcmp(cmd, "model")) {
+		printModel();
+	} else if (!strcmp(cmd, "meter")) {
+		printMeter();
+	} else if (!strcmp(cmd, "power")) {
+		printPower();
+	} else if (!strcmp(cmd, "cpu")) {
+		// fixes the CPU frequency to measure at it, auto hands it back to the governor
+		if (arg != NULL) {
+			int mhz = atoi(arg);
+			if (!strcmp(arg, "auto")) {
+				Power.pin(-1);
+			} else if (mhz == 80 || mhz == 160 || mhz == 240) {
+				Power.pin(mhz / 80 - 1);
+			} else {
+				print("error: cpu 80|160|240|auto\r\n");
+				return;
+			}
+		}
+		printCpu();
+	} else if (!strcmp(cmd, "bench")) {
+		if (arg == NULL) {
+			m_benchMode = BENCH_PRINT;
+		} else if (!strcmp(arg, "cmp")) {
+			m_benchMode = BENCH_COMPARE;
+		} else if (!strcmp(arg, "save")) {
+			m_benchMode = BENCH_SAVE;
+		} else {
+			print("error: bench [cmp|save]\r\n");
+			return;
+		}
+		m_bench = 0;
+		m_regressions = 0;
+		printBench();
+#ifdef THIMO_SIMULATION
+	} else if (!strcmp(cmd, "sim")) {
+		// the control mode, when given, applies to every zone
+		char *mode = strtok_r(NULL, " ", &save);
+		int days = arg != NULL ? atoi(arg) : 0;
+		if (days < 1 || days > 3650 || (mode != NULL && strcmp(mode, "hyst") && strcmp(mode, "pid"))) {
+			print("error: sim <1-3650> [hyst|pid]\r\n");
+			return;
+		}
+		for (uint8_t z = 0; mode != NULL && z < ZONE_COUNT; z++) {
+			Thimo.controlMode(z, strcmp(mode, "pid") ? Controller::HYSTERESIS : Controller::PID);
+		}
+		Simulator.run(days);
+		m_listing = LIST_SIMULATION;
+		m_listLine = 0;
+		printList();
+	} else if (!strcmp(cmd, "replay")) {
+		Trace.replay();
+		print(Trace.replayed());
+		print(" records in ");
+		print(Trace.replayTime());
+		print(" ms ");
+		print(Trace.replayTime() ? Trace.replayed() * 1000UL / Trace.replayTime() : 0UL);
+		print("/s relay errors ");
+		print(Trace.relayErrors());
+		print(" display errors ");
+		print(Trace.displayErrors());
+		print(Trace.exact() ? "\r\n" : " (no boot state, not exact)\r\n");
+#endif
+	} else {
+		print("error: unknown command\r\n");
+	}
+}
+
+void ConsoleModule::dispatch(uint8_t *frame, size_t n) {
+	n = cobsDecode(frame, n, frame);
+	if (n < 2 || crc8(frame, n - 1) != frame[n - 1]) {
+		m_errors++;
+		sendError(n > 0 ? frame[0] : 0, ERROR_CRC);
+		return;
+	}
+	n--; // strip CRC
+	m_frames++;
+
+	uint8_t reply[1 + 24];
+	reply[0] = frame[0];
+
+	switch (frame[0]) {
+		case CONSOLE_FRAME_PING:
+			reply[1] = CONSOLE_VERSION;
+			sendFrame(reply, 2);
+			break;
+		case CONSOLE_FRAME_GET_TIMETABLE:
+			// the zone byte is optional, zone 0 without it
+			if (n > 2) {
+				sendError(frame[0], ERROR_LENGTH);
+			} else if (n == 2 && frame[1] >= ZONE_COUNT) {
+				sendError(frame[0], ERROR_VALUE);
+			} else {
+				for (int h = 0; h < 24; h++) {
+					reply[1 + h] = Thimo.timetable(n == 2 ? frame[1] : 0, h);
+				}
+				sendFrame(reply, 1 + 24);
+			}
+			break;
+		case CONSOLE_FRAME_SET_TIMETABLE:
+			if (n != 1 + 24 && n != 2 + 24) {
+				sendError(frame[0], ERROR_LENGTH);
+			} else if (!Thimo.timetable(n == 2 + 24 ? frame[1] : 0, frame + n - 24)) {
+				sendError(frame[0], ERROR_VALUE);
+			} else {
+				sendFrame(reply, 1);
+			}
+			break;
+		case CONSOLE_FRAME_HISTORY:
+		case CONSOLE_FRAME_TRACE:
+			m_dumpType = frame[0];
+			m_dumpBlock = 0;
+			m_dumpOffset = 0;
+			sendBlocks();
+			break;
+#ifdef THIMO_SIMULATION
+		case CONSOLE_FRAME_TRACE_LOAD:
+			if (n < 4) {
+				sendError(frame[0], ERROR_LENGTH);
+			} else if (!Trace.load(frame[1], frame[2] | (frame[3] << 8), frame + 4, n - 4)) {
+				sendError(frame[0], ERROR_VALUE);
+			} else {
+				sendFrame(reply, 1);
+			}
+			break;
+#endif
+		case CONSOLE_FRAME_COUNTERS:
+			sendCounters();
+			break;
+		case CONSOLE_FRAME_METER:
+			if (n != 3 && n != 4) {
+				sendError(frame[0], ERROR_LENGTH);
+			} else if (frame[1] >= ZONE_COUNT || frame[2] > MeterModule::MONTH + 1) {
+				sendError(frame[0], ERROR_VALUE);
+			} else {
+				sendMeter(frame[1], frame[2], n == 4 ? frame[3] : 0);
+			}
+			break;
+		default:
+			sendError(frame[0], ERROR_UNKNOWN);
+	}
+}
+
+void ConsoleModule::sendFrame(const uint8_t *payload, size_t n) {
+	uint8_t frame[1 + CONSOLE_CHUNK_SIZE + 8];
+
+	if (n + 1 > sizeof(frame) || m_outLength + n + n / 254 + 4 > CONSOLE_OUT_SIZE) {
+		return;
+	}
+
+	memcpy(frame, payload, n);
+	frame[n] = crc8(payload, n);
+	m_out[m_outLength++] = 0;
+	m_outLength += cobsEncode(frame, n + 1, m_out + m_outLength);
+	m_out[m_outLength++] = 0;
+}
+
+void ConsoleModule::sendError(uint8_t type, Status status) {
+	uint8_t reply[3] = { CONSOLE_FRAME_ERROR, type, (uint8_t)status };
+
+	sendFrame(reply, sizeof(reply));
+}
+
+// One chunk per call: the dump is paced by poll() so it never holds the loop
+void ConsoleModule::sendBlocks() {
+	uint8_t reply[4 + CONSOLE_CHUNK_SIZE];
+	size_t length;
+
+	Power.boost();
+	unsigned long start = micros();
+	const uint8_t *data = m_dumpType == CONSOLE_FRAME_TRACE ? Trace.block(m_dumpBlock, length) : History.block(m_dumpBlock, length);
+
+	reply[0] = m_dumpType;
+	if (data == NULL) {
+		reply[1] = 0xff;
+		sendFrame(reply, 2);
+		m_dumpBlock = -1;
+		return;
+	}
+
+	size_t n = length - m_dumpOffset;
+	if (n > CONSOLE_CHUNK_SIZE) {
+		n = CONSOLE_CHUNK_SIZE;
+	}
+	reply[1] = m_dumpBlock;
+	reply[2] = (uint8_t)m_dumpOffset;
+	reply[3] = (uint8_t)(m_dumpOffset >> 8);
+	memcpy(reply + 4, data + m_dumpOffset, n);
+	sendFrame(reply, 4 + n);
+
+	m_dumpOffset += n;
+	if (m_dumpOffset >= length) {
+		m_dumpBlock++;
+		m_dumpOffset = 0;
+	}
+	Power.measure(PowerModule::TASK_EXPORT, micros() - start);
+}
+
+void ConsoleModule::sendCounters() {
+	uint8_t reply[1 + 11 * 5];
+	size_t n = 0;
+
+	reply[n++] = CONSOLE_FRAME_COUNTERS;
+	n += codecPutVarint(reply + n, millis());
+	n += codecPutVarint(reply + n, History.samples());
+	n += codecPutVarint(reply + n, History.bytes());
+	n += codecPutVarint(reply + n, Log.written());
+	n += codecPutVarint(reply + n, Log.dropped());
+	n += codecPutVarint(reply + n, m_frames);
+	n += codecPutVarint(reply + n, m_errors);
+	n += codecPutVarint(reply + n, Boot.elapsed(BootModule::STEP_CONTROL));
+	n += codecPutVarint(reply + n, Watchdog.stalls());
+	n += codecPutVarint(reply + n, Watchdog.stalledSection());
+	n += codecPutVarint(reply + n, Watchdog.stalledFor());
+	sendFrame(reply, n);
+}
+
+// A period past the ring, or the totals after the last period
+void ConsoleModule::sendMeter(uint8_t z, uint8_t period, uint8_t ago) {
+	uint8_t reply[1 + 3 * 5];
+	size_t n = 0;
+
+	reply[n++] = CONSOLE_FRAME_METER;
+	if (period > MeterModule::MONTH) {
+		const MeterZone &zone = Meter.zone(z);
+		n += codecPutVarint(reply + n, zone.onTime);
+		n += codecPutVarint(reply + n, zone.cycles);
+		n += codecPutVarint(reply + n, zone.shortCycles);
+	} else {
+		const MeterCounter &counter = Meter.counter(z, (MeterModule::Period)period, ago);
+		n += codecPutVarint(reply + n, counter.onTime);
+		n += codecPutVarint(reply + n, counter.cycles);
+		n += codecPutVarint(reply + n, counter.shortCycles);
+	}
+	sendFrame(reply, n);
+}
+
+void ConsoleModule::printStatus() {
+	print("zone ");
+	print(m_zone);
+	print(" T ");
+	print(Thimo.temperature(m_zone), 1);
+	print(" H ");
+	print(Thimo.humidity(m_zone), 1);
+	print(" relay ");
+	print(Thimo.relay(m_zone) ? "on" : "off");
+	print(Thimo.manualMode(m_zone) ? " manual" : " auto");
+	print(" samples ");
+	print(History.samples());
+	print(" bytes ");
+	print((unsigned long)History.bytes());
+	print(" dropped ");
+	print(Log.dropped());
+	print(" cgram ");
+	print(Glyph.uploadsPerMinute());
+	print("/min\r\n");
+}
+
+// One line of a multi-zone listing per poll, so that any number of zones
+// fits the output buffer
+void ConsoleModule::printList() {
+	switch (m_listing) {
+		case LIST_ZONES:
+			if (m_listLine < ZONE_COUNT) {
+				printZone(m_listLine);
+			} else {
+				printControl();
+			}
+			break;
+#ifdef THIMO_SIMULATION
+		case LIST_SIMULATION:
+			if (m_listLine == 0) {
+				printSimulation();
+			} else {
+				printRoom(m_listLine - 1);
+			}
+			break;
+#endif
+		default:
+			break;
+	}
+
+	if (++m_listLine > ZONE_COUNT) {
+		m_listing = LIST_NONE;
+	}
+}
+
+void ConsoleModule::printZone(uint8_t z) {
+	const Zone &zone = Thimo.zone(z);
+
+	print(z);
+	print(z == Thimo.shownZone() ? "* " : "  ");
+	print(zone.temperature, 1);
+	print(zone.relay ? " on " : " off ");
+	print(zone.controller.duty() / 10);
+	print("% ");
+	print(zone.controller.cycles());
+	print(" cycles");
+	if (zone.window.open()) {
+		print(" window");
+	}
+	print(zone.manualMode ? " manual\r\n" : " auto\r\n");
+}
+
+void ConsoleModule::printControl() {
+	uint32_t count = Thimo.controlCount();
+
+	print(count);
+	print(" control passes ");
+	print(count ? (uint32_t)((uint64_t)Thimo.controlTime() * 1000ULL / count) : 0UL);
+	print(" ns\r\n");
+}
+
+#ifdef THIMO_SIMULATION
+// The run, then per zone heater energy, mean deviation from the setpoint and
+// degree-hours too cold over the hours with a setpoint, relay switches
+void ConsoleModule::printSimulation() {
+	uint32_t passes = Simulator.passes();
+
+	print(Simulator.days());
+	print(" days in ");
+	print(Simulator.runTime() / 1000.0f, 1);
+	print(" s, ");
+	print(passes);
+	print(" control passes ");
+	print(passes ? (uint32_t)((uint64_t)Simulator.passTime() * 1000ULL / passes) : 0UL);
+	print(" ns\r\n");
+}
+
+void ConsoleModule::printRoom(uint8_t z) {
+	const Room &room = Simulator.room(z);
+
+	print(z);
+	print(" ");
+	print(room.energy / 1000.0f, 1);
+	print(" kWh dev ");
+	print(room.occupied > 0.0f ? room.deviation / room.occupied : 0.0f, 2);
+	print(" C cold ");
+	print(room.cold, 1);
+	print(" Kh ");
+	print(room.switches);
+	print(" switches, windows ");
+	print(room.windows);
+	print(" missed ");
+	print(room.windows - room.detected);
+	print(" false ");
+	print(room.falseAlarms);
+	print(" wasted ");
+	print(room.wasted / 1000.0f, 1);
+	print(" kWh\r\n");
+}
+#endif
+
+void ConsoleModule::printTrace() {
+	print(Trace.records());
+	print(" records ");
+	print((unsigned long)Trace.bytes());
+	print(" bytes in ");
+	print(Trace.blocks());
+	print(" blocks\r\n");
+}
+
+void ConsoleModule::printWatchdog() {
+	print(Watchdog.stalls());
+	print(" stalls, last ");
+	print(WatchdogModule::name(Watchdog.stalledSection()));
+	print(" ");
+	print(Watchdog.stalledFor());
+	print(Watchdog.stalled() ? " ms, reset by it\r\n" : " ms\r\n");
+}
+
+// Parameters and prediction error of the zone's thermal model, the last
+// measured heating rate with its prediction, and the setpoint the preheat
+// turns the scheduled one into
+void ConsoleModule::printModel() {
+	const Zone &zone = Thimo.zone(m_zone);
+	const ThermalModel &model = zone.model;
+	DateTime now = Clock.now();
+
+	print("zone ");
+	print(m_zone);
+	print(model.ready() ? " updates " : " learning, updates ");
+	print(model.updates());
+	print(" gain ");
+	print(model.gain(), 2);
+	print(" loss ");
+	print(model.loss(), 3);
+	print(" drift ");
+	print(model.drift(), 2);
+	print(" C/h, rms error ");
+	print(model.error(), 2);
+	print(" last ");
+	print(model.measured(), 2);
+	print(" predicted ");
+	print(model.predicted(), 2);
+	print(" C/h, setpoint ");
+	print(Thimo.setpoint(m_zone, now.hour()) / 10.0f, 1);
+	print(" target ");
+	print(Thimo.target(m_zone, now) / 10.0f, 1);
+	print("\r\n");
+}
+
+// Burner time, starts and short starts of the zone this hour, today and
+// this month, the duty over the last 24 hours and the energy so far
+void ConsoleModule::printMeter() {
+	const MeterZone &zone = Meter.zone(m_zone);
+	const MeterCounter &hour = Meter.counter(m_zone, MeterModule::HOUR);
+	const MeterCounter &day = Meter.counter(m_zone, MeterModule::DAY);
+	const MeterCounter &month = Meter.counter(m_zone, MeterModule::MONTH);
+
+	print("zone ");
+	print(m_zone);
+	print(" hour ");
+	print(hour.onTime);
+	print(" s ");
+	print(hour.cycles);
+	print(" starts, day ");
+	print(day.onTime / 3600.0f, 2);
+	print(" h ");
+	print(day.cycles);
+	print(" starts ");
+	print(day.shortCycles);
+	print(" short, month ");
+	print(month.onTime / 3600.0f, 1);
+	print(" h ");
+	print(month.cycles);
+	print(" starts ");
+	print(month.shortCycles);
+	print(" short ");
+	print(MeterModule::energy(month.onTime), 1);
+	print(" kWh, duty ");
+	print(Meter.onTime(m_zone, MeterModule::HOUR) / 864.0f, 1);
+	print("%, total ");
+	print(zone.onTime / 3600.0f, 1);
+	print(" h ");
+	print(zone.cycles);
+	print(" starts ");
+	print(MeterModule::energy(zone.onTime), 1);
+	print(" kWh\r\n");
+}
+
+static const char *const taskNames[PowerModule::TASK_COUNT] = { " render ", " control ", " export " };
+
+void ConsoleModule::printPower() {
+	uint32_t asleep = Power.sleepTime();
+	uint32_t awake = Power.awakeTime();
+
+	print("asleep ");
+	print(asleep + awake ? asleep * 100.0f / (asleep + awake) : 0.0f, 1);
+	print("% awake ");
+	print(awake / 1000UL);
+	print(" s, ");
+	print(Power.sleeps());
+	print(" sleeps woken by timer ");
+	print(Power.wakeups(PowerModule::WAKE_TIMER));
+	print(" button ");
+	print(Power.wakeups(PowerModule::WAKE_BUTTON));
+	print(" serial ");
+	print(Power.wakeups(PowerModule::WAKE_SERIAL));
+	print(" other ");
+	print(Power.wakeups(PowerModule::WAKE_OTHER));
+	print(", button latency ");
+	print(Power.latency());
+	print(" ms max\r\n");
+	print(Power.energy(), 2);
+	print(" mWh, ");
+	print(asleep + awake ? Power.energy() * 3600000.0f / (asleep + awake) : 0.0f, 1);
+	print(" mWh/h\r\n");
+}
+
+// Per level: time spent at it, its draw and the average cost of each task
+void ConsoleModule::printCpu() {
+	print(PowerModule::mhz(Power.level()));
+	print(Power.pinned() ? " MHz pinned, " : " MHz governed, ");
+	print(Power.switches());
+	print(" switches\r\n");
+	for (uint8_t l = 0; l < PowerModule::LEVEL_COUNT; l++) {
+		PowerModule::Level level = (PowerModule::Level)l;
+		print(PowerModule::mhz(level));
+		print(level == Power.level() ? "* " : "  ");
+		print(Power.levelTime(level) / 1000UL);
+		print(" s ");
+		print(PowerModule::current(level) * POWER_VOLTAGE, 0);
+		print(" mW");
+		for (uint8_t t = 0; t < PowerModule::TASK_COUNT; t++) {
+			uint32_t count = Power.taskCount(level, (PowerModule::Task)t);
+			print(taskNames[t]);
+			print(count ? Power.taskTime(level, (PowerModule::Task)t) / count : 0UL);
+		}
+		print(" us\r\n");
+	}
+}
+
+// One JSON object per line and per poll, each case runs for a few ms. The
+// last line sums up, in compare mode with the number of regressions; in
+// save mode the baselines go to flash then, all at once.
+void ConsoleModule::printBench() {
+	BenchResult result;
+
+	if (m_bench >= Bench.cases()) {
+		print("{\"cases\":");
+		print(m_bench);
+		if (m_benchMode == BENCH_COMPARE) {
+			print(",\"regressions\":");
+			print(m_regressions);
+		}
+		print("}\r\n");
+		if (m_benchMode == BENCH_SAVE) {
+			Bench.store();
+		}
+		m_bench = -1;
+		return;
+	}
+
+	Bench.run(m_bench, result);
+	print("{\"case\":\"");
+	print(result.name);
+	print("\",\"n\":");
+	print(result.iterations);
+	print(",\"cycles\":");
+	print(result.cycles);
+	if (result.bytes > 0) {
+		print(",\"bytes\":");
+		print(result.bytes);
+		print(",\"transactions\":");
+		print(result.transactions);
+	}
+	if (m_benchMode == BENCH_COMPARE) {
+		bool regression = BenchModule::regression(result);
+		print(",\"baseline\":");
+		if (result.baseline > 0) {
+			print(result.baseline);
+		} else {
+			print("null");
+		}
+		print(",\"regression\":");
+		print(regression ? "true" : "false");
+		if (regression) {
+			m_regressions++;
+		}
+	} else if (m_benchMode == BENCH_SAVE) {
+		Bench.save(m_bench, result);
+	}
+	print("}\r\n");
+	m_bench++;
+}
+
+void ConsoleModule::printViews() {
+	for (int v = 0; v < VIEW_COUNT; v++) {
+		uint32_t count = Thimo.renderCount(v);
+		print(v);
+		print(v == Thimo.view() ? "* " : "  ");
+		print(count);
+		print(" renders ");
+		print(count ? Thimo.renderTime(v) / count : 0UL);
+		print(" us\r\n");
+	}
+}
+
+void ConsoleModule::printTimetable() {
+	for (int h = 0; h < 24; h++) {
+		if (h < 10) {
+			print("0");
+		}
+		print(h);
+		print(":");
+		print(Thimo.timetable(m_zone, h));
+		print(h % 6 == 5 ? "\r\n" : " ");
+	}
+}
+
+// One line per override: the zones as a mask, the setpoint, when it
+// starts if it hasn't yet and when it ends
+void ConsoleModule::printOverrides() {
+	uint32_t now = Clock.now().unixtime();
+	char buf[24];
+
+	for (uint8_t i = 0; i < Overrides.count(); i++) {
+		const Override &entry = Overrides.entry(i);
+		DateTime start(entry.start);
+		DateTime end(entry.end);
+
+		print(OverrideModule::name(entry.kind));
+		print(" ");
+		print(entry.zones);
+		print(" ");
+		print(entry.setpoint / 10.0f, 1);
+		if (entry.start > now) {
+			snprintf(buf, sizeof(buf), " %02u/%02u %02u:%02u", start.day(), start.month(), start.hour(), start.minute());
+			print(buf);
+		}
+		if (entry.end == OVERRIDE_FOREVER) {
+			print(" -");
+		} else {
+			snprintf(buf, sizeof(buf), " %02u/%02u %02u:%02u", end.day(), end.month(), end.hour(), end.minute());
+			print(" -");
+			print(buf);
+		}
+		print("\r\n");
+	}
+	print(Overrides.count());
+	print(" overrides\r\n");
+}
+
+void ConsoleModule::printTime() {
+	char buf[40];
+	DateTime now = Clock.now();
+
+	snprintf(buf, sizeof(buf), "%04u-%02u-%02u %02u:%02u:%02u %s\r\n",
+		now.year(), now.month(), now.day(), now.hour(), now.minute(), now.second(),
+		Clock.summer(Clock.utc()) ? "summer" : "standard");
+	print(buf);
+#ifndef THIMO_SIMULATION
+	const ClockRecord &record = Clock.record();
+
+	print("ntp syncs ");
+	print(Ntp.syncs());
+	print(" failures ");
+	print(Ntp.failures());
+	print(" offset ");
+	print(Clock.offset());
+	print(" ms delay ");
+	print(Ntp.delay());
+	print(" ms\r\nrtc drift ");
+	print(record.drift, 3);
+	print(" ppm set ");
+	print(record.set);
+	print(record.exact ? " by ntp\r\n" : " by hand\r\n");
+#endif
+}
+
+ConsoleModule Console;
@@ -0,0 +1,136 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Console.h
+ * Created on: 19 Oct 2026
+ * Description: Thimo serial console
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#ifndef _THIMO_CONSOLE_H_
+#define _THIMO_CONSOLE_H_
+
+#include <Arduino.h>
+#include "config.h"
+
+// Text mode: newline terminated commands, type "help" for the list.
+//
+// Binary mode: 0x00 delimited COBS frames. A frame carries a type byte, the
+// payload and a CRC-8 of both; every request is answered with a frame of the
+// same type, or CONSOLE_FRAME_ERROR followed by the request type and a code.
+//
+//   PING           -> PING version
+//   GET_TIMETABLE [zone] -> GET_TIMETABLE 24 x temperature
+//   SET_TIMETABLE [zone] 24 x temperature -> SET_TIMETABLE
+//   HISTORY        -> HISTORY block offset(le16) data ... then HISTORY 0xff
+//   TRACE          -> TRACE block offset(le16) data ... then TRACE 0xff
+//   TRACE_LOAD block offset(le16) data -> TRACE_LOAD (THIMO_SIMULATION only)
+//   COUNTERS       -> COUNTERS varint counters (see sendCounters())
+//   METER zone period [ago] -> METER varint on time(s) starts short starts,
+//                     period 0 hour, 1 day, 2 month, 3 total; ago 0 is the current one
+#define CONSOLE_FRAME_PING			0x01
+#define CONSOLE_FRAME_GET_TIMETABLE	0x10
+#define CONSOLE_FRAME_SET_TIMETABLE	0x11
+#define CONSOLE_FRAME_HISTORY		0x20
+#define CONSOLE_FRAME_TRACE			0x21
+#define CONSOLE_FRAME_TRACE_LOAD	0x22
+#define CONSOLE_FRAME_COUNTERS		0x30
+#define CONSOLE_FRAME_METER			0x31
+#define CONSOLE_FRAME_ERROR			0x7f
+
+#define CONSOLE_VERSION				1
+#define CONSOLE_CHUNK_SIZE			48		// history bytes per frame
+
+class ConsoleModule : public Print {
+public:
+	typedef enum {
+		ERROR_NONE = 0,
+		ERROR_CRC,
+		ERROR_UNKNOWN,
+		ERROR_LENGTH,
+		ERROR_VALUE
+	} Status;
+
+	ConsoleModule();
+
+	void poll(HardwareSerial &io);
+	inline bool idle() const { return m_outPos == m_outLength && m_dumpBlock < 0 && m_bench < 0 && m_listing == LIST_NONE; }
+	inline unsigned long quiet() const { return millis() - m_inputTime; }	// ms since the last input
+
+	virtual size_t write(uint8_t);
+	using Print::write;
+private:
+	typedef enum {
+		STATE_TEXT,
+		STATE_FRAME,
+		STATE_DISCARD
+	} State;
+
+	typedef enum {
+		LIST_NONE,
+		LIST_ZONES,
+		LIST_SIMULATION
+	} Listing;
+
+	typedef enum {
+		BENCH_PRINT,
+		BENCH_COMPARE,		// against the stored baseline
+		BENCH_SAVE			// as the new baseline
+	} BenchMode;
+
+	void flush(HardwareSerial &io);
+	void receive(uint8_t c);
+	void execute(char *line);
+	void dispatch(uint8_t *frame, size_t n);
+	void sendFrame(const uint8_t *payload, size_t n);
+	void sendError(uint8_t type, Status status);
+	void sendCounters();
+	void sendMeter(uint8_t z, uint8_t period, uint8_t ago);
+	void sendBlocks();
+	void printStatus();
+	void printList();
+	void printZone(uint8_t z);
+	void printControl();
+	void printViews();
+	void printTimetable();
+	void printOverrides();
+	void printTime();
+	void printTrace();
+	void printWatchdog();
+	void printModel();
+	void printMeter();
+	void printPower();
+	void printCpu();
+	void printBench();
+#ifdef THIMO_SIMULATION
+	void printSimulation();
+	void printRoom(uint8_t z);
+#endif
+
+	uint8_t m_in[CONSOLE_FRAME_SIZE > CONSOLE_LINE_SIZE ? CONSOLE_FRAME_SIZE : CONSOLE_LINE_SIZE];
+	size_t m_inLength;
+	State m_state;
+	uint8_t m_out[CONSOLE_OUT_SIZE];
+	size_t m_outLength;
+	size_t m_outPos;
+	bool m_cut;					// the response didn't fit, the marker ends it
+	uint8_t m_dumpType;			// HISTORY or TRACE
+	int16_t m_dumpBlock;
+	uint16_t m_dumpOffset;
+	unsigned long m_inputTime;
+	uint32_t m_frames;
+	uint32_t m_errors;
+	uint8_t m_zone;
+	Listing m_listing;			// paged one line per poll, zones take a line each
+	uint8_t m_listLine;			// next line of it
+	int8_t m_bench;				// next benchmark, one per poll
+	BenchMode m_benchMode;
+	uint8_t m_regressions;
+};
+
+extern ConsoleModule Console;
+
+#endif
@@ -0,0 +1,157 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Control.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo relay control engine
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Control.h"
+
+#define HOUR_MS						3600000L
+
+Controller::Controller() :
+	m_mode(HYSTERESIS),
+	m_relay(false),
+	m_started(false),
+	m_duty(0),
+	m_lastTemperature(0),
+	m_integral(0),
+	m_derivative(0),
+	m_lastUpdate(0UL),
+	m_switchTime(0UL),
+	m_windowStart(0UL),
+	m_cycles(0) {
+}
+
+// relay is the state restored at boot: it may switch on the first update,
+// how long it has been in that state is unknown
+void Controller::begin(Mode mode, bool relay, unsigned long now) {
+	m_mode = mode;
+	m_relay = relay;
+	m_started = false;
+	m_duty = relay ? CONTROL_DUTY_MAX : 0;
+	m_integral = 0;
+	m_derivative = 0;
+	m_switchTime = now - (CONTROL_MIN_ON > CONTROL_MIN_OFF ? CONTROL_MIN_ON : CONTROL_MIN_OFF);
+	m_windowStart = now;
+}
+
+void Controller::mode(Mode mode) {
+	if (mode != m_mode) {
+		m_mode = mode;
+		m_integral = 0;
+		m_started = false;
+	}
+}
+
+bool Controller::update(int16_t setpoint, int16_t temperature, unsigned long now) {
+	bool on = m_mode == PID ? proportioning(setpoint, temperature, now) : hysteresis(setpoint, temperature);
+
+	// a state is held for its minimum time, whatever the controller wants
+	if (on != m_relay && (now - m_switchTime) >= (m_relay ? CONTROL_MIN_ON : CONTROL_MIN_OFF)) {
+		m_relay = on;
+		m_switchTime = now;
+		if (on) {
+			m_cycles++;
+		}
+	}
+
+	return m_relay;
+}
+
+// Heating held off from outside (an open window): off once the minimum on
+// time allows. The PID keeps its integral, the rest starts over on resume.
+bool Controller::suspend(unsigned long now) {
+	m_duty = 0;
+	m_started = false;
+
+	if (m_relay && (now - m_switchTime) >= CONTROL_MIN_ON) {
+		m_relay = false;
+		m_switchTime = now;
+	}
+
+	return m_relay;
+}
+
+bool Controller::hysteresis(int16_t setpoint, int16_t temperature) {
+	m_duty = m_relay ? CONTROL_DUTY_MAX : 0;
+
+	if (temperature <= setpoint - CONTROL_HYSTERESIS) {
+		return true;
+	}
+	if (temperature >= setpoint + CONTROL_HYSTERESIS) {
+		return false;
+	}
+
+	return m_relay;
+}
+
+// On for the first duty part of every window. Windows shorter than the
+// minimum on or off time are rounded to all off or all on.
+bool Controller::proportioning(int16_t setpoint, int16_t temperature, unsigned long now) {
+	unsigned long dt = now - m_lastUpdate;
+
+	if (!m_started) {
+		m_lastTemperature = temperature;
+		m_derivative = 0;
+		m_windowStart = now;
+		dt = 0;
+		m_started = true;
+	}
+	m_lastUpdate = now;
+	m_duty = pid(setpoint, temperature, dt);
+
+	if ((now - m_windowStart) >= CONTROL_WINDOW) {
+		m_windowStart += CONTROL_WINDOW * ((now - m_windowStart) / CONTROL_WINDOW);
+	}
+
+	unsigned long onTime = (unsigned long)m_duty * (CONTROL_WINDOW / CONTROL_DUTY_MAX);
+	if (onTime < CONTROL_MIN_ON) {
+		onTime = 0;
+	} else if (CONTROL_WINDOW - onTime < CONTROL_MIN_OFF) {
+		onTime = CONTROL_WINDOW;
+	}
+
+	return (now - m_windowStart) < onTime;
+}
+
+// Fixed point PID: error in tenths of °C, output in per mille. The
+// derivative acts on the measurement, so setpoint steps don't kick it.
+uint16_t Controller::pid(int16_t setpoint, int16_t temperature, unsigned long dt) {
+	int32_t error = setpoint - temperature;
+
+	if (dt > 0) {
+		// tenths per hour, smoothed over about 8 updates
+		int32_t rate = (int32_t)((int64_t)(temperature - m_lastTemperature) * HOUR_MS / (int32_t)dt);
+		m_derivative += (rate - m_derivative) >> 3;
+	}
+	m_lastTemperature = temperature;
+
+	int32_t p = CONTROL_KP * error / 10;
+	int32_t d = -(CONTROL_KD * m_derivative / 10);
+	int32_t i = m_integral >> CONTROL_I_SHIFT;
+	int32_t out = p + i + d;
+
+	// anti-windup: integrate only while the output isn't pushed further
+	// into saturation, and never beyond the output range
+	if (dt > 0 && !((out >= CONTROL_DUTY_MAX && error > 0) || (out <= 0 && error < 0))) {
+		m_integral += (int32_t)((int64_t)CONTROL_KI * error * (int32_t)dt * (1L << CONTROL_I_SHIFT) / (10 * HOUR_MS));
+		if (m_integral < 0) {
+			m_integral = 0;
+		} else if (m_integral > ((int32_t)CONTROL_DUTY_MAX << CONTROL_I_SHIFT)) {
+			m_integral = (int32_t)CONTROL_DUTY_MAX << CONTROL_I_SHIFT;
+		}
+		out = p + (m_integral >> CONTROL_I_SHIFT) + d;
+	}
+
+	if (out < 0) {
+		return 0;
+	}
+
+	return out > CONTROL_DUTY_MAX ? CONTROL_DUTY_MAX : out;
+}
@@ -0,0 +1,62 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Control.h
+ * Created on: 19 Oct 2026
+ * Description: Thimo relay control engine
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#ifndef _THIMO_CONTROL_H_
+#define _THIMO_CONTROL_H_
+
+#include <Arduino.h>
+#include "config.h"
+
+#define CONTROL_DUTY_MAX			1000	// duty cycle is in per mille
+#define CONTROL_I_SHIFT				16		// integral term fixed point fraction bits
+
+// Decides the relay state from setpoint and temperature, both in tenths of
+// °C. HYSTERESIS switches at the edges of a band around the setpoint; PID
+// computes a duty cycle and spreads it over a time-proportioning window.
+// Both respect the minimum on and off times.
+class Controller {
+public:
+	typedef enum {
+		HYSTERESIS,
+		PID
+	} Mode;
+
+	Controller();
+
+	void begin(Mode mode, bool relay, unsigned long now);
+	bool update(int16_t setpoint, int16_t temperature, unsigned long now);
+	bool suspend(unsigned long now);
+
+	void mode(Mode mode);
+	inline Mode mode() const { return m_mode; }
+	inline bool relay() const { return m_relay; }
+	inline uint16_t duty() const { return m_duty; }
+	inline uint32_t cycles() const { return m_cycles; }
+private:
+	bool hysteresis(int16_t setpoint, int16_t temperature);
+	bool proportioning(int16_t setpoint, int16_t temperature, unsigned long now);
+	uint16_t pid(int16_t setpoint, int16_t temperature, unsigned long dt);
+
+	Mode m_mode;
+	bool m_relay;
+	bool m_started;
+	uint16_t m_duty;
+	int16_t m_lastTemperature;
+	int32_t m_integral;			// per mille << CONTROL_I_SHIFT
+	int32_t m_derivative;		// filtered tenths of °C per hour
+	unsigned long m_lastUpdate;
+	unsigned long m_switchTime;
+	unsigned long m_windowStart;
+	uint32_t m_cycles;
+};
+
+#endif
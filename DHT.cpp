@@ -18,28 +18,7 @@
 
 #include "DHT.h"
 
-DHTModule::DHTModule(uint8_t pin, Model model) :
-	m_pin(pin),
-	m_model(model) {
-	m_lastReadTime = 0UL;
-}
-
-DHTModule::~DHTModule() {
-}
-
-void DHTModule::begin() {
-	if (m_model == AUTO_DETECT)
-	{
-		m_model = DHT22;
-		Environment env;
-		if (readSensor(&env) == ERROR_TIMEOUT)
-		{
-			m_model = DHT11;
-			// Warning: in case we auto detect a DHT11, you should wait at least 1000 msec
-			// before your first read request. Otherwise you will get a time out error.
-		}
-	}
-
+DHTBase::DHTBase() {
 	//Set default comfort profile.
 
 	//In computing these constants the following reference was used
@@ -64,181 +43,39 @@ void DHTModule::begin() {
 	m_comfort.m_tooDry_b = 2364;
 }
 
-DHTModule::Status DHTModule::readSensor(Environment *env) {
-	// Make sure we don't poll the sensor too often
-	// - Max sample rate DHT11 is 1 Hz   (duty cicle 1000 ms)
-	// - Max sample rate DHT22 is 0.5 Hz (duty cicle 2000 ms)
-	unsigned long startTime = millis();
-	if ((startTime - m_lastReadTime) < minimumSamplingPeriod()) {
-		return ERROR_RETRY;
-	}
-
-	m_lastReadTime = startTime;
-	env->temperature = NAN;
-	env->humidity = NAN;
-
-	uint16_t rawHumidity = 0;
-	uint16_t rawTemperature = 0;
-	uint16_t data = 0;
-
-	// Request sample
-	digitalWrite(m_pin, LOW); // Send start signal
-	pinMode(m_pin, OUTPUT);
-	if (m_model == DHT11) {
-		delay(18);
-	} else {
-		// This will fail for a DHT11 - that's how we can detect such a device
-		delay(2);
-	}
-
-	pinMode(m_pin, INPUT);
-	digitalWrite(m_pin, HIGH); // Switch bus to receive data
-
-	// We're going to read 83 edges:
-	// - First a FALLING, RISING, and FALLING edge for the start bit
-	// - Then 40 bits: RISING and then a FALLING edge per bit
-	// To keep our code simple, we accept any HIGH or LOW reading if it's max 85 usecs long
-
-#ifdef ESP32
-	// ESP32 is a multi core / multi processing chip
-	// It is necessary to disable task switches during the readings
-	portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
-	portENTER_CRITICAL(&mux);
-#else
-	//   cli();
-	noInterrupts();
-#endif
-	for (int8_t i = -3; i < 2 * 40; i++) {
-		byte age;
-		startTime = micros();
-
-		do {
-			age = (unsigned long)(micros() - startTime);
-			if (age > 90) {
-#ifdef ESP32
-				portEXIT_CRITICAL(&mux);
-#else
-				// sei();
-				interrupts();
-#endif
-				return ERROR_TIMEOUT;
-			}
-		} while (digitalRead(m_pin) == (i & 1) ? HIGH : LOW);
-
-		if (i >= 0 && (i & 1)) {
-			// Now we are being fed our 40 bits
-			data <<= 1;
-
-			// A zero max 30 usecs, a one at least 68 usecs.
-			if (age > 30) {
-				data |= 1; // we got a one
-			}
-		}
-
-		switch (i) {
-			case 31:
-				rawHumidity = data;
-				break;
-			case 63:
-				rawTemperature = data;
-				data = 0;
-				break;
-		}
-	}
-
-#ifdef ESP32
-	portEXIT_CRITICAL(&mux);
-#else
-	//   sei();
-	interrupts();
-#endif
-
-	// Verify checksum
-
-	if ((byte)(((byte)rawHumidity) + (rawHumidity >> 8) + ((byte)rawTemperature) + (rawTemperature >> 8)) != data) {
-		return ERROR_CHECKSUM;
-	}
-
-	// Store readings
-
-	if (m_model == DHT11) {
-		env->humidity = (rawHumidity >> 8) + ((rawHumidity & 0x00FF) * 0.1);
-		env->temperature = (rawTemperature >> 8) + ((rawTemperature & 0x007F) * 0.1);
-		if (rawTemperature & 0x0080) {
-			env->temperature = -env->temperature;
-		}
-	} else {
-		env->humidity = rawHumidity * 0.1;
-		if (rawTemperature & 0x8000) {
-			rawTemperature = -(int16_t)(rawTemperature & 0x7FFF);
-		}
-		env->temperature = ((int16_t)rawTemperature) * 0.1;
-	}
-
-	return ERROR_NONE;
-}
-
-inline int DHTModule::minimumSamplingPeriod() {
-	return m_model == DHT11 ? 1000 : 2000;
-}
-
-inline int8_t DHTModule::numberOfDecimalsTemperature() {
-	return m_model == DHT11 ? 0 : 1;
-}
-
-inline int8_t DHTModule::lowerBoundTemperature() {
-	return m_model == DHT11 ? 0 : -40;
-}
-
-inline int8_t DHTModule::upperBoundTemperature() {
-	return m_model == DHT11 ? 50 : 125;
-}
-
-inline int8_t DHTModule::numberOfDecimalsHumidity() {
-	return 0;
-}
-
-inline int8_t DHTModule::lowerBoundHumidity() {
-	return m_model == DHT11 ? 20 : 0;
-}
-
-inline int8_t DHTModule::upperBoundHumidity() {
-	return m_model == DHT11 ? 90 : 100;
-}
-
-inline float DHTModule::toFahrenheit(float fromCelcius) {
+inline float DHTBase::toFahrenheit(float fromCelcius) {
 	return 1.8 * fromCelcius + 32.0;
 }
 
-inline float DHTModule::toCelsius(float fromFahrenheit) {
+inline float DHTBase::toCelsius(float fromFahrenheit) {
 	return (fromFahrenheit - 32.0) / 1.8;
 }
 
-inline ComfortProfile DHTModule::comfortProfile() {
+inline ComfortProfile DHTBase::comfortProfile() {
 	return m_comfort;
 }
 
-inline void DHTModule::comfortProfile(ComfortProfile &c) {
+inline void DHTBase::comfortProfile(ComfortProfile &c) {
 	m_comfort = c;
 }
 
-inline bool DHTModule::isTooHot(float temp, float humidity) {
+inline bool DHTBase::isTooHot(float temp, float humidity) {
 	return m_comfort.isTooHot(temp, humidity);
 }
 
-inline bool DHTModule::isTooHumid(float temp, float humidity) {
+inline bool DHTBase::isTooHumid(float temp, float humidity) {
 	return m_comfort.isTooHumid(temp, humidity);
 }
 
-inline bool DHTModule::isTooCold(float temp, float humidity) {
+inline bool DHTBase::isTooCold(float temp, float humidity) {
 	return m_comfort.isTooCold(temp, humidity);
 }
 
-inline bool DHTModule::isTooDry(float temp, float humidity) {
+inline bool DHTBase::isTooDry(float temp, float humidity) {
 	return m_comfort.isTooDry(temp, humidity);
 }
 
-float DHTModule::computeHeatIndex(float temperature, float percentHumidity, bool isFahrenheit) {
+float DHTBase::computeHeatIndex(float temperature, float percentHumidity, bool isFahrenheit) {
 	// Using both Rothfusz and Steadman's equations
 	// http://www.wpc.ncep.noaa.gov/html/heatindex_equation.shtml
 	float hi;
@@ -271,7 +108,7 @@ float DHTModule::computeHeatIndex(float temperature, float percentHumidity, bool
 }
 
 //boolean isFahrenheit: True == Fahrenheit; False == Celcius
-float DHTModule::computeDewPoint(float temperature, float percentHumidity, bool isFahrenheit) {
+float DHTBase::computeDewPoint(float temperature, float percentHumidity, bool isFahrenheit) {
 	// reference: http://wahiduddin.net/calc/density_algorithms.htm
 	if (isFahrenheit) {
 		temperature = toCelsius(temperature);
@@ -289,7 +126,7 @@ float DHTModule::computeDewPoint(float temperature, float percentHumidity, bool
 }
 
 //boolean isFahrenheit: True == Fahrenheit; False == Celcius
-byte DHTModule::computePerception(float temperature, float percentHumidity, bool isFahrenheit) {
+byte DHTBase::computePerception(float temperature, float percentHumidity, bool isFahrenheit) {
 	// Computing human perception from dew point
 	// reference: https://en.wikipedia.org/wiki/Dew_point ==> Relationship to human comfort
 	// reference: Horstmeyer, Steve (2006-08-15). "Relative Humidity....Relative to What? The Dew Point Temperature...a better approach". Steve Horstmeyer, Meteorologist, WKRC TV, Cincinnati, Ohio, USA. Retrieved 2009-08-20.
@@ -329,7 +166,7 @@ byte DHTModule::computePerception(float temperature, float percentHumidity, bool
 }
 
 //boolean isFahrenheit: True == Fahrenheit; False == Celcius
-float DHTModule::comfortRatio(ComfortState &destComfortStatus, float temperature, float percentHumidity, bool isFahrenheit) {
+float DHTBase::comfortRatio(ComfortState &destComfortStatus, float temperature, float percentHumidity, bool isFahrenheit) {
 	float ratio = 100; //100%
 	float distance = 0;
 	float kTempFactor = 3;	  //take into account the slope of the lines
@@ -382,7 +219,7 @@ float DHTModule::comfortRatio(ComfortState &destComfortStatus, float temperature
 	return ratio;
 }
 
-float DHTModule::computeAbsoluteHumidity(float temperature, float percentHumidity, bool isFahrenheit) {
+float DHTBase::computeAbsoluteHumidity(float temperature, float percentHumidity, bool isFahrenheit) {
 	// Calculate the absolute humidity in g/m³
 	// https://carnotcycle.wordpress.com/2012/08/04/how-to-convert-relative-humidity-to-absolute-humidity/
 	if (isFahrenheit) {
@@ -401,5 +238,3 @@ float DHTModule::computeAbsoluteHumidity(float temperature, float percentHumidit
 
 	return absHumidity;
 }
-
-DHTModule DHT(DHT_PIN, DHTModule::DHT22);
@@ -20,8 +20,13 @@
 #define _THIMO_DHT_H_
 
 #include <Arduino.h>
+#include "Sensor.h"
 #include "config.h"
 
+#ifdef ESP32
+#include <soc/gpio_struct.h>
+#endif
+
 // Reference: http://epb.apogee.net/res/refcomf.asp (References invalid)
 enum ComfortState {
 	Comfort_OK = 0,
@@ -47,11 +52,6 @@ enum PerceptionState {
 	Perception_SevereUncomfy = 7
 };
 
-struct Environment {
-	float temperature;
-	float humidity;
-};
-
 struct ComfortProfile {
 	//Represent the 4 line equations:
 	//dry, humid, hot, cold, using the y = mx + b formula
@@ -71,7 +71,7 @@ struct ComfortProfile {
 	inline float distanceTooDry(float temp, float humidity) { return (humidity * m_tooDry_m + m_tooDry_b) - temp; }
 };
 
-class DHTModule {
+class DHTBase : public Sensor {
 public:
 	typedef enum {
 		AUTO_DETECT,
@@ -81,26 +81,7 @@ public:
 		RHT03	// Equivalent to DHT22
 	} Model;
 
-	typedef enum {
-		ERROR_NONE = 0,
-		ERROR_RETRY,
-		ERROR_TIMEOUT,
-		ERROR_CHECKSUM
-	} Status;
-
-	DHTModule(uint8_t pin, Model model);
-	virtual ~DHTModule();
-
-	void begin();
-	Status readSensor(Environment *env);
-
-	int minimumSamplingPeriod();
-	int8_t numberOfDecimalsTemperature();
-	int8_t lowerBoundTemperature();
-	int8_t upperBoundTemperature();
-	int8_t numberOfDecimalsHumidity();
-	int8_t lowerBoundHumidity();
-	int8_t upperBoundHumidity();
+	DHTBase();
 
 	static float toFahrenheit(float fromCelcius);
 	static float toCelsius(float fromFahrenheit);
@@ -117,13 +98,268 @@ public:
 	byte computePerception(float temperature, float percentHumidity, bool isFahrenheit = false);
 	float computeAbsoluteHumidity(float temperature, float percentHumidity, bool isFahrenheit = false);
 
+protected:
+	ComfortProfile m_comfort;
+};
+
+// Pin access for the capture loop: reads the GPIO input register directly
+template<uint8_t PIN>
+struct DHTFixedPin {
+#ifdef ESP32
+	inline int read() const { return PIN < 32 ? (GPIO.in >> PIN) & 1 : (GPIO.in1.val >> (PIN - 32)) & 1; }
+#else
+	inline int read() const { return digitalRead(PIN); }
+#endif
+	inline void output() const { digitalWrite(PIN, LOW); pinMode(PIN, OUTPUT); }
+	inline void input() const { pinMode(PIN, INPUT); digitalWrite(PIN, HIGH); }
+};
+
+// The start signal is the line held low for the model's start delay: start()
+// pulls it low, the capture releases it and reads the answer. Pulses are
+// timed with micros(), whose timer doesn't follow the CPU clock, so the
+// thresholds hold at every frequency the governor picks (see Power.h).
+template<class P>
+Sensor::Status dhtCapture(const P &pin, uint16_t &rawHumidity, uint16_t &rawTemperature) {
+	uint16_t data = 0;
+	unsigned long startTime;
+
+	rawHumidity = 0;
+	rawTemperature = 0;
+
+	pin.input(); // Switch bus to receive data
+
+	// We're going to read 83 edges:
+	// - First a FALLING, RISING, and FALLING edge for the start bit
+	// - Then 40 bits: RISING and then a FALLING edge per bit
+	// To keep our code simple, we accept any HIGH or LOW reading if it's max 85 usecs long
+
+#ifdef ESP32
+	// ESP32 is a multi core / multi processing chip
+	// It is necessary to disable task switches during the readings
+	portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+	portENTER_CRITICAL(&mux);
+#else
+	//   cli();
+	noInterrupts();
+#endif
+	for (int8_t i = -3; i < 2 * 40; i++) {
+		byte age;
+		startTime = micros();
+
+		do {
+			age = (unsigned long)(micros() - startTime);
+			if (age > 90) {
+#ifdef ESP32
+				portEXIT_CRITICAL(&mux);
+#else
+				// sei();
+				interrupts();
+#endif
+				return Sensor::ERROR_TIMEOUT;
+			}
+		} while (pin.read() == (i & 1));
+
+		if (i >= 0 && (i & 1)) {
+			// Now we are being fed our 40 bits
+			data <<= 1;
+
+			// A zero max 30 usecs, a one at least 68 usecs.
+			if (age > 30) {
+				data |= 1; // we got a one
+			}
+		}
+
+		switch (i) {
+			case 31:
+				rawHumidity = data;
+				break;
+			case 63:
+				rawTemperature = data;
+				data = 0;
+				break;
+		}
+	}
+
+#ifdef ESP32
+	portEXIT_CRITICAL(&mux);
+#else
+	//   sei();
+	interrupts();
+#endif
+
+	// Verify checksum
+
+	if ((byte)(((byte)rawHumidity) + (rawHumidity >> 8) + ((byte)rawTemperature) + (rawTemperature >> 8)) != data) {
+		return Sensor::ERROR_CHECKSUM;
+	}
+
+	return Sensor::ERROR_NONE;
+}
+
+// Per model constants and raw value decoding, resolved at compile time
+template<DHTBase::Model MODEL>
+struct DHTTraits;
+
+template<>
+struct DHTTraits<DHTBase::DHT11> {
+	// Max sample rate DHT11 is 1 Hz (duty cicle 1000 ms)
+	enum {
+		SAMPLING_PERIOD = 1000,
+		START_DELAY = 18,
+		DECIMALS_TEMPERATURE = 0,
+		LOWER_TEMPERATURE = 0,
+		UPPER_TEMPERATURE = 50,
+		DECIMALS_HUMIDITY = 0,
+		LOWER_HUMIDITY = 20,
+		UPPER_HUMIDITY = 90
+	};
+
+	static inline void decode(uint16_t rawHumidity, uint16_t rawTemperature, Environment *env) {
+		env->humidity = (rawHumidity >> 8) + ((rawHumidity & 0x00FF) * 0.1);
+		env->temperature = (rawTemperature >> 8) + ((rawTemperature & 0x007F) * 0.1);
+		if (rawTemperature & 0x0080) {
+			env->temperature = -env->temperature;
+		}
+	}
+};
+
+template<>
+struct DHTTraits<DHTBase::DHT22> {
+	// Max sample rate DHT22 is 0.5 Hz (duty cicle 2000 ms)
+	enum {
+		SAMPLING_PERIOD = 2000,
+		START_DELAY = 2, // This will fail for a DHT11 - that's how we can detect such a device
+		DECIMALS_TEMPERATURE = 1,
+		LOWER_TEMPERATURE = -40,
+		UPPER_TEMPERATURE = 125,
+		DECIMALS_HUMIDITY = 0,
+		LOWER_HUMIDITY = 0,
+		UPPER_HUMIDITY = 100
+	};
+
+	static inline void decode(uint16_t rawHumidity, uint16_t rawTemperature, Environment *env) {
+		env->humidity = rawHumidity * 0.1;
+		if (rawTemperature & 0x8000) {
+			rawTemperature = -(int16_t)(rawTemperature & 0x7FFF);
+		}
+		env->temperature = ((int16_t)rawTemperature) * 0.1;
+	}
+};
+
+template<>
+struct DHTTraits<DHTBase::AM2302> : public DHTTraits<DHTBase::DHT22> {};
+
+template<>
+struct DHTTraits<DHTBase::RHT03> : public DHTTraits<DHTBase::DHT22> {};
+
+// Driver specialized on sensor model and pin: no model branches at run time
+template<DHTBase::Model MODEL, uint8_t PIN>
+class DHTSensor : public DHTBase {
+public:
+	typedef DHTTraits<MODEL> Traits;
+
+	virtual Status start() {
+		DHTFixedPin<PIN>().output(); // Send start signal
+		return ERROR_NONE;
+	}
+
+	virtual Status poll(Environment *env) {
+		// the line has to stay low for the whole start delay
+		if (elapsed() <= (unsigned long)Traits::START_DELAY) {
+			return ERROR_RETRY;
+		}
+
+		return capture(env);
+	}
+
+	// Releases the line held low by start() and decodes the answer
+	static Status capture(Environment *env) {
+		uint16_t rawHumidity;
+		uint16_t rawTemperature;
+		Status status = dhtCapture(DHTFixedPin<PIN>(), rawHumidity, rawTemperature);
+		if (status == ERROR_NONE) {
+			Traits::decode(rawHumidity, rawTemperature, env);
+		}
+
+		return status;
+	}
+
+	virtual uint8_t capabilities() const { return CAP_TEMPERATURE | CAP_HUMIDITY | CAP_BLOCKING; }
+	virtual int minimumSamplingPeriod() const { return Traits::SAMPLING_PERIOD; }
+	virtual int8_t numberOfDecimalsTemperature() const { return Traits::DECIMALS_TEMPERATURE; }
+	virtual int8_t lowerBoundTemperature() const { return Traits::LOWER_TEMPERATURE; }
+	virtual int8_t upperBoundTemperature() const { return Traits::UPPER_TEMPERATURE; }
+	virtual int8_t numberOfDecimalsHumidity() const { return Traits::DECIMALS_HUMIDITY; }
+	virtual int8_t lowerBoundHumidity() const { return Traits::LOWER_HUMIDITY; }
+	virtual int8_t upperBoundHumidity() const { return Traits::UPPER_HUMIDITY; }
+};
+
+// Driver for a model only known after AUTO_DETECT: begin() tells a DHT11
+// from a DHT22, then every call goes to the specialized driver of the model
+template<uint8_t PIN>
+class DHTModule : public DHTBase {
+public:
+	typedef DHTSensor<DHT11, PIN> DHT11Sensor;
+	typedef DHTSensor<DHT22, PIN> DHT22Sensor;
+
+	DHTModule(Model model = AUTO_DETECT) : m_model(model) {}
+
+	virtual void begin() {
+		if (m_model == AUTO_DETECT) {
+			m_model = DHT22;
+			Environment env;
+			Status status;
+			while ((status = read(&env)) == ERROR_RETRY) {
+				// blocking, only done once at startup
+			}
+			if (status == ERROR_TIMEOUT) {
+				m_model = DHT11;
+				// Warning: in case we auto detect a DHT11, the next reading is
+				// only taken after its 1000 msec sampling period
+			}
+		}
+	}
+
+	virtual Status start() {
+		DHTFixedPin<PIN>().output(); // Send start signal
+		return ERROR_NONE;
+	}
+
+	virtual Status poll(Environment *env) {
+		// the line has to stay low for the whole start delay
+		if (elapsed() <= (unsigned long)(dht11() ? (int)DHT11Sensor::Traits::START_DELAY : (int)DHT22Sensor::Traits::START_DELAY)) {
+			return ERROR_RETRY;
+		}
+
+		return dht11() ? DHT11Sensor::capture(env) : DHT22Sensor::capture(env);
+	}
+
+	virtual uint8_t capabilities() const { return CAP_TEMPERATURE | CAP_HUMIDITY | CAP_BLOCKING; }
+	virtual int minimumSamplingPeriod() const { return dht11() ? (int)DHT11Sensor::Traits::SAMPLING_PERIOD : (int)DHT22Sensor::Traits::SAMPLING_PERIOD; }
+	virtual int8_t numberOfDecimalsTemperature() const { return dht11() ? (int)DHT11Sensor::Traits::DECIMALS_TEMPERATURE : (int)DHT22Sensor::Traits::DECIMALS_TEMPERATURE; }
+	virtual int8_t lowerBoundTemperature() const { return dht11() ? (int)DHT11Sensor::Traits::LOWER_TEMPERATURE : (int)DHT22Sensor::Traits::LOWER_TEMPERATURE; }
+	virtual int8_t upperBoundTemperature() const { return dht11() ? (int)DHT11Sensor::Traits::UPPER_TEMPERATURE : (int)DHT22Sensor::Traits::UPPER_TEMPERATURE; }
+	virtual int8_t numberOfDecimalsHumidity() const { return dht11() ? (int)DHT11Sensor::Traits::DECIMALS_HUMIDITY : (int)DHT22Sensor::Traits::DECIMALS_HUMIDITY; }
+	virtual int8_t lowerBoundHumidity() const { return dht11() ? (int)DHT11Sensor::Traits::LOWER_HUMIDITY : (int)DHT22Sensor::Traits::LOWER_HUMIDITY; }
+	virtual int8_t upperBoundHumidity() const { return dht11() ? (int)DHT11Sensor::Traits::UPPER_HUMIDITY : (int)DHT22Sensor::Traits::UPPER_HUMIDITY; }
+
+	inline Model model() const { return m_model; }
 private:
-	uint8_t m_pin;
+	inline bool dht11() const { return m_model == DHT11; }
+
 	Model m_model;
-	ComfortProfile m_comfort;
-	unsigned long m_lastReadTime;
 };
 
-extern DHTModule DHT;
+// The driver of a configured model: the specialized one, or the one that
+// detects it
+template<DHTBase::Model MODEL, uint8_t PIN>
+struct DHTDriver {
+	typedef DHTSensor<MODEL, PIN> Type;
+};
+
+template<uint8_t PIN>
+struct DHTDriver<DHTBase::AUTO_DETECT, PIN> {
+	typedef DHTModule<PIN> Type;
+};
 
 #endif
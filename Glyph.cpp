@@ -0,0 +1,136 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Glyph.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo custom LCD glyph cache
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Glyph.h"
+#include "LCD.h"
+
+static const uint8_t bitmaps[GlyphModule::GLYPH_COUNT][8] = {
+	{ 0x1f, 0x1f, 0x1f, 0x00, 0x00, 0x00, 0x00, 0x00 },	// BIG_TOP
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f, 0x1f, 0x1f },	// BIG_BOTTOM
+	{ 0x1f, 0x1f, 0x1f, 0x00, 0x00, 0x00, 0x1f, 0x1f },	// BIG_UPPER_MID
+	{ 0x1f, 0x00, 0x00, 0x00, 0x00, 0x1f, 0x1f, 0x1f },	// BIG_LOWER_MID
+	{ 0x04, 0x0e, 0x15, 0x04, 0x04, 0x04, 0x04, 0x00 },	// ARROW_UP
+	{ 0x04, 0x04, 0x04, 0x04, 0x15, 0x0e, 0x04, 0x00 },	// ARROW_DOWN
+	{ 0x00, 0x04, 0x02, 0x1f, 0x02, 0x04, 0x00, 0x00 },	// ARROW_STEADY
+	{ 0x04, 0x06, 0x0e, 0x0f, 0x1f, 0x1b, 0x0e, 0x00 },	// FLAME
+	{ 0x00, 0x0e, 0x11, 0x04, 0x0a, 0x00, 0x04, 0x00 },	// WIFI
+	{ 0x1f, 0x15, 0x15, 0x1f, 0x15, 0x15, 0x1f, 0x00 }	// WINDOW
+};
+
+// ROM characters drawn when all slots are taken by the current frame
+static const char fallbacks[GlyphModule::GLYPH_COUNT] = {
+	'-', '_', '=', '=', '^', 'v', 0x7e, '*', 'w', '#'
+};
+
+// Big digits are 3 columns by 2 rows: full blocks (ROM 0xff), blanks and
+// the four segment glyphs. Upper row first, then lower row.
+#define FUL	0xff
+#define TOP	(0x80 | GlyphModule::BIG_TOP)
+#define BOT	(0x80 | GlyphModule::BIG_BOTTOM)
+#define UPM	(0x80 | GlyphModule::BIG_UPPER_MID)
+#define LOM	(0x80 | GlyphModule::BIG_LOWER_MID)
+
+static const uint8_t digits[10][6] = {
+	{ FUL, TOP, FUL,   FUL, BOT, FUL },
+	{ TOP, FUL, ' ',   BOT, FUL, BOT },
+	{ UPM, UPM, FUL,   FUL, LOM, LOM },
+	{ UPM, UPM, FUL,   LOM, LOM, FUL },
+	{ FUL, BOT, FUL,   ' ', ' ', FUL },
+	{ FUL, UPM, UPM,   LOM, LOM, FUL },
+	{ FUL, UPM, UPM,   FUL, LOM, FUL },
+	{ TOP, TOP, FUL,   ' ', ' ', FUL },
+	{ FUL, UPM, FUL,   FUL, LOM, FUL },
+	{ FUL, UPM, FUL,   LOM, LOM, FUL }
+};
+
+#undef FUL
+#undef TOP
+#undef BOT
+#undef UPM
+#undef LOM
+
+GlyphModule::GlyphModule() :
+	m_clock(0),
+	m_frame(1),
+	m_uploads(0),
+	m_minuteUploads(0),
+	m_minuteTimer(0UL),
+	m_rate(0) {
+	for (int i = 0; i < GLYPH_SLOTS; i++) {
+		m_slots[i].glyph = GLYPH_NONE;
+		m_slots[i].used = 0;
+		m_slots[i].frame = 0;
+	}
+}
+
+// Call before drawing a frame: what the previous frames used can be evicted.
+void GlyphModule::frame() {
+	m_frame++;
+
+	if ((millis() - m_minuteTimer) >= 60000UL) {
+		m_minuteTimer = millis();
+		m_rate = m_uploads - m_minuteUploads;
+		m_minuteUploads = m_uploads;
+	}
+}
+
+uint8_t GlyphModule::code(Glyph glyph) {
+	uint8_t victim = GLYPH_NONE;
+
+	for (uint8_t i = 0; i < GLYPH_SLOTS; i++) {
+		Slot &slot = m_slots[i];
+		if (slot.glyph == glyph) {
+			slot.used = ++m_clock;
+			slot.frame = m_frame;
+			return i;
+		}
+		// empty slots were never used, so they go first
+		if (slot.frame != m_frame && (victim == GLYPH_NONE || slot.used < m_slots[victim].used)) {
+			victim = i;
+		}
+	}
+
+	if (victim == GLYPH_NONE) {
+		return fallbacks[glyph];
+	}
+
+	// cells still showing the old glyph change with the slot: the frame
+	// buffer diff redraws them unless this frame puts the new glyph there
+	uint8_t bitmap[8];
+	memcpy(bitmap, bitmaps[glyph], sizeof(bitmap));
+	LCD.createChar(victim, bitmap);
+	m_uploads++;
+
+	m_slots[victim].glyph = glyph;
+	m_slots[victim].used = ++m_clock;
+	m_slots[victim].frame = m_frame;
+
+	return victim;
+}
+
+void GlyphModule::print(Glyph glyph) {
+	LCD.write(code(glyph));
+}
+
+void GlyphModule::bigDigit(uint8_t col, uint8_t digit) {
+	const uint8_t *cells = digits[digit % 10];
+
+	for (uint8_t row = 0; row < 2; row++) {
+		LCD.setCursor(col, row);
+		for (uint8_t i = 0; i < 3; i++) {
+			uint8_t c = *cells++;
+			LCD.write(c != 0xff && (c & 0x80) ? code((Glyph)(c & 0x7f)) : c);
+		}
+	}
+}
+
+GlyphModule Glyph;
@@ -0,0 +1,68 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Glyph.h
+ * Created on: 19 Oct 2026
+ * Description: Thimo custom LCD glyph cache
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#ifndef _THIMO_GLYPH_H_
+#define _THIMO_GLYPH_H_
+
+#include <Arduino.h>
+
+#define GLYPH_SLOTS					8		// HD44780 CGRAM characters
+#define GLYPH_NONE					0xff
+
+// Maps a virtual glyph set larger than the CGRAM onto its 8 slots. A slot is
+// uploaded only on a miss, the least recently used one is replaced, and the
+// glyphs already drawn in the current frame are never evicted.
+class GlyphModule {
+public:
+	typedef enum {
+		BIG_TOP,				// big digit segments, two rows high
+		BIG_BOTTOM,
+		BIG_UPPER_MID,
+		BIG_LOWER_MID,
+		ARROW_UP,
+		ARROW_DOWN,
+		ARROW_STEADY,
+		FLAME,
+		WIFI,
+		WINDOW,
+		GLYPH_COUNT
+	} Glyph;
+
+	GlyphModule();
+
+	void frame();
+	uint8_t code(Glyph glyph);
+	void print(Glyph glyph);
+	void bigDigit(uint8_t col, uint8_t digit);
+
+	inline uint8_t glyph(uint8_t code) const { return m_slots[code].glyph; }
+	inline uint32_t uploads() const { return m_uploads; }
+	inline uint16_t uploadsPerMinute() const { return m_rate; }
+private:
+	struct Slot {
+		uint8_t glyph;
+		uint32_t used;
+		uint32_t frame;
+	};
+
+	Slot m_slots[GLYPH_SLOTS];
+	uint32_t m_clock;
+	uint32_t m_frame;
+	uint32_t m_uploads;
+	uint32_t m_minuteUploads;
+	unsigned long m_minuteTimer;
+	uint16_t m_rate;
+};
+
+extern GlyphModule Glyph;
+
+#endif
@@ -0,0 +1,112 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: History.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo sample history module
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "History.h"
+
+HistoryModule::HistoryModule() :
+	m_head(0),
+	m_count(0),
+	m_samples(0),
+	m_valid(false) {
+}
+
+void HistoryModule::begin() {
+	m_head = 0;
+	m_count = 1;
+	m_samples = 0;
+	m_valid = false;
+	m_length[0] = 0;
+	m_encoder.begin(m_data[0], HISTORY_BLOCK_SIZE, HISTORY_PERIOD);
+}
+
+void HistoryModule::record(const Sample &sample) {
+	if (!m_encoder.push(sample)) {
+		rotate();
+		m_encoder.push(sample);
+	}
+	m_last = sample;
+	m_valid = true;
+	m_samples++;
+}
+
+void HistoryModule::relay(bool state) {
+	if (!m_valid) {
+		return;
+	}
+
+	if (!m_encoder.relay(state)) {
+		rotate();
+		// every block is self contained: restart from the last sample
+		m_encoder.push(m_last);
+		m_encoder.relay(state);
+	}
+}
+
+uint8_t HistoryModule::blocks() const {
+	return m_count;
+}
+
+const uint8_t *HistoryModule::block(uint8_t index, size_t &length) {
+	if (index >= m_count) {
+		length = 0;
+		return NULL;
+	}
+
+	// index 0 is the oldest block
+	uint8_t b = (m_head + HISTORY_BLOCKS - m_count + 1 + index) % HISTORY_BLOCKS;
+	if (b == m_head) {
+		m_encoder.flush();
+		m_length[b] = m_encoder.length();
+	}
+	length = m_length[b];
+
+	return m_data[b];
+}
+
+size_t HistoryModule::write(Print &out) {
+	size_t n = 0;
+
+	// export format: 16 bit little endian length followed by the encoded block
+	for (uint8_t i = 0; i < m_count; i++) {
+		size_t length;
+		const uint8_t *data = block(i, length);
+		n += out.write((uint8_t)length);
+		n += out.write((uint8_t)(length >> 8));
+		n += out.write(data, length);
+	}
+
+	return n;
+}
+
+size_t HistoryModule::bytes() const {
+	size_t n = m_encoder.length();
+
+	for (uint8_t i = 1; i < m_count; i++) {
+		n += m_length[(m_head + HISTORY_BLOCKS - i) % HISTORY_BLOCKS];
+	}
+
+	return n;
+}
+
+void HistoryModule::rotate() {
+	m_encoder.flush();
+	m_length[m_head] = m_encoder.length();
+
+	m_head = (m_head + 1) % HISTORY_BLOCKS;
+	if (m_count < HISTORY_BLOCKS) {
+		m_count++;
+	}
+	m_length[m_head] = 0;
+	m_encoder.begin(m_data[m_head], HISTORY_BLOCK_SIZE, HISTORY_PERIOD);
+}
+
+HistoryModule History;
@@ -0,0 +1,49 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: History.h
+ * Created on: 19 Oct 2026
+ * Description: Thimo sample history module
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#ifndef _THIMO_HISTORY_H_
+#define _THIMO_HISTORY_H_
+
+#include <Arduino.h>
+#include "Codec.h"
+#include "config.h"
+
+class HistoryModule {
+public:
+	HistoryModule();
+
+	void begin();
+	void record(const Sample &sample);
+	void relay(bool state);
+
+	uint8_t blocks() const;
+	const uint8_t *block(uint8_t index, size_t &length);
+	size_t write(Print &out);
+
+	inline uint32_t samples() const { return m_samples; }
+	size_t bytes() const;
+private:
+	void rotate();
+
+	uint8_t m_data[HISTORY_BLOCKS][HISTORY_BLOCK_SIZE];
+	uint16_t m_length[HISTORY_BLOCKS];
+	uint8_t m_head;
+	uint8_t m_count;
+	uint32_t m_samples;
+	bool m_valid;
+	Sample m_last;
+	SampleEncoder m_encoder;
+};
+
+extern HistoryModule History;
+
+#endif
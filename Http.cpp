@@ -0,0 +1,706 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Http.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo HTTP status server
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Http.h"
+#include "Thimo.h"
+#include "Power.h"
+#include "Ntp.h"
+
+#if !defined(ESP32) && defined(__linux__)
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+// A zone's line of a /metrics family at its widest: the last zone, a
+// counter at its largest
+#define HTTP_METRIC_ZONE(name)		(sizeof(name "{zone=\"15\"} 4294967295\n") - 1)
+
+static_assert(HTTP_METRIC_ZONE("thimo_sensor_captures_total") + HTTP_METRIC_ZONE("thimo_sensor_errors_total") +
+	HTTP_METRIC_ZONE("thimo_temperature_celsius") + HTTP_METRIC_ZONE("thimo_humidity_percent") +
+	HTTP_METRIC_ZONE("thimo_relay_on") + HTTP_METRIC_ZONE("thimo_relay_on_seconds_total") +
+	HTTP_METRIC_ZONE("thimo_relay_starts_total") + HTTP_METRIC_ZONE("thimo_relay_short_starts_total") <= HTTP_RESPONSE_ZONE,
+	"HTTP_RESPONSE_ZONE doesn't hold a zone of /metrics");
+
+#ifdef ESP32
+
+WiFiConnection::WiFiConnection() :
+	m_used(false) {
+}
+
+void WiFiConnection::open(const WiFiClient &client) {
+	m_client = client;
+	m_used = true;
+}
+
+int WiFiConnection::read(uint8_t *data, size_t n) {
+	int available = m_client.available();
+
+	if (available <= 0) {
+		return m_client.connected() ? 0 : -1;
+	}
+
+	return m_client.read(data, (size_t)available < n ? available : n);
+}
+
+int WiFiConnection::write(const uint8_t *data, size_t n) {
+	if (!m_client.connected()) {
+		return -1;
+	}
+
+	return m_client.write(data, n);
+}
+
+void WiFiConnection::close() {
+	m_client.stop();
+	m_used = false;
+}
+
+WiFiListener::WiFiListener(uint16_t port) :
+	m_server(port),
+	m_listening(false) {
+}
+
+bool WiFiListener::begin() {
+	if (WIFI_SSID[0] == '\0') {
+		return false;
+	}
+	WiFi.mode(WIFI_STA);
+	WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+
+	return true;
+}
+
+HttpConnection *WiFiListener::accept() {
+	if (!m_listening) {
+		if (WiFi.status() != WL_CONNECTED) {
+			return NULL;
+		}
+		m_server.begin();
+		m_server.setNoDelay(true);
+		m_listening = true;
+		LOG_INFO(LOG_HTTP, HTTP_PORT);
+	}
+
+	for (uint8_t i = 0; i < HTTP_CONNECTIONS; i++) {
+		if (!m_connections[i].used()) {
+			WiFiClient client = m_server.available();
+			if (!client) {
+				return NULL;
+			}
+			m_connections[i].open(client);
+			return &m_connections[i];
+		}
+	}
+
+	// all taken, the client waits in the backlog
+	return NULL;
+}
+
+static WiFiListener listener(HTTP_PORT);
+
+#elif defined(__linux__)
+
+SocketConnection::SocketConnection() :
+	m_fd(-1) {
+}
+
+int SocketConnection::read(uint8_t *data, size_t n) {
+	ssize_t count = recv(m_fd, data, n, 0);
+
+	if (count < 0) {
+		return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+	}
+
+	return count > 0 ? (int)count : -1;
+}
+
+int SocketConnection::write(const uint8_t *data, size_t n) {
+	ssize_t count = send(m_fd, data, n, MSG_NOSIGNAL);
+
+	if (count < 0) {
+		return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+	}
+
+	return (int)count;
+}
+
+void SocketConnection::close() {
+	::close(m_fd);
+	m_fd = -1;
+}
+
+SocketListener::SocketListener(uint16_t port) :
+	m_port(port),
+	m_server(-1) {
+}
+
+bool SocketListener::begin() {
+	struct sockaddr_in address;
+	int yes = 1;
+
+	m_server = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+	if (m_server < 0) {
+		return false;
+	}
+	setsockopt(m_server, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = htons(m_port);
+	if (bind(m_server, (struct sockaddr *)&address, sizeof(address)) < 0 || listen(m_server, 64) < 0) {
+		::close(m_server);
+		m_server = -1;
+		return false;
+	}
+	LOG_INFO(LOG_HTTP, m_port);
+
+	return true;
+}
+
+HttpConnection *SocketListener::accept() {
+	for (uint8_t i = 0; i < HTTP_CONNECTIONS; i++) {
+		if (!m_connections[i].used()) {
+			int fd = accept4(m_server, NULL, NULL, SOCK_NONBLOCK);
+			if (fd < 0) {
+				return NULL;
+			}
+			m_connections[i].open(fd);
+			return &m_connections[i];
+		}
+	}
+
+	// all taken, the client waits in the backlog
+	return NULL;
+}
+
+static SocketListener listener(HTTP_HOST_PORT);
+
+#else
+
+// No network on this board
+class NoListener : public HttpListener {
+public:
+	virtual bool begin() { return false; }
+	virtual HttpConnection *accept() { return NULL; }
+};
+
+static NoListener listener;
+
+#endif
+
+HttpModule::HttpModule(HttpListener &listener) :
+	m_listener(listener),
+	m_online(false),
+	m_responder(-1),
+	m_next(0),
+	m_overflow(false),
+	m_outStart(0),
+	m_outLength(0),
+	m_requests(0),
+	m_errors(0),
+	m_pollMax(0) {
+	for (uint8_t i = 0; i < HTTP_CONNECTIONS; i++) {
+		m_slots[i].connection = NULL;
+		m_slots[i].state = STATE_IDLE;
+	}
+}
+
+void HttpModule::begin() {
+	m_online = m_listener.begin();
+}
+
+void HttpModule::poll() {
+	uint8_t data[HTTP_POLL_BYTES];
+	unsigned long start = micros();
+
+	if (!m_online) {
+		return;
+	}
+
+	// one new connection per pass, into a free slot
+	for (uint8_t i = 0; i < HTTP_CONNECTIONS; i++) {
+		Request &request = m_slots[i];
+
+		if (request.state == STATE_IDLE) {
+			if ((request.connection = m_listener.accept()) != NULL) {
+				request.state = STATE_HEADERS;
+				request.method = METHOD_OTHER;
+				request.status = 0;
+				request.path[0] = '\0';
+				request.lineLength = 0;
+				request.bodyLength = 0;
+				request.contentLength = 0;
+				request.truncated = false;
+				request.opened = millis();
+			}
+			break;
+		}
+	}
+
+	for (uint8_t i = 0; i < HTTP_CONNECTIONS; i++) {
+		Request &request = m_slots[i];
+
+		if (request.state != STATE_HEADERS && request.state != STATE_BODY) {
+			continue;
+		}
+		int n = request.connection->read(data, sizeof(data));
+		if (n < 0) {
+			// gone before its request was complete
+			m_errors++;
+			close(request);
+			continue;
+		}
+		for (int j = 0; j < n && request.state != STATE_READY; j++) {
+			receive(request, data[j]);
+		}
+		if (request.state != STATE_READY && millis() - request.opened > HTTP_TIMEOUT) {
+			request.status = 408;
+			request.state = STATE_READY;
+		}
+	}
+
+	// the response buffer goes to the next request waiting for it
+	if (m_responder < 0) {
+		for (uint8_t i = 0; i < HTTP_CONNECTIONS; i++) {
+			uint8_t slot = (m_next + i) % HTTP_CONNECTIONS;
+
+			if (m_slots[slot].state == STATE_READY) {
+				m_responder = slot;
+				m_next = (slot + 1) % HTTP_CONNECTIONS;
+				respond(m_slots[slot]);
+				break;
+			}
+		}
+	}
+
+	if (m_responder >= 0) {
+		Request &request = m_slots[m_responder];
+		size_t left = m_outLength - m_outStart;
+		int n = request.connection->write(m_out + m_outStart, left < HTTP_POLL_BYTES ? left : HTTP_POLL_BYTES);
+		if (n < 0) {
+			m_errors++;
+			close(request);
+		} else if ((m_outStart += n) >= m_outLength) {
+			close(request);
+		}
+	}
+
+	unsigned long elapsed = micros() - start;
+	if (elapsed > m_pollMax) {
+		m_pollMax = elapsed;
+	}
+}
+
+// Response bytes go to the buffer, past its end the response is dropped
+size_t HttpModule::write(uint8_t c) {
+	if (m_outLength >= HTTP_RESPONSE_SIZE) {
+		m_overflow = true;
+		return 0;
+	}
+	m_out[m_outLength++] = c;
+
+	return 1;
+}
+
+// Lines are cut at HTTP_LINE_SIZE, only the request line and
+// Content-Length matter
+void HttpModule::receive(Request &request, uint8_t c) {
+	if (request.state == STATE_BODY) {
+		request.body[request.bodyLength++] = c;
+		if (request.bodyLength == request.contentLength) {
+			request.body[request.bodyLength] = '\0';
+			request.state = STATE_READY;
+		}
+		return;
+	}
+
+	if (c == '\n') {
+		if (request.lineLength > 0 && request.line[request.lineLength - 1] == '\r') {
+			request.lineLength--;
+		}
+		request.line[request.lineLength] = '\0';
+		line(request);
+		request.lineLength = 0;
+		request.truncated = false;
+	} else if (request.lineLength < HTTP_LINE_SIZE - 1) {
+		request.line[request.lineLength++] = c;
+	} else {
+		request.truncated = true;
+	}
+}
+
+void HttpModule::line(Request &request) {
+	if (request.path[0] == '\0') {
+		// request line: method, path and version
+		char *path = strchr(request.line, ' ');
+		char *version = path != NULL ? strchr(path + 1, ' ') : NULL;
+
+		if (request.truncated) {
+			request.status = 414;
+			request.state = STATE_READY;
+			return;
+		}
+		if (version == NULL || path[1] != '/') {
+			request.status = 400;
+			request.state = STATE_READY;
+			return;
+		}
+		*path = '\0';
+		*version = '\0';
+		request.method = !strcmp(request.line, "GET") ? METHOD_GET : (!strcmp(request.line, "PUT") ? METHOD_PUT : METHOD_OTHER);
+		strcpy(request.path, path + 1);
+	} else if (request.line[0] == '\0') {
+		if (request.contentLength >= HTTP_BODY_SIZE) {
+			request.status = 413;
+			request.state = STATE_READY;
+		} else if (request.contentLength > 0) {
+			request.state = STATE_BODY;
+		} else {
+			request.body[0] = '\0';
+			request.state = STATE_READY;
+		}
+	} else if (!strncasecmp(request.line, "Content-Length:", 15)) {
+		request.contentLength = strtoul(request.line + 15, NULL, 10);
+	}
+}
+
+// Renders the response of a complete request into the buffer
+void HttpModule::respond(Request &request) {
+	char *query = strchr(request.path, '?');
+	int8_t z;
+
+	request.state = STATE_RESPONSE;
+	m_overflow = false;
+	m_outLength = HTTP_HEADER_SIZE;
+	if (request.status != 0) {
+		reply(request.status, NULL);
+		return;
+	}
+
+	Power.boost();
+	m_requests++;
+	if (query != NULL) {
+		*query++ = '\0';
+	}
+	z = zone(query);
+
+	if (!strcmp(request.path, "/status") && request.method == METHOD_GET) {
+		renderStatus();
+		reply(200, "application/json");
+	} else if (!strcmp(request.path, "/metrics") && request.method == METHOD_GET) {
+		renderMetrics();
+		reply(200, "text/plain; version=0.0.4");
+	} else if (!strcmp(request.path, "/timetable") && request.method == METHOD_GET && z >= 0) {
+		renderTimetable(z);
+		reply(200, "application/json");
+	} else if (!strcmp(request.path, "/timetable") && request.method == METHOD_PUT && z >= 0) {
+		reply(updateTimetable(z, request.body) ? 204 : 400, NULL);
+	} else if (!strcmp(request.path, "/timetable")) {
+		reply(z < 0 ? 400 : 405, NULL);
+	} else if (!strcmp(request.path, "/override") && request.method == METHOD_GET) {
+		renderOverrides();
+		reply(200, "application/json");
+	} else if (!strcmp(request.path, "/override") && request.method == METHOD_PUT && z >= 0) {
+		reply(Thimo.override(z, request.body) ? 204 : 400, NULL);
+	} else if (!strcmp(request.path, "/override")) {
+		reply(z < 0 ? 400 : 405, NULL);
+	} else if (!strcmp(request.path, "/status") || !strcmp(request.path, "/metrics")) {
+		reply(405, NULL);
+	} else {
+		reply(404, NULL);
+	}
+}
+
+// The headers go right in front of the body rendered past HTTP_HEADER_SIZE
+void HttpModule::reply(uint16_t status, const char *type) {
+	const char *reason;
+	char header[HTTP_HEADER_SIZE];
+	int n;
+
+	if (m_overflow) {
+		status = 500;
+	}
+	if (type == NULL || status >= 400) {
+		m_outLength = HTTP_HEADER_SIZE;
+	}
+
+	switch (status) {
+		case 200: reason = "OK"; break;
+		case 204: reason = "No Content"; break;
+		case 400: reason = "Bad Request"; break;
+		case 404: reason = "Not Found"; break;
+		case 405: reason = "Method Not Allowed"; break;
+		case 408: reason = "Request Timeout"; break;
+		case 413: reason = "Payload Too Large"; break;
+		case 414: reason = "URI Too Long"; break;
+		default: reason = "Internal Server Error"; break;
+	}
+	if (status >= 400) {
+		m_errors++;
+	}
+
+	if (m_outLength > HTTP_HEADER_SIZE) {
+		n = snprintf(header, sizeof(header), "HTTP/1.1 %u %s\r\nContent-Type: %s\r\nContent-Length: %u\r\nConnection: close\r\n\r\n",
+			status, reason, type, (unsigned)(m_outLength - HTTP_HEADER_SIZE));
+	} else {
+		n = snprintf(header, sizeof(header), "HTTP/1.1 %u %s\r\nContent-Length: 0\r\nConnection: close\r\n\r\n", status, reason);
+	}
+	m_outStart = HTTP_HEADER_SIZE - n;
+	memcpy(m_out + m_outStart, header, n);
+}
+
+void HttpModule::close(Request &request) {
+	if (m_responder >= 0 && &m_slots[m_responder] == &request) {
+		m_responder = -1;
+	}
+	request.connection->close();
+	request.connection = NULL;
+	request.state = STATE_IDLE;
+}
+
+// zone=n in the query, 0 without it, -1 out of range
+int8_t HttpModule::zone(const char *query) const {
+	const char *param = query != NULL ? strstr(query, "zone=") : NULL;
+
+	if (param == NULL) {
+		return 0;
+	}
+	char *end;
+	unsigned long z = strtoul(param + 5, &end, 10);
+
+	return end != param + 5 && z < ZONE_COUNT ? (int8_t)z : -1;
+}
+
+void HttpModule::renderStatus() {
+	DateTime now = Clock.now();
+
+	print("{\"time\":");
+	print(Clock.utc());
+	print(",\"uptime\":");
+	print(millis() / 1000UL);
+	print(",\"zones\":[");
+	for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+		const Zone &zone = Thimo.zone(z);
+
+		print(z > 0 ? ",{\"zone\":" : "{\"zone\":");
+		print(z);
+		print(",\"temperature\":");
+		if (zone.sampled && !zone.failed) {
+			print(zone.temperature, 1);
+		} else {
+			print("null");
+		}
+		print(",\"humidity\":");
+		if (zone.humid && !zone.failed) {
+			print(zone.humidity, 1);
+		} else {
+			print("null");
+		}
+		print(",\"setpoint\":");
+		print(Thimo.setpoint(z, now.hour()) / 10.0f, 1);
+		print(",\"target\":");
+		print(Thimo.target(z, now) / 10.0f, 1);
+		print(",\"relay\":");
+		print(zone.relay ? "true" : "false");
+		print(",\"window\":");
+		print(zone.window.open() ? "true" : "false");
+		print(",\"mode\":");
+		print(zone.manualMode ? "\"manual\"" : "\"auto\"");
+		print(",\"control\":");
+		print(zone.controller.mode() == Controller::PID ? "\"pid\"" : "\"hysteresis\"");
+		print(",\"override\":");
+		if (Overrides.active(z) != NULL) {
+			print("\"");
+			print(OverrideModule::name(Overrides.active(z)->kind));
+			print("\"}");
+		} else {
+			print("null}");
+		}
+	}
+	print("]}\n");
+}
+
+void HttpModule::renderMetrics() {
+	type("thimo_uptime_seconds", "counter");
+	metric("thimo_uptime_seconds", millis() / 1000UL);
+	type("thimo_loop_passes_total", "counter");
+	metric("thimo_loop_passes_total", Watchdog.passes());
+	type("thimo_loop_busy_milliseconds_total", "counter");
+	metric("thimo_loop_busy_milliseconds_total", Watchdog.passTime());
+	type("thimo_loop_busy_max_microseconds", "gauge");
+	metric("thimo_loop_busy_max_microseconds", Watchdog.passMax());
+	type("thimo_control_passes_total", "counter");
+	metric("thimo_control_passes_total", Thimo.controlCount());
+	type("thimo_control_microseconds_total", "counter");
+	metric("thimo_control_microseconds_total", Thimo.controlTime());
+	type("thimo_watchdog_stalls_total", "counter");
+	metric("thimo_watchdog_stalls_total", Watchdog.stalls());
+	type("thimo_i2c_lcd_frames_total", "counter");
+	metric("thimo_i2c_lcd_frames_total", LCD.frames());
+	type("thimo_i2c_lcd_busy_skips_total", "counter");
+	metric("thimo_i2c_lcd_busy_skips_total", LCD.busySkips());
+	type("thimo_log_dropped_total", "counter");
+	metric("thimo_log_dropped_total", Log.dropped());
+	type("thimo_http_requests_total", "counter");
+	metric("thimo_http_requests_total", m_requests);
+	type("thimo_http_errors_total", "counter");
+	metric("thimo_http_errors_total", m_errors);
+	type("thimo_http_poll_max_microseconds", "gauge");
+	metric("thimo_http_poll_max_microseconds", m_pollMax);
+	type("thimo_ntp_syncs_total", "counter");
+	metric("thimo_ntp_syncs_total", Ntp.syncs());
+	type("thimo_ntp_failures_total", "counter");
+	metric("thimo_ntp_failures_total", Ntp.failures());
+#ifndef THIMO_SIMULATION
+	type("thimo_rtc_drift_ppm", "gauge");
+	metric("thimo_rtc_drift_ppm", Clock.record().drift, 3);
+#endif
+
+	type("thimo_sensor_captures_total", "counter");
+	for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+		metric("thimo_sensor_captures_total", z, Thimo.zone(z).sensor->captures());
+	}
+	type("thimo_sensor_errors_total", "counter");
+	for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+		metric("thimo_sensor_errors_total", z, Thimo.zone(z).sensor->errors());
+	}
+	type("thimo_temperature_celsius", "gauge");
+	for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+		metric("thimo_temperature_celsius", z, Thimo.temperature(z), 1);
+	}
+	type("thimo_humidity_percent", "gauge");
+	for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+		metric("thimo_humidity_percent", z, Thimo.humidity(z), 1);
+	}
+	type("thimo_relay_on", "gauge");
+	for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+		metric("thimo_relay_on", z, (uint32_t)Thimo.relay(z));
+	}
+	type("thimo_relay_on_seconds_total", "counter");
+	for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+		metric("thimo_relay_on_seconds_total", z, Meter.zone(z).onTime);
+	}
+	type("thimo_relay_starts_total", "counter");
+	for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+		metric("thimo_relay_starts_total", z, Meter.zone(z).cycles);
+	}
+	type("thimo_relay_short_starts_total", "counter");
+	for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+		metric("thimo_relay_short_starts_total", z, Meter.zone(z).shortCycles);
+	}
+}
+
+void HttpModule::renderTimetable(uint8_t z) {
+	print("[");
+	for (uint8_t h = 0; h < 24; h++) {
+		if (h > 0) {
+			print(",");
+		}
+		print(Thimo.timetable(z, h));
+	}
+	print("]\n");
+}
+
+// Start and end are local, they go out in UTC like the status time
+void HttpModule::renderOverrides() {
+	print("[");
+	for (uint8_t i = 0; i < Overrides.count(); i++) {
+		const Override &entry = Overrides.entry(i);
+
+		print(i > 0 ? ",{\"kind\":\"" : "{\"kind\":\"");
+		print(OverrideModule::name(entry.kind));
+		print("\",\"zones\":");
+		print(entry.zones);
+		print(",\"setpoint\":");
+		print(entry.setpoint / 10.0f, 1);
+		print(",\"start\":");
+		print(Clock.toUtc(entry.start));
+		print(",\"end\":");
+		if (entry.end == OVERRIDE_FOREVER) {
+			print("null}");
+		} else {
+			print(Clock.toUtc(entry.end));
+			print("}");
+		}
+	}
+	print("]\n");
+}
+
+// Exactly 24 whole temperatures, a JSON array or any other separators
+bool HttpModule::updateTimetable(uint8_t z, char *body) {
+	uint8_t table[24];
+	uint8_t count = 0;
+	char *p = body;
+
+	while (*p != '\0') {
+		if (*p == '-' || *p == '.') {
+			return false;
+		}
+		if (*p < '0' || *p > '9') {
+			p++;
+			continue;
+		}
+		unsigned long value = strtoul(p, &p, 10);
+		if (count >= 24 || value > 255) {
+			return false;
+		}
+		table[count++] = value;
+	}
+
+	return count == 24 && Thimo.timetable(z, table);
+}
+
+void HttpModule::type(const char *name, const char *type) {
+	print("# TYPE ");
+	print(name);
+	print(" ");
+	print(type);
+	print("\n");
+}
+
+void HttpModule::metric(const char *name, uint32_t value) {
+	print(name);
+	print(" ");
+	print(value);
+	print("\n");
+}
+
+void HttpModule::metric(const char *name, float value, uint8_t decimals) {
+	print(name);
+	print(" ");
+	print(value, decimals);
+	print("\n");
+}
+
+void HttpModule::metric(const char *name, uint8_t z, uint32_t value) {
+	print(name);
+	print("{zone=\"");
+	print(z);
+	print("\"} ");
+	print(value);
+	print("\n");
+}
+
+void HttpModule::metric(const char *name, uint8_t z, float value, uint8_t decimals) {
+	print(name);
+	print("{zone=\"");
+	print(z);
+	print("\"} ");
+	print(value, decimals);
+	print("\n");
+}
+
+HttpModule Http(listener);
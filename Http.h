@@ -0,0 +1,197 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Http.h
+ * Created on: 19 Oct 2026
+ * Description: Thimo HTTP status server
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#ifndef _THIMO_HTTP_H_
+#define _THIMO_HTTP_H_
+
+#include <Arduino.h>
+#include "Zone.h"
+#include "config.h"
+
+#ifdef ESP32
+#include <WiFi.h>
+#endif
+
+#define HTTP_HEADER_SIZE			128		// room kept for the headers ahead of a body
+#define HTTP_RESPONSE_SIZE			(HTTP_RESPONSE_BASE + HTTP_RESPONSE_ZONE * ZONE_COUNT)
+
+// An accepted connection, neither side ever waits
+class HttpConnection {
+public:
+	virtual ~HttpConnection() {}
+
+	virtual int read(uint8_t *data, size_t n) = 0;			// bytes read, 0 none yet, -1 closed
+	virtual int write(const uint8_t *data, size_t n) = 0;	// bytes taken, -1 closed
+	virtual void close() = 0;
+};
+
+// Hands out the connections to the server one at a time
+class HttpListener {
+public:
+	virtual ~HttpListener() {}
+
+	virtual bool begin() = 0;					// false when there's no network to serve on
+	virtual HttpConnection *accept() = 0;		// a new connection, or NULL
+};
+
+#ifdef ESP32
+class WiFiConnection : public HttpConnection {
+public:
+	WiFiConnection();
+
+	void open(const WiFiClient &client);
+	inline bool used() const { return m_used; }
+
+	virtual int read(uint8_t *data, size_t n);
+	virtual int write(const uint8_t *data, size_t n);
+	virtual void close();
+private:
+	WiFiClient m_client;
+	bool m_used;
+};
+
+// Joins WIFI_SSID, the server starts listening once the link is up
+class WiFiListener : public HttpListener {
+public:
+	WiFiListener(uint16_t port);
+
+	virtual bool begin();
+	virtual HttpConnection *accept();
+private:
+	WiFiServer m_server;
+	WiFiConnection m_connections[HTTP_CONNECTIONS];
+	bool m_listening;
+};
+#elif defined(__linux__)
+class SocketConnection : public HttpConnection {
+public:
+	SocketConnection();
+
+	inline void open(int fd) { m_fd = fd; }
+	inline bool used() const { return m_fd >= 0; }
+
+	virtual int read(uint8_t *data, size_t n);
+	virtual int write(const uint8_t *data, size_t n);
+	virtual void close();
+private:
+	int m_fd;
+};
+
+// Host builds listen on a local TCP port, for load tests
+class SocketListener : public HttpListener {
+public:
+	SocketListener(uint16_t port);
+
+	virtual bool begin();
+	virtual HttpConnection *accept();
+private:
+	uint16_t m_port;
+	int m_server;
+	SocketConnection m_connections[HTTP_CONNECTIONS];
+};
+#endif
+
+// A small HTTP/1.1 server:
+//
+//   GET /status             -> JSON snapshot of every zone
+//   GET /metrics            -> Prometheus text format counters
+//   GET /timetable[?zone=n] -> JSON array of the 24 hourly temperatures
+//   PUT /timetable[?zone=n] -> 24 temperatures, any separators, 204
+//   GET /override           -> JSON array of the overrides, UTC times
+//   PUT /override[?zone=n]  -> an override as the console takes it, 204
+//
+// It works like the console. Up to HTTP_CONNECTIONS requests are read at
+// once, at most HTTP_POLL_BYTES of each per poll(), so a slow client
+// neither holds the loop nor the other clients. Complete requests take
+// turns on a single response buffer: the response is rendered once into
+// it, the headers go in front of the body when its length is known, and
+// at most HTTP_POLL_BYTES of it are sent per poll(). Nothing is
+// allocated. Every response closes the connection, a request not in after
+// HTTP_TIMEOUT is dropped.
+class HttpModule : public Print {
+public:
+	HttpModule(HttpListener &listener);
+
+	void begin();
+	void poll();
+	inline bool online() const { return m_online; }	// light sleep would drop the link
+
+	inline uint32_t requests() const { return m_requests; }
+	inline uint32_t errors() const { return m_errors; }		// answered 4xx or 5xx, or dropped
+	inline uint32_t pollMax() const { return m_pollMax; }	// us
+
+	virtual size_t write(uint8_t);
+	using Print::write;
+private:
+	typedef enum {
+		STATE_IDLE,
+		STATE_HEADERS,
+		STATE_BODY,
+		STATE_READY,		// waits for the response buffer
+		STATE_RESPONSE
+	} State;
+
+	typedef enum {
+		METHOD_GET,
+		METHOD_PUT,
+		METHOD_OTHER
+	} Method;
+
+	struct Request {
+		HttpConnection *connection;
+		State state;
+		Method method;
+		uint16_t status;		// refused before it was routed, 0 if not
+		char line[HTTP_LINE_SIZE];
+		size_t lineLength;
+		bool truncated;			// the line didn't fit
+		char path[HTTP_LINE_SIZE];
+		char body[HTTP_BODY_SIZE];
+		size_t bodyLength;
+		size_t contentLength;
+		unsigned long opened;
+	};
+
+	void receive(Request &request, uint8_t c);
+	void line(Request &request);
+	void respond(Request &request);
+	void reply(uint16_t status, const char *type);
+	void close(Request &request);
+	int8_t zone(const char *query) const;
+	void renderStatus();
+	void renderMetrics();
+	void renderTimetable(uint8_t z);
+	bool updateTimetable(uint8_t z, char *body);
+	void renderOverrides();
+	void type(const char *name, const char *type);
+	void metric(const char *name, uint32_t value);
+	void metric(const char *name, float value, uint8_t decimals);
+	void metric(const char *name, uint8_t z, uint32_t value);
+	void metric(const char *name, uint8_t z, float value, uint8_t decimals);
+
+	HttpListener &m_listener;
+	bool m_online;
+	Request m_slots[HTTP_CONNECTIONS];
+	int8_t m_responder;			// slot the response buffer is for, -1 if none
+	uint8_t m_next;				// next slot to get the buffer, round robin
+	bool m_overflow;			// the response didn't fit
+	uint8_t m_out[HTTP_RESPONSE_SIZE];
+	size_t m_outStart;
+	size_t m_outLength;
+	uint32_t m_requests;
+	uint32_t m_errors;
+	uint32_t m_pollMax;
+};
+
+extern HttpModule Http;
+
+#endif
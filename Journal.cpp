@@ -0,0 +1,103 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Journal.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo runtime state journal
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Journal.h"
+#include "Clock.h"
+#include "Codec.h"
+
+#ifdef ESP32
+#include <esp_system.h>
+#else
+#define RTC_NOINIT_ATTR
+#endif
+
+#define JOURNAL_SEED				0x4a	// cleared memory doesn't pass for a record
+
+static_assert(sizeof(JournalRecord) == 8 + 4 * ZONE_COUNT, "the journal record has no padding");
+
+static RTC_NOINIT_ATTR JournalRecord slots[2];
+
+JournalModule::JournalModule() :
+	m_pending(false),
+	m_changed(0UL),
+	m_slot(0),
+	m_writes(0) {
+	memset(&m_record, 0, sizeof(m_record));
+}
+
+// The newest good slot, false if there's none or the chip was powered up
+// and RTC memory holds noise
+bool JournalModule::load(JournalRecord &record) {
+	int8_t found = -1;
+
+#ifdef ESP32
+	if (esp_reset_reason() == ESP_RST_POWERON) {
+		return false;
+	}
+#endif
+	for (uint8_t s = 0; s < 2; s++) {
+		const JournalRecord &slot = slots[s];
+		if (slot.crc != crc(slot)) {
+			continue;
+		}
+		if (found < 0 || (int8_t)(slot.sequence - slots[found].sequence) > 0) {
+			found = s;
+		}
+	}
+	if (found < 0) {
+		return false;
+	}
+
+	record = slots[found];
+	m_record = record;
+	m_slot = found ^ 1;
+
+	return true;
+}
+
+void JournalModule::save(const JournalRecord &record) {
+	// crc and sequence are filled in on write
+	bool changed = record.view != m_record.view || record.zone != m_record.zone ||
+		memcmp(record.zones, m_record.zones, sizeof(record.zones));
+
+	if (!changed && record.time - m_record.time < JOURNAL_REFRESH) {
+		return;
+	}
+
+	if (!m_pending) {
+		m_pending = true;
+		m_changed = Clock.millis();
+	}
+	m_record.view = record.view;
+	m_record.zone = record.zone;
+	m_record.time = record.time;
+	memcpy(m_record.zones, record.zones, sizeof(record.zones));
+}
+
+void JournalModule::poll() {
+	if (!m_pending || (Clock.millis() - m_changed) < JOURNAL_COALESCE) {
+		return;
+	}
+
+	m_record.sequence++;
+	m_record.crc = crc(m_record);
+	slots[m_slot] = m_record;
+	m_slot ^= 1;
+	m_writes++;
+	m_pending = false;
+}
+
+uint8_t JournalModule::crc(const JournalRecord &record) {
+	return crc8((const uint8_t *)&record + 1, sizeof(record) - 1, JOURNAL_SEED);
+}
+
+JournalModule Journal;
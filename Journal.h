@@ -0,0 +1,75 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Journal.h
+ * Created on: 19 Oct 2026
+ * Description: Thimo runtime state journal
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#ifndef _THIMO_JOURNAL_H_
+#define _THIMO_JOURNAL_H_
+
+#include <Arduino.h>
+#include "Zone.h"
+#include "config.h"
+
+#define JOURNAL_NONE				-32768	// no temperature sampled yet
+
+// zone flags
+#define JOURNAL_MANUAL				0x01
+#define JOURNAL_PID					0x02
+
+struct JournalZone {
+	int16_t temperature;	// tenths of °C, JOURNAL_NONE before the first sample
+	uint8_t flags;
+	uint8_t manual;			// manual mode setpoint, half °C
+};
+
+// No padding: the CRC covers every byte after its own
+struct JournalRecord {
+	uint8_t crc;
+	uint8_t sequence;		// the newer of the two slots wins
+	uint8_t view;
+	uint8_t zone;			// shown on the display
+	uint32_t time;			// UTC unixtime the temperatures were taken at
+	JournalZone zones[ZONE_COUNT];
+};
+
+// The runtime state the NVRAM doesn't hold: modes, the view and the last
+// temperature of every zone, so control resumes right after a reset instead
+// of waiting for the sensors. The DS1307 has no room left for it, it lives in
+// RTC memory, which survives every reset but a power cycle. Two slots are
+// written in turn, a reset in the middle of a write leaves the other one
+// good; a slot counts if its CRC matches.
+//
+// save() only takes a record that differs from the last one written, the
+// changes of a JOURNAL_COALESCE window go out together on poll(). A record
+// whose only change is the time is taken every JOURNAL_REFRESH seconds.
+class JournalModule {
+public:
+	JournalModule();
+
+	bool load(JournalRecord &record);
+	void save(const JournalRecord &record);
+	void poll();
+
+	inline bool pending() const { return m_pending; }
+	inline unsigned long changed() const { return m_changed; }	// the write is due JOURNAL_COALESCE after
+	inline uint32_t writes() const { return m_writes; }
+private:
+	JournalRecord m_record;		// last saved, written or waiting to be
+	bool m_pending;
+	unsigned long m_changed;	// first change since the last write
+	uint8_t m_slot;				// next slot to write
+	uint32_t m_writes;
+
+	static uint8_t crc(const JournalRecord &record);
+};
+
+extern JournalModule Journal;
+
+#endif
@@ -13,19 +13,38 @@
 #include "LCD.h"
 #include "config.h"
 
-LCDModule::LCDModule(uint8_t addr) : m_addr(addr) {
+LCDModule::LCDModule(LCDBus &bus) : m_bus(bus) {
 	m_displayFunction = LCD_4BITMODE | LCD_1LINE | LCD_5x8DOTS;
-	m_backlight = LCD_NOBACKLIGHT;
+	m_backlight = false;
+	m_initStep = INIT_POWER;
+	m_initTimer = 0UL;
+	m_initDelay = 0UL;
+	m_cols = 0;
+	m_col = 0;
+	m_row = 0;
+	m_buffered = false;
+	m_frontValid = false;
+	m_pending = false;
+	m_frames = 0;
+	m_busySkips = 0;
 }
 
 void LCDModule::begin(uint8_t cols, uint8_t rows, uint8_t dotsize) {
-	Wire.begin();
+	start(cols, rows, dotsize);
+	while (!poll()) {
+		// blocking initialization
+	}
+}
+
+void LCDModule::start(uint8_t cols, uint8_t rows, uint8_t dotsize) {
+	m_bus.begin();
 	
 	if (rows > 1) {
 		m_displayFunction |= LCD_2LINE;
 	}
 
-	m_numlines = rows;
+	m_numlines = rows < LCD_MAX_ROWS ? rows : LCD_MAX_ROWS;
+	m_cols = cols < LCD_MAX_COLS ? cols : LCD_MAX_COLS;
 
 	setRowOffsets(0x00, 0x40, 0x00 + cols, 0x40 + cols); 
 	
@@ -37,58 +56,147 @@ void LCDModule::begin(uint8_t cols, uint8_t rows, uint8_t dotsize) {
 	// SEE PAGE 45/46 FOR INITIALIZATION SPECIFICATION!
 	// according to datasheet, we need at least 40ms after power rises above 2.7V
 	// before sending commands. Arduino can turn on way befer 4.5V so we'll wait 50
-	delay(50);
-
-	// Now we pull both RS and R/W low to begin commands
-	expanderWrite(m_backlight); // reset expander and turn backlight off (Bit 8 =1)
-	delay(1000);
-
-	//put the LCD into 4 bit mode
-	// this is according to the hitachi HD44780 datasheet
-	// figure 24, pg 46
-
-	// we start in 8bit mode, try to set 4 bit mode
-	write4bits(0x03 << 4);
-	delayMicroseconds(4500); // wait min 4.1ms
-
-	// second try
-	write4bits(0x03 << 4);
-	delayMicroseconds(4500); // wait min 4.1ms
-
-	// third go!
-	write4bits(0x03 << 4);
-	delayMicroseconds(150);
-
-	// finally, set to 4-bit interface
-	write4bits(0x02 << 4);
-
-	// set # lines, font size, etc.
-	command(LCD_FUNCTIONSET | m_displayFunction);
+	m_initStep = INIT_POWER;
+	wait(50000UL);
+}
 
-	// turn the display on with no cursor or blinking default
-	m_displayControl = LCD_DISPLAYON | LCD_CURSOROFF | LCD_BLINKOFF;
-	display();
+// Runs the datasheet initialization sequence one step at a time, so the long
+// power-up waits don't hold the caller. Returns true once the display is ready.
+bool LCDModule::poll() {
+	if (m_initStep == INIT_DONE) {
+		// a frame that found the bus busy goes out as soon as it's free
+		if (m_pending && !m_bus.busy()) {
+			swap();
+		}
+		return true;
+	}
 
-	// clear it off
-	clear();
+	if ((micros() - m_initTimer) < m_initDelay) {
+		return false;
+	}
 
-	// Initialize to default text direction (for roman languages)
-	m_displayMode = LCD_ENTRYLEFT | LCD_ENTRYSHIFTDECREMENT;
+	switch (m_initStep) {
+		case INIT_POWER:
+			// Now we pull both RS and R/W low to begin commands
+			m_bus.backlight(m_backlight); // reset expander and turn backlight off (Bit 8 =1)
+			wait(1000000UL);
+			break;
+		case INIT_RESET:
+			//put the LCD into 4 bit mode
+			// this is according to the hitachi HD44780 datasheet
+			// figure 24, pg 46
+
+			// we start in 8bit mode, try to set 4 bit mode
+			m_bus.write4bits(0x03 << 4);
+			wait(4500); // wait min 4.1ms
+			break;
+		case INIT_8BIT1:
+			// second try
+			m_bus.write4bits(0x03 << 4);
+			wait(4500); // wait min 4.1ms
+			break;
+		case INIT_8BIT2:
+			// third go!
+			m_bus.write4bits(0x03 << 4);
+			wait(150);
+			break;
+		case INIT_8BIT3:
+			// finally, set to 4-bit interface
+			m_bus.write4bits(0x02 << 4);
+			wait(0);
+			break;
+		case INIT_4BIT:
+			// set # lines, font size, etc.
+			command(LCD_FUNCTIONSET | m_displayFunction);
+
+			// turn the display on with no cursor or blinking default
+			m_displayControl = LCD_DISPLAYON | LCD_CURSOROFF | LCD_BLINKOFF;
+			display();
+
+			// clear it off
+			clear();
+
+			// Initialize to default text direction (for roman languages)
+			m_displayMode = LCD_ENTRYLEFT | LCD_ENTRYSHIFTDECREMENT;
+
+			// set the entry mode
+			command(LCD_ENTRYMODESET | m_displayMode);
+			break;
+	}
+	m_initStep++;
 
-	// set the entry mode
-	command(LCD_ENTRYMODESET | m_displayMode);
+	return m_initStep == INIT_DONE;
 }
 
 void LCDModule::clear() {
+	if (m_buffered) {
+		memset(m_back, ' ', sizeof(m_back));
+		m_col = m_row = 0;
+		return;
+	}
 	command(LCD_CLEARDISPLAY); // clear display, set cursor position to zero
 	delayMicroseconds(2000);   // this command takes a long time!
+	m_frontValid = false;
 }
 
 void LCDModule::home() {
+	if (m_buffered) {
+		m_col = m_row = 0;
+		return;
+	}
 	command(LCD_RETURNHOME); // set cursor position to zero
 	delayMicroseconds(2000); // this command takes a long time!
 }
 
+// Starts composing a frame: until swap() everything printed goes to the
+// back buffer, the display is left alone.
+void LCDModule::frame() {
+	m_buffered = true;
+	m_col = m_row = 0;
+}
+
+// Sends only the cells that differ from what the display shows, one address
+// command per changed run. Returns false when the previous transfer is still
+// on the bus: the frame stays pending and poll() sends it later, so a frame
+// is never written over one in flight.
+bool LCDModule::swap() {
+	size_t n = 0;
+
+	m_buffered = false;
+	if (m_bus.busy()) {
+		if (!m_pending) {
+			m_busySkips++;
+		}
+		m_pending = true;
+		return false;
+	}
+	m_pending = false;
+
+	for (uint8_t row = 0; row < m_numlines; row++) {
+		bool run = false;
+		for (uint8_t col = 0; col < m_cols; col++) {
+			if (m_frontValid && m_back[row][col] == m_front[row][col]) {
+				run = false;
+				continue;
+			}
+			if (!run) {
+				m_transfer[n++] = LCD_SETDDRAMADDR | (col + m_rowOffsets[row]);
+				run = true;
+			}
+			m_transfer[n++] = (Rs << 8) | m_back[row][col];
+			m_front[row][col] = m_back[row][col];
+		}
+	}
+	m_frontValid = true;
+
+	if (n > 0) {
+		m_bus.submit(m_transfer, n);
+		m_frames++;
+	}
+
+	return true;
+}
+
 void LCDModule::setCursor(uint8_t col, uint8_t row) {
 	const size_t maxlines = sizeof(m_rowOffsets) / sizeof(*m_rowOffsets);
 	
@@ -99,6 +207,12 @@ void LCDModule::setCursor(uint8_t col, uint8_t row) {
 	if (row > m_numlines) {
 		row = m_numlines - 1;	// we count rows starting w/0
 	}
+
+	if (m_buffered) {
+		m_col = col;
+		m_row = row;
+		return;
+	}
 	
 	command(LCD_SETDDRAMADDR | (col + m_rowOffsets[row]));
 }
@@ -162,13 +276,18 @@ void LCDModule::autoscroll() {
 }
 
 void LCDModule::backlight(void) {
-	m_backlight = LCD_BACKLIGHT;
-	expanderWrite(0);
+	m_backlight = true;
+	m_bus.backlight(true);
 }
 
 void LCDModule::noBacklight(void) {
-	m_backlight = LCD_NOBACKLIGHT;
-	expanderWrite(0);
+	m_backlight = false;
+	m_bus.backlight(false);
+}
+
+void LCDModule::wait(unsigned long us) {
+	m_initTimer = micros();
+	m_initDelay = us;
 }
 
 void LCDModule::setRowOffsets(int row0, int row1, int row2, int row3) {
@@ -182,7 +301,7 @@ void LCDModule::createChar(uint8_t location, uint8_t charmap[]) {
 	location &= 0x7; // we only have 8 locations 0-7
 	command(LCD_SETCGRAMADDR | (location << 3));
 	for (int i = 0; i < 8; i++) {
-		write(charmap[i]);
+		send(charmap[i], Rs); // CGRAM, the frame buffers are unaffected
 	}
 }
 
@@ -191,33 +310,40 @@ inline void LCDModule::command(uint8_t value) {
 }
 
 inline size_t LCDModule::write(uint8_t value) {
-	send(value, Rs); return 1;
-}
-
-void LCDModule::send(uint8_t value, uint8_t mode) {
-	uint8_t hinib = value & 0xf0;
-	uint8_t lonib = (value << 4) & 0xf0;
-	write4bits((hinib) | mode);
-	write4bits((lonib) | mode);
+	if (m_buffered) {
+		if (m_row < m_numlines && m_col < m_cols) {
+			m_back[m_row][m_col] = value;
+		}
+		m_col++;
+		return 1;
+	}
+	send(value, Rs);
+	m_frontValid = false;
+	return 1;
 }
 
-void LCDModule::write4bits(uint8_t value) {
-	expanderWrite(value);
-	pulseEnable(value);
+size_t LCDModule::write(const uint8_t *buffer, size_t size) {
+	if (m_buffered) {
+		for (size_t i = 0; i < size; i++) {
+			write(buffer[i]);
+		}
+		return size;
+	}
+	m_bus.send(buffer, size, Rs);
+	m_frontValid = false;
+	return size;
 }
 
-void LCDModule::expanderWrite(uint8_t value) {
-	Wire.beginTransmission(m_addr);
-	Wire.write((int)(value) | m_backlight);
-	Wire.endTransmission();
+void LCDModule::send(uint8_t value, uint8_t mode) {
+	m_bus.send(value, mode);
 }
 
-void LCDModule::pulseEnable(uint8_t value) {
-	expanderWrite(value | En); // En high
-	delayMicroseconds(1);	   // enable pulse must be >450ns
-
-	expanderWrite(value & ~En); // En low
-	delayMicroseconds(50);		// commands need > 37us to settle
-}
+#ifdef LCD_PARALLEL
+static ParallelBus<LCD_RS_PIN, LCD_EN_PIN, LCD_D4_PIN, LCD_D5_PIN, LCD_D6_PIN, LCD_D7_PIN, LCD_BL_PIN> bus;
+#elif defined(ESP32) && defined(LCD_ASYNC)
+static AsyncPCF8574Bus bus(LCD_I2C_ADDRESS, I2C_CLOCK);
+#else
+static PCF8574Bus bus(LCD_I2C_ADDRESS, I2C_CLOCK);
+#endif
 
-LCDModule LCD(LCD_I2C_ADDRESS);
+LCDModule LCD(bus);
@@ -14,7 +14,7 @@
 #define _THIMO_LCD_H_
 
 #include <Arduino.h>
-#include <Wire.h>
+#include "LCDBus.h"
 
 // commands
 #define LCD_CLEARDISPLAY			0x01
@@ -54,20 +54,30 @@
 #define LCD_5x10DOTS				0x04
 #define LCD_5x8DOTS					0x00
 
-// flags for backlight control
-#define LCD_BACKLIGHT				0x08
-#define LCD_NOBACKLIGHT				0x00
-
-#define En 							B00000100 // Enable bit
-#define Rw							B00000010 // Read/Write bit
-#define Rs							B00000001 // Register select bit
+// frame buffer geometry
+#define LCD_MAX_COLS				20
+#define LCD_MAX_ROWS				4
 
 class LCDModule : public Print
 {
 public:
-	LCDModule(uint8_t addr);
+	LCDModule(LCDBus &bus);
 
 	void begin(uint8_t cols, uint8_t rows, uint8_t charsize = LCD_5x8DOTS);
+	void start(uint8_t cols, uint8_t rows, uint8_t charsize = LCD_5x8DOTS);
+	bool poll();
+	inline bool ready() const { return m_initStep == INIT_DONE; }
+
+	void frame();
+	bool swap();
+	inline bool pending() const { return m_pending; }
+	inline bool busy() { return m_pending || m_bus.busy(); }
+	inline void wait() { m_bus.wait(); }	// the frame in flight is on the display
+	inline uint32_t frames() const { return m_frames; }
+	inline uint32_t busySkips() const { return m_busySkips; }
+	inline uint8_t cols() const { return m_cols; }
+	inline uint8_t rows() const { return m_numlines; }
+	inline const uint8_t *row(uint8_t r) const { return m_back[r]; }
 	
 	void clear();
 	void home();
@@ -95,22 +105,45 @@ public:
 	void createChar(uint8_t, uint8_t[]);
 	void setCursor(uint8_t, uint8_t);
 	virtual size_t write(uint8_t);
+	virtual size_t write(const uint8_t *buffer, size_t size);
 	void command(uint8_t);
 	
 	using Print::write;
 private:
+	enum {
+		INIT_POWER,
+		INIT_RESET,
+		INIT_8BIT1,
+		INIT_8BIT2,
+		INIT_8BIT3,
+		INIT_4BIT,
+		INIT_DONE
+	};
+
+	void wait(unsigned long us);
 	void send(uint8_t, uint8_t);
-	void write4bits(uint8_t);
-	void expanderWrite(uint8_t);
-	void pulseEnable(uint8_t);
 	
-	uint8_t m_addr;
+	LCDBus &m_bus;
+	uint8_t m_front[LCD_MAX_ROWS][LCD_MAX_COLS];
+	uint8_t m_back[LCD_MAX_ROWS][LCD_MAX_COLS];
+	uint16_t m_transfer[LCD_TRANSFER_SIZE];
+	uint8_t m_cols;
+	uint8_t m_col;
+	uint8_t m_row;
+	bool m_buffered;
+	bool m_frontValid;
+	bool m_pending;
+	uint32_t m_frames;
+	uint32_t m_busySkips;
 	uint8_t m_displayFunction;
 	uint8_t m_displayControl;
 	uint8_t m_displayMode;
 	uint8_t m_numlines;
-	uint8_t m_backlight;
-	uint8_t m_rowOffsets[4];	
+	bool m_backlight;
+	uint8_t m_rowOffsets[4];
+	uint8_t m_initStep;
+	unsigned long m_initTimer;
+	unsigned long m_initDelay;
 };
 
 extern LCDModule LCD;
@@ -0,0 +1,307 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: LCDBus.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo LCD transports
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "LCDBus.h"
+
+void LCDBus::send(uint8_t value, uint8_t mode) {
+	write4bits((value & 0xf0) | mode);
+	write4bits((value << 4) | mode);
+}
+
+void LCDBus::send(const uint8_t *data, size_t n, uint8_t mode) {
+	while (n--) {
+		send(*data++, mode);
+	}
+}
+
+void LCDBus::submit(const uint16_t *entries, size_t n) {
+	uint8_t data[16];
+	size_t count = 0;
+
+	// consecutive data bytes go out in bulk
+	for (size_t i = 0; i < n; i++) {
+		if (entries[i] >> 8) {
+			data[count++] = entries[i];
+			if (count < sizeof(data) && i + 1 < n && (entries[i + 1] >> 8)) {
+				continue;
+			}
+			send(data, count, Rs);
+			count = 0;
+		} else {
+			send(entries[i], 0);
+		}
+	}
+}
+
+PCF8574Bus::PCF8574Bus(uint8_t addr, uint32_t clock) :
+	m_addr(addr),
+	m_backlight(LCD_NOBACKLIGHT),
+	m_clock(clock) {
+}
+
+void PCF8574Bus::begin() {
+	Wire.begin();
+	Wire.setClock(m_clock);
+}
+
+void PCF8574Bus::backlight(bool on) {
+	m_backlight = on ? LCD_BACKLIGHT : LCD_NOBACKLIGHT;
+	Wire.beginTransmission(m_addr);
+	Wire.write(m_backlight);
+	Wire.endTransmission();
+}
+
+void PCF8574Bus::write4bits(uint8_t value) {
+	Wire.beginTransmission(m_addr);
+	put(value);
+	Wire.endTransmission();
+}
+
+void PCF8574Bus::send(uint8_t value, uint8_t mode) {
+	Wire.beginTransmission(m_addr);
+	put((value & 0xf0) | mode);
+	put((value << 4) | mode);
+	Wire.endTransmission();
+}
+
+// Data bytes are packed into as few transactions as the Wire buffer allows.
+// Even at 400 kHz the three expander writes between two enable pulses take
+// longer than the 37us a byte needs to execute.
+void PCF8574Bus::send(const uint8_t *data, size_t n, uint8_t mode) {
+	while (n > 0) {
+		size_t batch = n < PCF8574_BATCH ? n : PCF8574_BATCH;
+
+		Wire.beginTransmission(m_addr);
+		for (size_t i = 0; i < batch; i++) {
+			put((data[i] & 0xf0) | mode);
+			put((data[i] << 4) | mode);
+		}
+		Wire.endTransmission();
+
+		data += batch;
+		n -= batch;
+	}
+}
+
+void PCF8574Bus::put(uint8_t value) {
+	uint8_t bytes[3];
+
+	Wire.write(bytes, pack(value, bytes));
+}
+
+size_t PCF8574Bus::pack(uint8_t value, uint8_t *dst) {
+	value |= m_backlight;
+	dst[0] = value;					// data setup
+	dst[1] = value | En;			// En high, pulse lasts a whole I2C byte (>450ns)
+	dst[2] = value & ~En;			// En low, data latched
+
+	return 3;
+}
+
+#if defined(ESP32) || defined(__linux__)
+#ifdef ESP32
+AsyncPCF8574Bus::AsyncPCF8574Bus(uint8_t addr, uint32_t clock) :
+	PCF8574Bus(addr, clock),
+	m_length(0),
+	m_busy(false),
+	m_transfers(0),
+	m_callback(NULL),
+	m_arg(NULL),
+	m_task(NULL) {
+}
+
+void AsyncPCF8574Bus::begin() {
+	PCF8574Bus::begin();
+	if (m_task == NULL) {
+		xTaskCreatePinnedToCore(task, "lcd", 2048, this, 1, &m_task, 0);
+	}
+}
+
+void AsyncPCF8574Bus::notify() {
+	xTaskNotifyGive(m_task);
+}
+
+void AsyncPCF8574Bus::take() {
+	ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+}
+#else
+AsyncPCF8574Bus::AsyncPCF8574Bus(uint8_t addr, uint32_t clock) :
+	PCF8574Bus(addr, clock),
+	m_length(0),
+	m_busy(false),
+	m_transfers(0),
+	m_callback(NULL),
+	m_arg(NULL),
+	m_started(false),
+	m_notified(false) {
+	pthread_mutex_init(&m_lock, NULL);
+	pthread_cond_init(&m_signal, NULL);
+}
+
+void AsyncPCF8574Bus::begin() {
+	PCF8574Bus::begin();
+	if (!m_started) {
+		m_started = pthread_create(&m_thread, NULL, thread, this) == 0;
+	}
+}
+
+void *AsyncPCF8574Bus::thread(void *arg) {
+	task(arg);
+
+	return NULL;
+}
+
+// A binary semaphore, as the task notification is used on ESP32
+void AsyncPCF8574Bus::notify() {
+	pthread_mutex_lock(&m_lock);
+	m_notified = true;
+	pthread_cond_signal(&m_signal);
+	pthread_mutex_unlock(&m_lock);
+}
+
+void AsyncPCF8574Bus::take() {
+	pthread_mutex_lock(&m_lock);
+	while (!m_notified) {
+		pthread_cond_wait(&m_signal, &m_lock);
+	}
+	m_notified = false;
+	pthread_mutex_unlock(&m_lock);
+}
+#endif
+
+// Anything sent outside a transfer must not overtake the frame on the wire
+void AsyncPCF8574Bus::backlight(bool on) {
+	wait();
+	PCF8574Bus::backlight(on);
+}
+
+void AsyncPCF8574Bus::write4bits(uint8_t value) {
+	wait();
+	PCF8574Bus::write4bits(value);
+}
+
+void AsyncPCF8574Bus::send(uint8_t value, uint8_t mode) {
+	wait();
+	PCF8574Bus::send(value, mode);
+}
+
+void AsyncPCF8574Bus::send(const uint8_t *data, size_t n, uint8_t mode) {
+	wait();
+	PCF8574Bus::send(data, n, mode);
+}
+
+void AsyncPCF8574Bus::submit(const uint16_t *entries, size_t n) {
+	wait();
+
+	if (n > LCD_TRANSFER_SIZE) {
+		n = LCD_TRANSFER_SIZE;
+	}
+
+	// the whole frame is packed before the task sees it, so a frame is never
+	// mixed with the next one and the caller's buffer is free on return
+	m_length = 0;
+	for (size_t i = 0; i < n; i++) {
+		uint8_t mode = (entries[i] >> 8) ? Rs : 0;
+		m_length += pack((entries[i] & 0xf0) | mode, m_wire + m_length);
+		m_length += pack((entries[i] << 4) | mode, m_wire + m_length);
+	}
+
+	m_busy = true;
+	m_transfers++;
+	notify();
+}
+
+bool AsyncPCF8574Bus::busy() {
+	return __atomic_load_n(&m_busy, __ATOMIC_ACQUIRE);
+}
+
+void AsyncPCF8574Bus::wait() {
+	while (busy()) {
+		yield();
+	}
+}
+
+void AsyncPCF8574Bus::onComplete(void (*callback)(void *), void *arg) {
+	m_callback = callback;
+	m_arg = arg;
+}
+
+void AsyncPCF8574Bus::task(void *arg) {
+	AsyncPCF8574Bus *bus = (AsyncPCF8574Bus *)arg;
+
+	for (;;) {
+		bus->take();
+
+		// whole expander triplets per transaction
+		const size_t chunk = (PCF8574_BATCH * 6);
+		for (size_t i = 0; i < bus->m_length; i += chunk) {
+			size_t n = bus->m_length - i < chunk ? bus->m_length - i : chunk;
+			Wire.beginTransmission(bus->m_addr);
+			Wire.write(bus->m_wire + i, n);
+			Wire.endTransmission();
+		}
+
+		__atomic_store_n(&bus->m_busy, false, __ATOMIC_RELEASE);
+		if (bus->m_callback != NULL) {
+			bus->m_callback(bus->m_arg);
+		}
+	}
+}
+#endif
+
+RecordingBus::RecordingBus() {
+	clear();
+	m_backlight = false;
+}
+
+void RecordingBus::begin() {
+}
+
+void RecordingBus::backlight(bool on) {
+	m_backlight = on;
+	m_transactions++;
+}
+
+void RecordingBus::write4bits(uint8_t value) {
+	record(0x8000 | value);
+	m_transactions++;
+}
+
+void RecordingBus::send(uint8_t value, uint8_t mode) {
+	record((mode << 8) | value);
+	m_transactions++;
+}
+
+void RecordingBus::send(const uint8_t *data, size_t n, uint8_t mode) {
+	while (n--) {
+		record((mode << 8) | *data++);
+	}
+	m_transactions++;
+}
+
+void RecordingBus::submit(const uint16_t *entries, size_t n) {
+	while (n--) {
+		record(*entries++);
+	}
+	m_transactions++;
+}
+
+void RecordingBus::clear() {
+	m_count = 0;
+	m_transactions = 0;
+}
+
+void RecordingBus::record(uint16_t entry) {
+	if (m_count < LCD_RECORD_SIZE) {
+		m_log[m_count++] = entry;
+	}
+}
@@ -0,0 +1,232 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: LCDBus.h
+ * Created on: 19 Oct 2026
+ * Description: Thimo LCD transports
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#ifndef _THIMO_LCD_BUS_H_
+#define _THIMO_LCD_BUS_H_
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#ifdef ESP32
+#include <soc/gpio_struct.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#endif
+
+// PCF8574 expander pins, Rs doubles as the data register flag for every bus
+#define En 							B00000100 // Enable bit
+#define Rw							B00000010 // Read/Write bit
+#define Rs							B00000001 // Register select bit
+
+#define LCD_BACKLIGHT				0x08
+#define LCD_NOBACKLIGHT				0x00
+
+#define LCD_EXEC_TIME				37		// us, most commands need this to settle
+
+#ifdef I2C_BUFFER_LENGTH
+#define PCF8574_BATCH				((I2C_BUFFER_LENGTH) / 6)
+#else
+#define PCF8574_BATCH				5		// AVR Wire buffer is 32 bytes
+#endif
+
+#define LCD_RECORD_SIZE				256
+#define LCD_TRANSFER_SIZE			120		// entries in a frame transfer (20x4 worst case)
+
+// HD44780 transport: moves nibbles and bytes to the controller. value
+// carries the nibble in bits 7-4, mode is 0 for commands or Rs for data.
+class LCDBus {
+public:
+	virtual ~LCDBus() {}
+
+	virtual void begin() = 0;
+	virtual void backlight(bool on) = 0;
+	virtual void write4bits(uint8_t value) = 0;
+	virtual void send(uint8_t value, uint8_t mode);
+	virtual void send(const uint8_t *data, size_t n, uint8_t mode);
+
+	// A transfer is a list of mode << 8 | value entries. The default sends it
+	// right away, an asynchronous bus queues it and returns: busy() is true
+	// until it's on the display, wait() blocks until then.
+	virtual void submit(const uint16_t *entries, size_t n);
+	virtual bool busy() { return false; }
+	virtual void wait() {}
+};
+
+// I2C backpack: one transaction per byte, or per batch of data bytes,
+// with the enable pulse generated by consecutive expander writes.
+class PCF8574Bus : public LCDBus {
+public:
+	PCF8574Bus(uint8_t addr, uint32_t clock);
+
+	virtual void begin();
+	virtual void backlight(bool on);
+	virtual void write4bits(uint8_t value);
+	virtual void send(uint8_t value, uint8_t mode);
+	virtual void send(const uint8_t *data, size_t n, uint8_t mode);
+protected:
+	void put(uint8_t value);
+	size_t pack(uint8_t value, uint8_t *dst);
+
+	uint8_t m_addr;
+	uint8_t m_backlight;
+	uint32_t m_clock;
+};
+
+#if defined(ESP32) || defined(__linux__)
+// Frame transfers run on a background task, so the caller gets control back
+// as soon as the frame is packed. Arduino's Wire owns the I2C controller and
+// serializes whole transactions internally, so the task shares it safely
+// with the RTC accesses made from the main loop. On Linux host builds the
+// task is a thread, for tests.
+class AsyncPCF8574Bus : public PCF8574Bus {
+public:
+	AsyncPCF8574Bus(uint8_t addr, uint32_t clock);
+
+	virtual void begin();
+	virtual void backlight(bool on);
+	virtual void write4bits(uint8_t value);
+	virtual void send(uint8_t value, uint8_t mode);
+	virtual void send(const uint8_t *data, size_t n, uint8_t mode);
+	virtual void submit(const uint16_t *entries, size_t n);
+	virtual bool busy();
+	virtual void wait();
+
+	void onComplete(void (*callback)(void *), void *arg);
+	inline uint32_t transfers() const { return m_transfers; }
+private:
+	static void task(void *arg);
+	void notify();
+	void take();
+
+	uint8_t m_wire[LCD_TRANSFER_SIZE * 6];
+	size_t m_length;
+	volatile bool m_busy;
+	uint32_t m_transfers;
+	void (*m_callback)(void *);
+	void *m_arg;
+#ifdef ESP32
+	TaskHandle_t m_task;
+#else
+	static void *thread(void *arg);
+
+	bool m_started;
+	bool m_notified;
+	pthread_t m_thread;
+	pthread_mutex_t m_lock;
+	pthread_cond_t m_signal;
+#endif
+};
+#endif
+
+// Direct 4-bit parallel wiring (R/W tied low). On ESP32 the lines are driven
+// through the GPIO set/clear registers, the only wait left is the controller
+// execution time between bytes.
+template<uint8_t RS, uint8_t EN, uint8_t D4, uint8_t D5, uint8_t D6, uint8_t D7, uint8_t BL = 0xff>
+class ParallelBus : public LCDBus {
+public:
+	ParallelBus() : m_last(0UL) {}
+
+	virtual void begin() {
+		const uint8_t pins[] = { RS, EN, D4, D5, D6, D7 };
+		for (uint8_t i = 0; i < sizeof(pins); i++) {
+			digitalWrite(pins[i], LOW);
+			pinMode(pins[i], OUTPUT);
+		}
+		if (BL != 0xff) {
+			pinMode(BL, OUTPUT);
+		}
+	}
+
+	virtual void backlight(bool on) {
+		if (BL != 0xff) {
+			digitalWrite(BL, on ? HIGH : LOW);
+		}
+	}
+
+	virtual void write4bits(uint8_t value) {
+		settle();
+		put(value);
+		m_last = micros();
+	}
+
+	virtual void send(uint8_t value, uint8_t mode) {
+		settle();
+		put((value & 0xf0) | mode);
+		put((value << 4) | mode);
+		m_last = micros();
+	}
+
+	virtual void send(const uint8_t *data, size_t n, uint8_t mode) {
+		while (n--) {
+			send(*data++, mode);
+		}
+	}
+private:
+	static inline void line(uint8_t pin, bool level) {
+#ifdef ESP32
+		if (pin < 32) {
+			if (level) GPIO.out_w1ts = 1UL << pin; else GPIO.out_w1tc = 1UL << pin;
+		} else {
+			if (level) GPIO.out1_w1ts.val = 1UL << (pin - 32); else GPIO.out1_w1tc.val = 1UL << (pin - 32);
+		}
+#else
+		digitalWrite(pin, level ? HIGH : LOW);
+#endif
+	}
+
+	static inline void put(uint8_t value) {
+		line(RS, value & Rs);
+		line(D4, value & 0x10);
+		line(D5, value & 0x20);
+		line(D6, value & 0x40);
+		line(D7, value & 0x80);
+		line(EN, true);
+		delayMicroseconds(1); // enable pulse must be >450ns
+		line(EN, false);
+	}
+
+	inline void settle() {
+		while ((micros() - m_last) < LCD_EXEC_TIME) {
+			// previous byte still executing
+		}
+	}
+
+	unsigned long m_last;
+};
+
+// Keeps what would go on the wire, for checking display output off target
+class RecordingBus : public LCDBus {
+public:
+	RecordingBus();
+
+	virtual void begin();
+	virtual void backlight(bool on);
+	virtual void write4bits(uint8_t value);
+	virtual void send(uint8_t value, uint8_t mode);
+	virtual void send(const uint8_t *data, size_t n, uint8_t mode);
+	virtual void submit(const uint16_t *entries, size_t n);
+
+	void clear();
+	inline size_t count() const { return m_count; }
+	inline uint16_t entry(size_t i) const { return m_log[i]; }	// mode << 8 | value, 0x8000 | nibble
+	inline uint32_t transactions() const { return m_transactions; }
+	inline bool backlight() const { return m_backlight; }
+private:
+	void record(uint16_t entry);
+
+	uint16_t m_log[LCD_RECORD_SIZE];
+	size_t m_count;
+	uint32_t m_transactions;
+	bool m_backlight;
+};
+
+#endif
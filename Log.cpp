@@ -0,0 +1,139 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Log.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo logging module
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Log.h"
+#include "Codec.h"
+
+#if !LOG_TOKENIZED
+#define LOG_TEXT(token, text)	text,
+static const char *messages[LOG_MESSAGE_COUNT] = {
+	LOG_MESSAGES(LOG_TEXT)
+};
+#undef LOG_TEXT
+
+static const char levels[] = "-EWID";
+#endif
+
+LogModule::LogModule() :
+	m_head(0),
+	m_tail(0),
+	m_dropped(0),
+	m_reported(0),
+	m_written(0),
+	m_lastTime(0) {
+	for (int i = 0; i < LOG_QUEUE_SIZE; i++) {
+		m_queue[i].ready = 0;
+	}
+}
+
+// Lock free multiple producer / single consumer queue: producers reserve a
+// slot by advancing the head, fill it and then publish it through the ready
+// flag. Never blocks: when the queue is full the message is counted and lost.
+void LogModule::push(uint8_t level, uint8_t token, uint8_t argc, int32_t a, int32_t b) {
+	uint32_t head = __atomic_load_n(&m_head, __ATOMIC_RELAXED);
+
+	do {
+		if (head - __atomic_load_n(&m_tail, __ATOMIC_ACQUIRE) >= LOG_QUEUE_SIZE) {
+			__atomic_fetch_add(&m_dropped, 1, __ATOMIC_RELAXED);
+			return;
+		}
+	} while (!__atomic_compare_exchange_n(&m_head, &head, head + 1, true, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+	Entry &e = m_queue[head & (LOG_QUEUE_SIZE - 1)];
+	e.level = level;
+	e.token = token;
+	e.argc = argc;
+	e.time = millis();
+	e.args[0] = a;
+	e.args[1] = b;
+	__atomic_store_n(&e.ready, 1, __ATOMIC_RELEASE);
+}
+
+// Called from the main loop when there's nothing else to do: only writes
+// what fits in the UART transmit FIFO, so it never waits on the wire.
+void LogModule::drain(HardwareSerial &out) {
+	uint8_t record[LOG_LINE_SIZE];
+	size_t n;
+
+	uint32_t dropped = __atomic_load_n(&m_dropped, __ATOMIC_RELAXED);
+	if (dropped != m_reported) {
+		Entry e;
+		e.level = LOG_LEVEL_WARN;
+		e.token = LOG_DROPPED;
+		e.argc = 1;
+		e.time = millis();
+		e.args[0] = dropped - m_reported;
+		n = format(e, record);
+		if ((size_t)out.availableForWrite() < n) {
+			return;
+		}
+		out.write(record, n);
+		m_lastTime = e.time;
+		m_reported = dropped;
+	}
+
+	while (m_tail != __atomic_load_n(&m_head, __ATOMIC_ACQUIRE)) {
+		Entry &e = m_queue[m_tail & (LOG_QUEUE_SIZE - 1)];
+		if (!__atomic_load_n(&e.ready, __ATOMIC_ACQUIRE)) {
+			break; // reserved but still being filled
+		}
+
+		n = format(e, record);
+		if ((size_t)out.availableForWrite() < n) {
+			break;
+		}
+		out.write(record, n);
+		m_lastTime = e.time;
+		m_written++;
+
+		e.ready = 0;
+		__atomic_store_n(&m_tail, m_tail + 1, __ATOMIC_RELEASE);
+	}
+}
+
+size_t LogModule::format(const Entry &e, uint8_t *dst) const {
+	size_t n = 0;
+
+#if LOG_TOKENIZED
+	uint8_t record[LOG_LINE_SIZE / 2];
+	size_t len = 0;
+
+	record[len++] = LOG_SYNC;
+	record[len++] = (e.level << 4) | e.argc;
+	record[len++] = e.token;
+	len += codecPutVarint(record + len, e.time - m_lastTime);
+	for (uint8_t i = 0; i < e.argc; i++) {
+		len += codecPutVarint(record + len, codecZigzag(e.args[i]));
+	}
+	record[len] = crc8(record, len);
+	len++;
+
+	// same COBS framing as the console, so both can share the wire
+	dst[n++] = 0;
+	n += cobsEncode(record, len, dst + n);
+	dst[n++] = 0;
+#else
+	n = snprintf((char *)dst, LOG_LINE_SIZE - 2, "%lu %c %s", (unsigned long)e.time, levels[e.level], messages[e.token]);
+	for (uint8_t i = 0; i < e.argc && n < LOG_LINE_SIZE - 2; i++) {
+		n += snprintf((char *)dst + n, LOG_LINE_SIZE - 2 - n, " %ld", (long)e.args[i]);
+	}
+	if (n > LOG_LINE_SIZE - 3) {
+		n = LOG_LINE_SIZE - 3; // truncated
+	}
+	dst[n++] = '\r';
+	dst[n++] = '\n';
+#endif
+
+	return n;
+}
+
+LogModule Log;
@@ -0,0 +1,120 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Log.h
+ * Created on: 19 Oct 2026
+ * Description: Thimo logging module
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#ifndef _THIMO_LOG_H_
+#define _THIMO_LOG_H_
+
+#include <Arduino.h>
+
+#define LOG_LEVEL_NONE				0
+#define LOG_LEVEL_ERROR				1
+#define LOG_LEVEL_WARN				2
+#define LOG_LEVEL_INFO				3
+#define LOG_LEVEL_DEBUG				4
+
+#include "config.h"
+
+// Every message is a token plus up to two integer arguments. The text is
+// only linked in when LOG_TOKENIZED is 0, otherwise the host side decoder
+// maps tokens back to this table.
+#define LOG_MESSAGES(X) \
+	X(LOG_DROPPED,			"dropped messages") \
+	X(LOG_BOOT_STEP,		"boot step (us)") \
+	X(LOG_RESET_REASON,		"reset reason") \
+	X(LOG_RTC_NOT_RUNNING,	"RTC is not running") \
+	X(LOG_BUTTON_NEXT,		"next") \
+	X(LOG_BUTTON_PREVIOUS,	"previous") \
+	X(LOG_BUTTON_SELECT,	"select") \
+	X(LOG_SENSOR_ERROR,		"sensor error") \
+	X(LOG_RELAY,			"relay") \
+	X(LOG_STALL,			"stall (section, ms)") \
+	X(LOG_WINDOW,			"open window (zone, state)") \
+	X(LOG_HTTP,				"http listening (port)") \
+	X(LOG_NTP,				"time sync (offset ms, delay ms)") \
+	X(LOG_RTC_DRIFT,		"RTC drift (ppb, error s)") \
+	X(LOG_RTC_SET,			"RTC set (error s)")
+
+#define LOG_TOKEN(token, text)	token,
+enum LogMessage {
+	LOG_MESSAGES(LOG_TOKEN)
+	LOG_MESSAGE_COUNT
+};
+#undef LOG_TOKEN
+
+// Binary record: LOG_SYNC, level << 4 | argc, token, varint milliseconds
+// since the previous record, zigzag varint arguments, CRC-8. Sent as a
+// zero delimited COBS frame (see Console.h).
+#define LOG_SYNC					0xa5
+#define LOG_LINE_SIZE				64		// formatting buffer, fits a binary record too
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...)				Log.write(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...)				do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...)				Log.write(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...)				do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...)				Log.write(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...)				do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...)				Log.write(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...)				do {} while (0)
+#endif
+
+class LogModule {
+public:
+	LogModule();
+
+	inline void write(uint8_t level, uint8_t token) { push(level, token, 0, 0, 0); }
+	inline void write(uint8_t level, uint8_t token, int32_t a) { push(level, token, 1, a, 0); }
+	inline void write(uint8_t level, uint8_t token, int32_t a, int32_t b) { push(level, token, 2, a, b); }
+
+	void drain(HardwareSerial &out);
+	inline bool idle() const { return m_tail == __atomic_load_n(&m_head, __ATOMIC_ACQUIRE) && __atomic_load_n(&m_dropped, __ATOMIC_RELAXED) == m_reported; }
+
+	inline uint32_t dropped() const { return m_dropped; }
+	inline uint32_t written() const { return m_written; }
+private:
+	struct Entry {
+		volatile uint8_t ready;
+		uint8_t level;
+		uint8_t token;
+		uint8_t argc;
+		uint32_t time;
+		int32_t args[2];
+	};
+
+	void push(uint8_t level, uint8_t token, uint8_t argc, int32_t a, int32_t b);
+	size_t format(const Entry &e, uint8_t *dst) const;
+
+	Entry m_queue[LOG_QUEUE_SIZE];
+	uint32_t m_head;
+	uint32_t m_tail;
+	uint32_t m_dropped;
+	uint32_t m_reported;
+	uint32_t m_written;
+	uint32_t m_lastTime;
+};
+
+extern LogModule Log;
+
+#endif
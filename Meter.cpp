@@ -0,0 +1,197 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Meter.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo relay duty and energy accounting
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Meter.h"
+#include "Clock.h"
+
+#if defined(ESP32) && !defined(THIMO_SIMULATION)
+#include <Preferences.h>
+#endif
+
+MeterModule::MeterModule() :
+	m_dirty(false),
+	m_saveTimer(0UL),
+	m_saves(0) {
+	reset();
+	for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+		m_relays[z].on = false;
+		m_relays[z].since = 0UL;
+		m_relays[z].started = 0UL;
+		m_relays[z].remainder = 0;
+	}
+}
+
+// The counters saved before the reboot, if any
+void MeterModule::begin() {
+	m_saveTimer = Clock.millis();
+#if defined(ESP32) && !defined(THIMO_SIMULATION)
+	Preferences preferences;
+
+	if (!preferences.begin("thimo", true)) {
+		return;
+	}
+	if (preferences.getBytes("meter", &m_record, sizeof(m_record)) != sizeof(m_record)) {
+		reset();
+	}
+	preferences.end();
+#endif
+}
+
+void MeterModule::reset() {
+	memset(&m_record, 0, sizeof(m_record));
+	m_dirty = true;
+}
+
+// The relay state at boot, or after a replay restored it: not a start
+void MeterModule::resume(uint8_t z, bool on, unsigned long now) {
+	Relay &relay = m_relays[z];
+
+	credit(z, now);
+	relay.on = on;
+	relay.started = now;
+}
+
+void MeterModule::relay(uint8_t z, bool on, unsigned long now) {
+	Relay &relay = m_relays[z];
+
+	if (on == relay.on) {
+		return;
+	}
+	credit(z, now);
+	relay.on = on;
+	if (on) {
+		relay.started = now;
+		add(z, 0, 1, 0);
+	} else if (now - relay.started < METER_SHORT_RUN) {
+		add(z, 0, 0, 1);
+	}
+}
+
+// Credits the relays that are on up to now, then moves to the period the
+// time falls in, clearing the slots of the periods that went by. True when
+// a new hour started.
+bool MeterModule::update(const DateTime &time, unsigned long now) {
+	uint32_t unixtime = time.unixtime();
+	uint32_t hour = unixtime / 3600UL;
+	uint32_t day = unixtime / 86400UL;
+	uint32_t month = time.year() * 12UL + time.month() - 1;
+
+	for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+		credit(z, now);
+	}
+	if (hour == m_record.hour) {
+		return false;
+	}
+
+	for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+		MeterZone &zone = m_record.zones[z];
+
+		// a clock set back carries on, a long gap clears the whole ring
+		for (uint32_t h = m_record.hour + 1; h > m_record.hour && h <= hour && h - m_record.hour <= METER_HOURS; h++) {
+			memset(&zone.hours[h % METER_HOURS], 0, sizeof(MeterCounter));
+		}
+		for (uint32_t d = m_record.day + 1; d > m_record.day && d <= day && d - m_record.day <= METER_DAYS; d++) {
+			memset(&zone.days[d % METER_DAYS], 0, sizeof(MeterCounter));
+		}
+		for (uint32_t m = m_record.month + 1; m > m_record.month && m <= month && m - m_record.month <= METER_MONTHS; m++) {
+			memset(&zone.months[m % METER_MONTHS], 0, sizeof(MeterCounter));
+		}
+	}
+	m_record.hour = hour;
+	m_record.day = day;
+	m_record.month = month;
+	m_dirty = true;
+
+	return true;
+}
+
+// Batched: the counters reach flash once every METER_SAVE_TIME at most
+void MeterModule::poll() {
+	if (m_dirty && Clock.millis() - m_saveTimer >= METER_SAVE_TIME) {
+		m_saveTimer = Clock.millis();
+		save();
+	}
+}
+
+const MeterCounter &MeterModule::counter(uint8_t z, Period period, uint8_t ago) const {
+	const MeterZone &zone = m_record.zones[z];
+
+	switch (period) {
+		case HOUR:
+			return zone.hours[(m_record.hour + METER_HOURS - ago % METER_HOURS) % METER_HOURS];
+		case DAY:
+			return zone.days[(m_record.day + METER_DAYS - ago % METER_DAYS) % METER_DAYS];
+		default:
+			return zone.months[(m_record.month + METER_MONTHS - ago % METER_MONTHS) % METER_MONTHS];
+	}
+}
+
+uint32_t MeterModule::onTime(uint8_t z, Period period) const {
+	uint8_t slots = period == HOUR ? METER_HOURS : (period == DAY ? METER_DAYS : METER_MONTHS);
+	uint32_t total = 0;
+
+	for (uint8_t i = 0; i < slots; i++) {
+		total += counter(z, period, i).onTime;
+	}
+
+	return total;
+}
+
+// Whole seconds go to the current slots, the rest waits for the next credit
+void MeterModule::credit(uint8_t z, unsigned long now) {
+	Relay &relay = m_relays[z];
+	unsigned long ms = relay.remainder;
+
+	if (relay.on) {
+		ms += now - relay.since;
+	}
+	relay.since = now;
+	relay.remainder = ms % 1000UL;
+	if (ms >= 1000UL) {
+		add(z, ms / 1000UL, 0, 0);
+	}
+}
+
+void MeterModule::add(uint8_t z, uint32_t seconds, uint8_t cycles, uint8_t shortCycles) {
+	MeterZone &zone = m_record.zones[z];
+	MeterCounter *slots[3] = {
+		&zone.hours[m_record.hour % METER_HOURS],
+		&zone.days[m_record.day % METER_DAYS],
+		&zone.months[m_record.month % METER_MONTHS]
+	};
+
+	for (uint8_t i = 0; i < 3; i++) {
+		slots[i]->onTime += seconds;
+		slots[i]->cycles += cycles;
+		slots[i]->shortCycles += shortCycles;
+	}
+	zone.onTime += seconds;
+	zone.cycles += cycles;
+	zone.shortCycles += shortCycles;
+	m_dirty = true;
+}
+
+void MeterModule::save() {
+#if defined(ESP32) && !defined(THIMO_SIMULATION)
+	Preferences preferences;
+
+	if (!preferences.begin("thimo", false)) {
+		return;
+	}
+	preferences.putBytes("meter", &m_record, sizeof(m_record));
+	preferences.end();
+#endif
+	m_dirty = false;
+	m_saves++;
+}
+
+MeterModule Meter;
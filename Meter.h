@@ -0,0 +1,103 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Meter.h
+ * Created on: 19 Oct 2026
+ * Description: Thimo relay duty and energy accounting
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#ifndef _THIMO_METER_H_
+#define _THIMO_METER_H_
+
+#include <Arduino.h>
+#include "RTC.h"
+#include "Zone.h"
+#include "config.h"
+
+#define METER_HOURS					24
+#define METER_DAYS					31
+#define METER_MONTHS				12
+
+struct MeterCounter {
+	uint32_t onTime;		// s
+	uint16_t cycles;		// burner starts
+	uint16_t shortCycles;	// of them, runs shorter than METER_SHORT_RUN
+};
+
+struct MeterZone {
+	MeterCounter hours[METER_HOURS];
+	MeterCounter days[METER_DAYS];
+	MeterCounter months[METER_MONTHS];
+	uint32_t onTime;		// since the counters were first kept
+	uint32_t cycles;
+	uint32_t shortCycles;
+};
+
+// What is kept in flash. Each period is a ring indexed by its number since
+// the epoch, a slot is cleared when its period starts.
+struct MeterRecord {
+	uint32_t hour;			// unixtime / 3600 of the current hour
+	uint32_t day;			// unixtime / 86400
+	uint32_t month;			// year * 12 + month - 1
+	MeterZone zones[ZONE_COUNT];
+};
+
+// How long each relay was on, and how many times it started, per hour of
+// the last day, per day of the last month and per month of the last year.
+// Transitions are timestamped with the millisecond clock and the running
+// time is credited on every update(), so a period closes within a control
+// pass of its end. The clock is the one the schedule runs on; a clock set
+// back just carries on in the earlier slots.
+//
+// Nothing is written on a transition: poll() saves the counters to flash
+// every METER_SAVE_TIME, if they changed, a power cut loses at most that.
+class MeterModule {
+public:
+	typedef enum {
+		HOUR,
+		DAY,
+		MONTH
+	} Period;
+
+	MeterModule();
+
+	void begin();
+	void reset();
+	void resume(uint8_t z, bool on, unsigned long now);
+	void relay(uint8_t z, bool on, unsigned long now);
+	bool update(const DateTime &time, unsigned long now);
+	void poll();
+
+	const MeterCounter &counter(uint8_t z, Period period, uint8_t ago = 0) const;
+	uint32_t onTime(uint8_t z, Period period) const;	// s over the whole ring
+	inline const MeterZone &zone(uint8_t z) const { return m_record.zones[z]; }
+	inline bool on(uint8_t z) const { return m_relays[z].on; }
+	inline uint32_t saves() const { return m_saves; }
+
+	static inline float energy(uint32_t onTime) { return onTime * (METER_POWER / 3600000.0f); }	// kWh
+private:
+	struct Relay {
+		bool on;
+		unsigned long since;	// last credited
+		unsigned long started;	// the run began
+		uint16_t remainder;		// ms not credited yet
+	};
+
+	MeterRecord m_record;
+	Relay m_relays[ZONE_COUNT];
+	bool m_dirty;
+	unsigned long m_saveTimer;
+	uint32_t m_saves;
+
+	void credit(uint8_t z, unsigned long now);
+	void add(uint8_t z, uint32_t seconds, uint8_t cycles, uint8_t shortCycles);
+	void save();
+};
+
+extern MeterModule Meter;
+
+#endif
@@ -0,0 +1,172 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Model.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo learned thermal model
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Model.h"
+
+#define MODEL_MAX_SECONDS			(MODEL_MAX_LEAD * 3600UL)
+
+ThermalModel::ThermalModel() {
+	reset();
+}
+
+void ThermalModel::reset() {
+	for (uint8_t i = 0; i < MODEL_PARAMS; i++) {
+		m_theta[i] = 0.0f;
+		for (uint8_t j = 0; j < MODEL_PARAMS; j++) {
+			m_p[i][j] = i == j ? MODEL_P_INITIAL : 0.0f;
+		}
+	}
+	m_error = 0.0f;
+	m_updates = 0;
+	m_measured = 0.0f;
+	m_predicted = 0.0f;
+	m_started = false;
+}
+
+// Called with every sample. The heater time is counted between calls with
+// the state of the previous one, the rate over the window once it's over.
+void ThermalModel::update(float temperature, bool heating, unsigned long now) {
+	if (m_started && now - m_last > MODEL_PERIOD) {
+		m_started = false;	// samples went missing, the window doesn't tell
+	}
+	if (!m_started) {
+		m_started = true;
+		m_from = temperature;
+		m_heating = heating;
+		m_start = now;
+		m_last = now;
+		m_onTime = 0UL;
+		return;
+	}
+
+	if (m_heating) {
+		m_onTime += now - m_last;
+	}
+	m_last = now;
+	m_heating = heating;
+
+	unsigned long elapsed = now - m_start;
+	if (elapsed < MODEL_PERIOD) {
+		return;
+	}
+
+	float x[MODEL_PARAMS] = { (float)m_onTime / elapsed, (temperature + m_from) * 0.5f - MODEL_REFERENCE, 1.0f };
+	fit(x, (temperature - m_from) * 3600000.0f / elapsed);
+
+	m_from = temperature;
+	m_start = now;
+	m_onTime = 0UL;
+}
+
+// °C/h at the given duty, 0..1
+float ThermalModel::rate(float duty, float temperature) const {
+	return m_theta[0] * duty + m_theta[1] * (temperature - MODEL_REFERENCE) + m_theta[2];
+}
+
+// Seconds of full heating from one temperature to a higher one, the
+// exponential approach to the temperature the heater can hold. Out of
+// reach is MODEL_MAX_LEAD hours, as soon as it's allowed to start.
+uint32_t ThermalModel::lead(float from, float to) const {
+	if (!ready()) {
+		return MODEL_NO_LEAD;
+	}
+	if (to <= from) {
+		return 0UL;
+	}
+
+	float start = rate(1.0f, from);
+	float hours;
+
+	if (start <= 0.0f) {
+		return MODEL_MAX_SECONDS;
+	}
+	if (m_theta[1] < 0.0f) {
+		float ceiling = MODEL_REFERENCE - (m_theta[0] + m_theta[2]) / m_theta[1];
+		if (to >= ceiling) {
+			return MODEL_MAX_SECONDS;
+		}
+		hours = logf((ceiling - from) / (ceiling - to)) / -m_theta[1];
+	} else {
+		hours = (to - from) / start;
+	}
+
+	return hours * 3600.0f < MODEL_MAX_SECONDS ? (uint32_t)(hours * 3600.0f) : MODEL_MAX_SECONDS;
+}
+
+// One RLS step: gain k = P x / (lambda + x' P x), theta += k e,
+// P = (P - k x' P) / lambda. Without excitation the forgetting would blow
+// P up, it's held once P grows back to its initial size.
+void ThermalModel::fit(const float *x, float y) {
+	float px[MODEL_PARAMS];
+	float k[MODEL_PARAMS];
+	float denominator = MODEL_FORGET;
+	float trace = 0.0f;
+
+	m_predicted = m_theta[0] * x[0] + m_theta[1] * x[1] + m_theta[2] * x[2];
+	m_measured = y;
+
+	for (uint8_t i = 0; i < MODEL_PARAMS; i++) {
+		px[i] = 0.0f;
+		for (uint8_t j = 0; j < MODEL_PARAMS; j++) {
+			px[i] += m_p[i][j] * x[j];
+		}
+		denominator += x[i] * px[i];
+	}
+
+	float e = y - m_predicted;
+	for (uint8_t i = 0; i < MODEL_PARAMS; i++) {
+		k[i] = px[i] / denominator;
+		m_theta[i] += k[i] * e;
+	}
+
+	for (uint8_t i = 0; i < MODEL_PARAMS; i++) {
+		trace += m_p[i][i];
+	}
+	float forget = trace < MODEL_PARAMS * MODEL_P_INITIAL ? MODEL_FORGET : 1.0f;
+	for (uint8_t i = 0; i < MODEL_PARAMS; i++) {
+		for (uint8_t j = 0; j < MODEL_PARAMS; j++) {
+			// P is symmetric, px is also x' P
+			m_p[i][j] = (m_p[i][j] - k[i] * px[j]) / forget;
+		}
+	}
+	for (uint8_t i = 0; i < MODEL_PARAMS; i++) {
+		for (uint8_t j = 0; j < i; j++) {
+			m_p[i][j] = m_p[j][i] = (m_p[i][j] + m_p[j][i]) * 0.5f;
+		}
+	}
+
+	m_error += (e * e - m_error) / (m_updates < MODEL_ERROR_WINDOW ? m_updates + 1 : MODEL_ERROR_WINDOW);
+	m_updates++;
+}
+
+void ThermalModel::save(ModelState &state) const {
+	for (uint8_t i = 0; i < MODEL_PARAMS; i++) {
+		state.theta[i] = m_theta[i];
+	}
+	state.error = m_error;
+	state.updates = m_updates;
+}
+
+void ThermalModel::restore(const ModelState &state) {
+	reset();
+	for (uint8_t i = 0; i < MODEL_PARAMS; i++) {
+		if (isnan(state.theta[i])) {
+			return;
+		}
+	}
+	for (uint8_t i = 0; i < MODEL_PARAMS; i++) {
+		m_theta[i] = state.theta[i];
+		m_p[i][i] = MODEL_P_RESTORED;
+	}
+	m_error = state.error;
+	m_updates = state.updates;
+}
@@ -0,0 +1,78 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Model.h
+ * Created on: 19 Oct 2026
+ * Description: Thimo learned thermal model
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#ifndef _THIMO_MODEL_H_
+#define _THIMO_MODEL_H_
+
+#include <Arduino.h>
+#include "config.h"
+
+#define MODEL_PARAMS				3
+#define MODEL_NO_LEAD				0UL		// lead() when the model can't tell
+#define MODEL_REFERENCE				20.0f	// °C, the temperature term is taken around it
+
+// What survives a reboot, the covariance starts over from MODEL_P_RESTORED
+struct ModelState {
+	float theta[MODEL_PARAMS];
+	float error;			// mean square prediction error, (°C/h)²
+	uint32_t updates;
+};
+
+// How fast a room warms up, in °C per hour, as a linear function of the
+// heater duty u over a window and of the room temperature T:
+//   dT/dt = gain * u - loss * (T - MODEL_REFERENCE) + drift
+// The loss term is the heat going out through the walls, drift the rate
+// at the reference temperature with the heater off: it holds the outside
+// temperature, folded into a constant as there is no outdoor sensor.
+// Taking T around the reference keeps its term apart from the constant. Recursive least squares with forgetting fits the three
+// parameters on every MODEL_PERIOD window of samples, in constant memory;
+// the forgetting follows the seasons.
+class ThermalModel {
+public:
+	ThermalModel();
+
+	void reset();
+	void update(float temperature, bool heating, unsigned long now);
+	float rate(float duty, float temperature) const;
+	uint32_t lead(float from, float to) const;
+
+	void save(ModelState &state) const;
+	void restore(const ModelState &state);
+
+	inline bool ready() const { return m_updates >= MODEL_MIN_UPDATES && m_theta[0] > 0.0f; }
+	inline uint32_t updates() const { return m_updates; }
+	inline float gain() const { return m_theta[0]; }		// °C/h at full duty
+	inline float loss() const { return -m_theta[1]; }		// 1/h
+	inline float drift() const { return m_theta[2]; }		// °C/h at MODEL_REFERENCE
+	inline float error() const { return sqrtf(m_error); }	// rms, °C/h
+	inline float measured() const { return m_measured; }	// last window, °C/h
+	inline float predicted() const { return m_predicted; }	// for it, before the update
+private:
+	float m_theta[MODEL_PARAMS];
+	float m_p[MODEL_PARAMS][MODEL_PARAMS];
+	float m_error;
+	uint32_t m_updates;
+	float m_measured;
+	float m_predicted;
+
+	// current window
+	bool m_started;
+	float m_from;
+	bool m_heating;
+	unsigned long m_start;
+	unsigned long m_last;
+	unsigned long m_onTime;
+
+	void fit(const float *x, float y);
+};
+
+#endif
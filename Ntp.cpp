@@ -0,0 +1,242 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Ntp.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo SNTP client
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Ntp.h"
+#include "Clock.h"
+#include "Log.h"
+
+#if !defined(ESP32) && defined(__linux__)
+#include <errno.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#ifdef ESP32
+
+WiFiTransport::WiFiTransport(const char *server, uint16_t port) :
+	m_server(server),
+	m_port(port),
+	m_open(false) {
+}
+
+// The link is joined by the HTTP server (see Http.h)
+bool WiFiTransport::begin() {
+	return WIFI_SSID[0] != '\0';
+}
+
+bool WiFiTransport::send(const uint8_t *data, size_t n) {
+	if (!m_open) {
+		if (WiFi.status() != WL_CONNECTED || !WiFi.hostByName(m_server, m_address)) {
+			return false;
+		}
+		m_open = m_udp.begin(0) != 0;
+		if (!m_open) {
+			return false;
+		}
+	}
+	if (!m_udp.beginPacket(m_address, m_port)) {
+		return false;
+	}
+	m_udp.write(data, n);
+
+	return m_udp.endPacket() != 0;
+}
+
+int WiFiTransport::receive(uint8_t *data, size_t n) {
+	int length = m_udp.parsePacket();
+
+	if (length <= 0) {
+		return 0;
+	}
+	m_udp.read(data, (size_t)length < n ? length : n);
+
+	return length;
+}
+
+#elif defined(__linux__)
+
+SocketTransport::SocketTransport(uint16_t port) :
+	m_port(port),
+	m_socket(-1) {
+}
+
+bool SocketTransport::begin() {
+	struct sockaddr_in address;
+
+	m_socket = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+	if (m_socket < 0) {
+		return false;
+	}
+
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = htons(m_port);
+	if (connect(m_socket, (struct sockaddr *)&address, sizeof(address)) < 0) {
+		::close(m_socket);
+		m_socket = -1;
+		return false;
+	}
+
+	return true;
+}
+
+bool SocketTransport::send(const uint8_t *data, size_t n) {
+	return ::send(m_socket, data, n, 0) == (ssize_t)n;
+}
+
+// Nobody listening shows up as a refused receive, just no reply
+int SocketTransport::receive(uint8_t *data, size_t n) {
+	ssize_t count = recv(m_socket, data, n, MSG_TRUNC);
+
+	return count > 0 ? (int)count : 0;
+}
+
+#endif
+
+#if defined(THIMO_SIMULATION) || !(defined(ESP32) || defined(__linux__))
+
+// The clock is virtual or there's no network
+class NoTransport : public NtpTransport {
+public:
+	virtual bool begin() { return false; }
+	virtual bool send(const uint8_t *data, size_t n) { return false; }
+	virtual int receive(uint8_t *data, size_t n) { return 0; }
+};
+
+static NoTransport transport;
+
+#elif defined(ESP32)
+
+static WiFiTransport transport(NTP_SERVER, NTP_PORT);
+
+#else
+
+static SocketTransport transport(NTP_HOST_PORT);
+
+#endif
+
+static inline uint32_t ntpGet32(const uint8_t *src) {
+	return (uint32_t)src[0] << 24 | (uint32_t)src[1] << 16 | (uint32_t)src[2] << 8 | src[3];
+}
+
+static inline void ntpPut32(uint8_t *dst, uint32_t value) {
+	dst[0] = value >> 24;
+	dst[1] = value >> 16;
+	dst[2] = value >> 8;
+	dst[3] = value;
+}
+
+// Binary fraction of a second to milliseconds
+static inline uint32_t ntpMillis(uint32_t fraction) {
+	return ((uint64_t)fraction * 1000U) >> 32;
+}
+
+NtpModule::NtpModule(NtpTransport &transport) :
+	m_transport(transport),
+	m_online(false),
+	m_waiting(false),
+	m_sent(0UL),
+	m_timer(0UL),
+	m_interval(0UL),
+	m_seconds(0),
+	m_fraction(0),
+	m_syncs(0),
+	m_failures(0),
+	m_delay(0) {
+}
+
+void NtpModule::begin() {
+	m_online = m_transport.begin();
+	m_timer = Clock.millis();
+}
+
+// The reply is timestamped with the pass that finds it
+void NtpModule::poll() {
+	uint8_t packet[NTP_PACKET_SIZE];
+	unsigned long now = Clock.millis();
+	int n;
+
+	if (!m_online) {
+		return;
+	}
+
+	if (m_waiting) {
+		while ((n = m_transport.receive(packet, sizeof(packet))) > 0) {
+			if (n == NTP_PACKET_SIZE && reply(packet, now)) {
+				m_waiting = false;
+				m_syncs++;
+				m_timer = now;
+				m_interval = NTP_PERIOD;
+				return;
+			}
+		}
+		if (now - m_sent >= NTP_TIMEOUT) {
+			m_waiting = false;
+			m_failures++;
+			m_timer = now;
+			m_interval = NTP_RETRY;
+		}
+	} else if (now - m_timer >= m_interval && request()) {
+		m_waiting = true;
+		m_sent = now;
+	}
+}
+
+bool NtpModule::request() {
+	uint8_t packet[NTP_PACKET_SIZE];
+
+	memset(packet, 0, sizeof(packet));
+	packet[0] = 0x23;		// no leap second warning, version 4, client
+
+	// any transmit time will do, the server has to echo it back
+	m_seconds = Clock.utc() + NTP_UNIX_OFFSET;
+	m_fraction = micros();
+	ntpPut32(packet + 40, m_seconds);
+	ntpPut32(packet + 44, m_fraction);
+
+	return m_transport.send(packet, sizeof(packet));
+}
+
+bool NtpModule::reply(const uint8_t *packet, unsigned long at) {
+	// a server, synchronised, not a kiss-o'-death, answering our request
+	if ((packet[0] & 0x07) != 4 || (packet[0] & 0xc0) == 0xc0 || packet[1] == 0 || packet[1] > 15) {
+		return false;
+	}
+	if (ntpGet32(packet + 24) != m_seconds || ntpGet32(packet + 28) != m_fraction) {
+		return false;
+	}
+
+	uint32_t received = ntpGet32(packet + 32);
+	uint32_t transmit = ntpGet32(packet + 40);
+	uint32_t transmitMillis = ntpMillis(ntpGet32(packet + 44));
+	uint32_t hold = (transmit - received) * 1000UL + transmitMillis - ntpMillis(ntpGet32(packet + 36));
+	uint32_t delay = at - m_sent;
+
+	delay = delay > hold ? delay - hold : 0;
+	if (delay > NTP_MAX_DELAY) {
+		return false;
+	}
+
+	// era 0 ends in 2036, unsigned arithmetic carries on into era 1
+	uint32_t ms = transmitMillis + delay / 2;
+	int32_t offset = Clock.sync(transmit - NTP_UNIX_OFFSET + ms / 1000UL, ms % 1000UL, at);
+
+	m_delay = delay;
+	LOG_INFO(LOG_NTP, offset, delay);
+
+	return true;
+}
+
+NtpModule Ntp(transport);
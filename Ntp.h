@@ -0,0 +1,103 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Ntp.h
+ * Created on: 19 Oct 2026
+ * Description: Thimo SNTP client
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#ifndef _THIMO_NTP_H_
+#define _THIMO_NTP_H_
+
+#include <Arduino.h>
+#include "config.h"
+
+#ifdef ESP32
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#endif
+
+#define NTP_PACKET_SIZE				48
+#define NTP_UNIX_OFFSET				2208988800UL	// s from 1900 to 1970
+
+// Datagrams to and from the time server, neither side ever waits
+class NtpTransport {
+public:
+	virtual ~NtpTransport() {}
+
+	virtual bool begin() = 0;								// false when there's no network
+	virtual bool send(const uint8_t *data, size_t n) = 0;	// false when not possible yet
+	virtual int receive(uint8_t *data, size_t n) = 0;		// datagram length, 0 none
+};
+
+#ifdef ESP32
+// The server name is looked up once the link is up, the lookup blocks
+class WiFiTransport : public NtpTransport {
+public:
+	WiFiTransport(const char *server, uint16_t port);
+
+	virtual bool begin();
+	virtual bool send(const uint8_t *data, size_t n);
+	virtual int receive(uint8_t *data, size_t n);
+private:
+	const char *m_server;
+	uint16_t m_port;
+	IPAddress m_address;
+	WiFiUDP m_udp;
+	bool m_open;
+};
+#elif defined(__linux__)
+// Host builds ask a time server on the loopback, for tests
+class SocketTransport : public NtpTransport {
+public:
+	SocketTransport(uint16_t port);
+
+	virtual bool begin();
+	virtual bool send(const uint8_t *data, size_t n);
+	virtual int receive(uint8_t *data, size_t n);
+private:
+	uint16_t m_port;
+	int m_socket;
+};
+#endif
+
+// Simple NTP (RFC 4330) client: one request every NTP_PERIOD, every
+// NTP_RETRY after a failure. The reply has to echo the request's transmit
+// time, come from a synchronised server and arrive within NTP_MAX_DELAY;
+// the time at its arrival is the server's transmit time plus half the
+// network delay, and the clock is set to it (see Clock.h). Nothing waits:
+// poll() sends the request or looks for the reply.
+class NtpModule {
+public:
+	NtpModule(NtpTransport &transport);
+
+	void begin();
+	void poll();
+
+	inline uint32_t syncs() const { return m_syncs; }
+	inline uint32_t failures() const { return m_failures; }	// no reply, or not a good one
+	inline uint32_t delay() const { return m_delay; }			// ms, network round trip of the last sync
+private:
+	bool request();
+	bool reply(const uint8_t *packet, unsigned long at);
+
+	NtpTransport &m_transport;
+	bool m_online;
+	bool m_waiting;
+	unsigned long m_sent;		// millis() the request went out
+	unsigned long m_timer;
+	unsigned long m_interval;	// to the next request
+	uint32_t m_seconds;			// transmit time of the request, echoed back
+	uint32_t m_fraction;
+	uint32_t m_syncs;
+	uint32_t m_failures;
+	uint32_t m_delay;
+};
+
+extern NtpModule Ntp;
+
+#endif
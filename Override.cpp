@@ -0,0 +1,200 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Override.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo schedule overrides
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Override.h"
+
+#if defined(ESP32) && !defined(THIMO_SIMULATION)
+#include <Preferences.h>
+#endif
+
+static const char *const overrideNames[OVERRIDE_KINDS] = { "holiday", "away", "hold", "boost" };
+
+// Higher priority first, then the earlier start
+static inline bool overrideBefore(const Override &a, const Override &b) {
+	return a.kind > b.kind || (a.kind == b.kind && a.start < b.start);
+}
+
+OverrideModule::OverrideModule() {
+	reset();
+}
+
+// The entries saved before the reboot, if any. Simulated time has nothing
+// to do with them, they are neither loaded nor saved.
+void OverrideModule::begin() {
+#if defined(ESP32) && !defined(THIMO_SIMULATION)
+	Preferences preferences;
+
+	if (!preferences.begin("thimo", true)) {
+		return;
+	}
+	size_t n = preferences.getBytes("overrides", m_entries, sizeof(m_entries));
+	preferences.end();
+
+	m_count = n % sizeof(Override) == 0 ? n / sizeof(Override) : 0;
+	for (uint8_t i = 0; i < m_count; i++) {
+		if (m_entries[i].kind >= OVERRIDE_KINDS || (i > 0 && overrideBefore(m_entries[i], m_entries[i - 1]))) {
+			m_count = 0;
+		}
+	}
+	m_next = 0;
+#endif
+}
+
+void OverrideModule::reset() {
+	m_count = 0;
+	m_next = OVERRIDE_FOREVER;
+	for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+		m_active[z] = -1;
+	}
+}
+
+// False when it ends before now or there's no free slot, nothing changes
+// then. The slots the entry frees by taking zones away count as free.
+bool OverrideModule::add(const Override &entry, uint32_t now) {
+	uint8_t lo = 0;
+	uint8_t hi;
+	uint8_t kept = 0;
+
+	if (entry.kind >= OVERRIDE_KINDS || entry.zones == 0 || entry.end <= now || entry.end <= entry.start) {
+		return false;
+	}
+	for (uint8_t i = 0; i < m_count; i++) {
+		const Override &other = m_entries[i];
+		uint16_t zones = other.zones;
+
+		if (other.kind == entry.kind && other.start < entry.end && entry.start < other.end) {
+			zones &= ~entry.zones;
+		}
+		if (other.end > now && zones != 0) {
+			kept++;
+		}
+	}
+	if (kept >= OVERRIDE_SLOTS) {
+		return false;
+	}
+
+	for (uint8_t i = 0; i < m_count; i++) {
+		Override &other = m_entries[i];
+
+		if (other.kind == entry.kind && other.start < entry.end && entry.start < other.end) {
+			other.zones &= ~entry.zones;
+		}
+	}
+	resolve(now);
+
+	hi = m_count;
+	while (lo < hi) {
+		uint8_t mid = (lo + hi) / 2;
+
+		if (overrideBefore(m_entries[mid], entry)) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	memmove(&m_entries[lo + 1], &m_entries[lo], (m_count - lo) * sizeof(Override));
+	m_entries[lo] = entry;
+	m_count++;
+	resolve(now);
+	save();
+
+	return true;
+}
+
+void OverrideModule::remove(uint8_t kind, uint16_t zones, uint32_t now) {
+	for (uint8_t i = 0; i < m_count; i++) {
+		if (m_entries[i].kind == kind) {
+			m_entries[i].zones &= ~zones;
+		}
+	}
+	resolve(now);
+	save();
+}
+
+// True when the setpoint of a zone changed
+bool OverrideModule::update(uint32_t now) {
+	return now >= m_next && resolve(now);
+}
+
+const char *OverrideModule::name(uint8_t kind) {
+	return kind < OVERRIDE_KINDS ? overrideNames[kind] : "";
+}
+
+// Drops the entries that ended or lost all their zones, then each zone
+// takes the first entry in force in priority order. True when a zone got
+// another kind or setpoint.
+bool OverrideModule::resolve(uint32_t now) {
+	int8_t kinds[ZONE_COUNT];
+	int16_t setpoints[ZONE_COUNT];
+	bool changed = false;
+	uint8_t n = 0;
+
+	for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+		kinds[z] = m_active[z] < 0 ? -1 : m_entries[m_active[z]].kind;
+		setpoints[z] = m_active[z] < 0 ? 0 : m_entries[m_active[z]].setpoint;
+		m_active[z] = -1;
+	}
+	for (uint8_t i = 0; i < m_count; i++) {
+		if (m_entries[i].end > now && m_entries[i].zones != 0) {
+			m_entries[n++] = m_entries[i];
+		}
+	}
+	m_count = n;
+
+	m_next = OVERRIDE_FOREVER;
+	for (uint8_t i = 0; i < m_count; i++) {
+		const Override &entry = m_entries[i];
+
+		if (entry.start > now) {
+			if (entry.start < m_next) {
+				m_next = entry.start;
+			}
+			continue;
+		}
+		if (entry.end < m_next) {
+			m_next = entry.end;
+		}
+		for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+			if (m_active[z] < 0 && (entry.zones >> z & 1)) {
+				m_active[z] = i;
+			}
+		}
+	}
+
+	for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+		const Override *entry = active(z);
+
+		if (entry == NULL ? kinds[z] >= 0 : entry->kind != kinds[z] || entry->setpoint != setpoints[z]) {
+			changed = true;
+		}
+	}
+
+	return changed;
+}
+
+void OverrideModule::save() {
+#if defined(ESP32) && !defined(THIMO_SIMULATION)
+	Preferences preferences;
+
+	if (!preferences.begin("thimo", false)) {
+		return;
+	}
+	if (m_count > 0) {
+		preferences.putBytes("overrides", m_entries, m_count * sizeof(Override));
+	} else {
+		preferences.remove("overrides");
+	}
+	preferences.end();
+#endif
+}
+
+OverrideModule Overrides;
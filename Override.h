@@ -0,0 +1,76 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Override.h
+ * Created on: 19 Oct 2026
+ * Description: Thimo schedule overrides
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#ifndef _THIMO_OVERRIDE_H_
+#define _THIMO_OVERRIDE_H_
+
+#include <Arduino.h>
+#include "Zone.h"
+#include "config.h"
+
+#define OVERRIDE_FOREVER			0xffffffffUL	// no end
+
+// In order of priority, the last one wins
+enum OverrideKind {
+	OVERRIDE_HOLIDAY,		// a calendar period, every zone
+	OVERRIDE_AWAY,			// from now, every zone
+	OVERRIDE_HOLD,			// until the next program change
+	OVERRIDE_BOOST,			// OVERRIDE_BOOST_TIME
+	OVERRIDE_KINDS
+};
+
+struct Override {
+	uint32_t start;			// local unixtime
+	uint32_t end;			// first second it no longer applies
+	int16_t setpoint;		// tenths of °C
+	uint16_t zones;			// bit z for zone z
+	uint8_t kind;
+};
+
+// Setpoints that take over from the schedule for a while. The entries are
+// kept sorted by priority, then start; an entry goes in at the place a
+// binary search finds. The entry of each zone is resolved again only when
+// one starts or ends: update() is a single comparison until next(), so the
+// control pass reads a cached result.
+//
+// Adding an entry takes its zones away from the entries of the same kind
+// it overlaps, a new boost replaces the running one, holidays don't
+// collide. Changes are saved to flash, expired entries are dropped.
+class OverrideModule {
+public:
+	OverrideModule();
+
+	void begin();
+	void reset();
+	bool add(const Override &entry, uint32_t now);
+	void remove(uint8_t kind, uint16_t zones, uint32_t now);
+	bool update(uint32_t now);
+
+	inline const Override *active(uint8_t z) const { return m_active[z] < 0 ? NULL : &m_entries[m_active[z]]; }
+	inline uint8_t count() const { return m_count; }
+	inline const Override &entry(uint8_t i) const { return m_entries[i]; }
+	inline uint32_t next() const { return m_next; }		// the next start or end
+
+	static const char *name(uint8_t kind);
+private:
+	bool resolve(uint32_t now);
+	void save();
+
+	Override m_entries[OVERRIDE_SLOTS];
+	uint8_t m_count;
+	int8_t m_active[ZONE_COUNT];	// entry of each zone, -1 for the schedule
+	uint32_t m_next;
+};
+
+extern OverrideModule Overrides;
+
+#endif
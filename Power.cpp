@@ -0,0 +1,220 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Power.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo power management
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Power.h"
+
+#if POWER_SLEEP && defined(ESP32)
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+#include <driver/uart.h>
+
+static const uint8_t buttonPins[] = { BUTTON_S_PIN, BUTTON_N_PIN, BUTTON_P_PIN };
+#endif
+
+static const uint16_t levelMhz[PowerModule::LEVEL_COUNT] = { 80, 160, 240 };
+static const float levelCurrent[PowerModule::LEVEL_COUNT] = { POWER_CURRENT_80, POWER_CURRENT_160, POWER_CURRENT_240 };
+
+PowerModule::PowerModule() :
+	m_sleepTime(0ULL),
+	m_sleeps(0),
+	m_serialTime(0UL),
+	m_wakeTime(0UL),
+	m_buttonWake(false),
+	m_latency(0),
+	m_level(LEVEL_240),
+	m_pinned(-1),
+	m_levelStart(0UL),
+	m_boostTime(0UL),
+	m_switches(0) {
+	for (int i = 0; i < WAKE_COUNT; i++) {
+		m_wakeups[i] = 0;
+	}
+	for (int l = 0; l < LEVEL_COUNT; l++) {
+		m_levelTime[l] = 0ULL;
+		for (int t = 0; t < TASK_COUNT; t++) {
+			m_taskCount[l][t] = 0;
+			m_taskTime[l][t] = 0;
+		}
+	}
+}
+
+// After the buttons and the serial port have been set up. Buttons pull their
+// line low, a low level wakes the chip; the UART wakes after a few edges.
+// Boot runs at the frequency set in the IDE, the governor takes over here.
+void PowerModule::begin() {
+#ifdef ESP32
+	m_level = levelOf(getCpuFrequencyMhz());
+#endif
+#if POWER_GOVERNOR
+	set(levelOf(POWER_IDLE_MHZ));
+#endif
+#if POWER_SLEEP && defined(ESP32)
+	for (uint8_t i = 0; i < sizeof(buttonPins); i++) {
+		gpio_wakeup_enable((gpio_num_t)buttonPins[i], GPIO_INTR_LOW_LEVEL);
+	}
+	esp_sleep_enable_gpio_wakeup();
+	uart_set_wakeup_threshold(UART_NUM_0, 3);
+	esp_sleep_enable_uart_wakeup(UART_NUM_0);
+#endif
+}
+
+// Sleeps for up to ms milliseconds, the caller makes sure nothing is due
+// before then. Short idle times aren't worth the trip.
+void PowerModule::sleep(HardwareSerial &io, unsigned long ms) {
+#if POWER_SLEEP && defined(ESP32)
+	if (ms < POWER_MIN_SLEEP) {
+		return;
+	}
+
+	// the input that woke the UART was lost, wait for the retry
+	if (millis() - m_serialTime < POWER_SERIAL_AWAKE) {
+		return;
+	}
+
+	// a button still held would wake us right away
+	for (uint8_t i = 0; i < sizeof(buttonPins); i++) {
+		if (digitalRead(buttonPins[i]) == LOW) {
+			return;
+		}
+	}
+
+	// the UART stops with the clocks, let the last bytes out first
+	io.flush();
+
+	esp_sleep_enable_timer_wakeup(ms * 1000ULL);
+	unsigned long start = micros();
+	m_levelTime[m_level] += start - m_levelStart;
+	esp_light_sleep_start();
+	m_levelStart = micros();
+	m_sleepTime += m_levelStart - start;
+	m_sleeps++;
+
+	switch (esp_sleep_get_wakeup_cause()) {
+		case ESP_SLEEP_WAKEUP_TIMER:
+			m_wakeups[WAKE_TIMER]++;
+			break;
+		case ESP_SLEEP_WAKEUP_GPIO:
+			m_wakeups[WAKE_BUTTON]++;
+			m_wakeTime = millis();
+			m_buttonWake = true;
+			break;
+		case ESP_SLEEP_WAKEUP_UART:
+			m_wakeups[WAKE_SERIAL]++;
+			m_serialTime = millis();
+			break;
+		default:
+			m_wakeups[WAKE_OTHER]++;
+			break;
+	}
+#endif
+}
+
+// A button press reached the user interface
+void PowerModule::pressed() {
+	if (m_buttonWake) {
+		uint32_t latency = millis() - m_wakeTime;
+		if (latency > m_latency) {
+			m_latency = latency;
+		}
+		m_buttonWake = false;
+	}
+}
+
+// Bursty work ahead: a display redraw, a dump, a network exchange
+void PowerModule::boost() {
+#if POWER_GOVERNOR
+	m_boostTime = millis();
+	if (m_pinned < 0) {
+		set(levelOf(POWER_BURST_MHZ));
+	}
+#endif
+}
+
+// Called every loop, drops back once the work has been over for a while
+void PowerModule::govern() {
+#if POWER_GOVERNOR
+	if (m_pinned < 0 && millis() - m_boostTime >= POWER_BOOST_HOLD) {
+		set(levelOf(POWER_IDLE_MHZ));
+	}
+#endif
+}
+
+// Fixes the frequency at a level, for measuring at it; -1 hands it back
+// to the governor
+void PowerModule::pin(int8_t level) {
+	m_pinned = level;
+	if (level >= 0) {
+		set((Level)level);
+	}
+}
+
+void PowerModule::measure(Task task, unsigned long us) {
+	m_taskCount[m_level][task]++;
+	m_taskTime[m_level][task] += us;
+}
+
+uint16_t PowerModule::mhz(Level level) {
+	return levelMhz[level];
+}
+
+float PowerModule::current(Level level) {
+	return levelCurrent[level];
+}
+
+uint32_t PowerModule::levelTime(Level level) const {
+	uint64_t us = m_levelTime[level];
+
+	if (level == m_level) {
+		us += micros() - m_levelStart;
+	}
+
+	return (uint32_t)(us / 1000ULL);
+}
+
+float PowerModule::energy() const {
+	float charge = sleepTime() * POWER_CURRENT_SLEEP;	// mA ms
+
+	for (uint8_t l = 0; l < LEVEL_COUNT; l++) {
+		charge += levelTime((Level)l) * levelCurrent[l];
+	}
+
+	// to mAh, times the supply voltage
+	return charge / 3600000.0f * POWER_VOLTAGE;
+}
+
+void PowerModule::set(Level level) {
+	if (level == m_level) {
+		return;
+	}
+
+	unsigned long now = micros();
+	m_levelTime[m_level] += now - m_levelStart;
+	m_levelStart = now;
+#ifdef ESP32
+	setCpuFrequencyMhz(levelMhz[level]);
+#endif
+	m_level = level;
+	m_switches++;
+}
+
+// The slowest level running at least mhz
+PowerModule::Level PowerModule::levelOf(uint16_t mhz) {
+	for (uint8_t l = 0; l < LEVEL_COUNT; l++) {
+		if (levelMhz[l] >= mhz) {
+			return (Level)l;
+		}
+	}
+
+	return LEVEL_240;
+}
+
+PowerModule Power;
@@ -0,0 +1,105 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Power.h
+ * Created on: 19 Oct 2026
+ * Description: Thimo power management
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#ifndef _THIMO_POWER_H_
+#define _THIMO_POWER_H_
+
+#include <Arduino.h>
+#include "config.h"
+
+// Light sleep between scheduled tasks (POWER_SLEEP, ESP32 only). The chip
+// wakes on the next deadline, on a button pressed or on serial input; GPIO
+// outputs, RAM and the millis() timebase are kept across it, so the relays
+// and the clock don't notice. The characters that wake the UART are lost,
+// a console session starts with a newline; the chip then stays awake for
+// POWER_SERIAL_AWAKE, and so does the caller while the console is in use.
+//
+// The frequency governor (POWER_GOVERNOR) runs the CPU at POWER_IDLE_MHZ
+// and raises it to POWER_BURST_MHZ when boost() announces bursty work, for
+// POWER_BOOST_HOLD after the last call. The APB clock stays at 80 MHz at
+// every level, so the UART, I2C and micros() don't notice the switch.
+// Time at each level, and the cost of the tasks run at it, are counted to
+// estimate the energy with the POWER_CURRENT_* figures.
+class PowerModule {
+public:
+	typedef enum {
+		WAKE_TIMER,
+		WAKE_BUTTON,
+		WAKE_SERIAL,
+		WAKE_OTHER,
+		WAKE_COUNT
+	} Wake;
+
+	typedef enum {
+		LEVEL_80,
+		LEVEL_160,
+		LEVEL_240,
+		LEVEL_COUNT
+	} Level;
+
+	typedef enum {
+		TASK_RENDER,		// a display redraw
+		TASK_CONTROL,		// a control pass over all zones
+		TASK_EXPORT,		// a HISTORY or TRACE dump frame
+		TASK_COUNT
+	} Task;
+
+	PowerModule();
+
+	void begin();
+	void sleep(HardwareSerial &io, unsigned long ms);
+	void pressed();
+
+	void boost();
+	void govern();
+	void pin(int8_t level);
+	void measure(Task task, unsigned long us);
+
+	static uint16_t mhz(Level level);
+	static float current(Level level);	// mA
+	inline Level level() const { return m_level; }
+	inline bool pinned() const { return m_pinned >= 0; }
+	inline uint32_t switches() const { return m_switches; }
+	uint32_t levelTime(Level level) const;	// ms awake at the level
+	inline uint32_t taskCount(Level level, Task task) const { return m_taskCount[level][task]; }
+	inline uint32_t taskTime(Level level, Task task) const { return m_taskTime[level][task]; }	// µs
+	float energy() const;	// mWh since boot
+
+	inline uint32_t sleeps() const { return m_sleeps; }
+	inline uint32_t sleepTime() const { return (uint32_t)(m_sleepTime / 1000ULL); }	// ms
+	inline uint32_t awakeTime() const { return millis() - sleepTime(); }				// ms
+	inline uint32_t wakeups(Wake cause) const { return m_wakeups[cause]; }
+	inline uint32_t latency() const { return m_latency; }	// ms, worst button wake to press seen
+private:
+	uint64_t m_sleepTime;		// µs
+	uint32_t m_sleeps;
+	uint32_t m_wakeups[WAKE_COUNT];
+	unsigned long m_serialTime;	// last serial wakeup
+	unsigned long m_wakeTime;
+	bool m_buttonWake;			// woken by a button, its press not seen yet
+	uint32_t m_latency;
+	Level m_level;
+	int8_t m_pinned;			// level fixed from the console, -1 if governed
+	unsigned long m_levelStart;	// µs, start of the current stretch at m_level
+	uint64_t m_levelTime[LEVEL_COUNT];	// µs
+	unsigned long m_boostTime;
+	uint32_t m_switches;
+	uint32_t m_taskCount[LEVEL_COUNT][TASK_COUNT];
+	uint32_t m_taskTime[LEVEL_COUNT][TASK_COUNT];
+
+	void set(Level level);
+	static Level levelOf(uint16_t mhz);
+};
+
+extern PowerModule Power;
+
+#endif
@@ -11,8 +11,9 @@
  */
 
 #include "RTC.h"
+#include "LCD.h"
 
-RTCModule::RTCModule() : RTC_DS1307() {
+RTCModule::RTCModule() : RTC_DS1307(), m_section(WatchdogModule::SECTION_BOOT) {
 	
 }
 
@@ -20,4 +21,71 @@ RTCModule::~RTCModule() {
 	
 }
 
+bool RTCModule::begin() {
+	slow();
+	bool found = RTC_DS1307::begin(&Wire);
+	fast();
+	return found;
+}
+
+uint8_t RTCModule::isrunning() {
+	slow();
+	uint8_t running = RTC_DS1307::isrunning();
+	fast();
+	return running;
+}
+
+void RTCModule::adjust(const DateTime &dt) {
+	slow();
+	RTC_DS1307::adjust(dt);
+	fast();
+}
+
+DateTime RTCModule::now() {
+	slow();
+	DateTime dt = RTC_DS1307::now();
+	fast();
+	return dt;
+}
+
+uint8_t RTCModule::readnvram(uint8_t address) {
+	slow();
+	uint8_t data = RTC_DS1307::readnvram(address);
+	fast();
+	return data;
+}
+
+void RTCModule::readnvram(uint8_t *buf, uint8_t size, uint8_t address) {
+	slow();
+	RTC_DS1307::readnvram(buf, size, address);
+	fast();
+}
+
+void RTCModule::writenvram(uint8_t address, uint8_t data) {
+	slow();
+	RTC_DS1307::writenvram(address, data);
+	fast();
+}
+
+void RTCModule::writenvram(uint8_t address, const uint8_t *buf, uint8_t size) {
+	slow();
+	RTC_DS1307::writenvram(address, buf, size);
+	fast();
+}
+
+void RTCModule::slow() {
+	m_section = Watchdog.enter(WatchdogModule::SECTION_RTC);
+#if I2C_CLOCK != RTC_I2C_CLOCK
+	LCD.wait();
+	Wire.setClock(RTC_I2C_CLOCK);
+#endif
+}
+
+void RTCModule::fast() {
+#if I2C_CLOCK != RTC_I2C_CLOCK
+	Wire.setClock(I2C_CLOCK);
+#endif
+	Watchdog.enter(m_section);
+}
+
 RTCModule RTC;
@@ -14,11 +14,32 @@
 #define _THIMO_RTC_H_
 
 #include <RTClib.h>
+#include "Watchdog.h"
+#include "config.h"
 
+// The DS1307 only talks Standard-mode: with I2C_FAST_MODE every access drops
+// the shared bus to RTC_I2C_CLOCK and restores I2C_CLOCK for the display
+// afterwards. A frame the display task is sending from the other core is
+// let finish first, the clock never changes under one of its transfers.
+// A hung transaction shows up as a stall in SECTION_RTC.
 class RTCModule : public RTC_DS1307 {
 public:
 	RTCModule();
 	virtual ~RTCModule();
+
+	bool begin();
+	uint8_t isrunning();
+	void adjust(const DateTime &dt);
+	DateTime now();
+	uint8_t readnvram(uint8_t address);
+	void readnvram(uint8_t *buf, uint8_t size, uint8_t address);
+	void writenvram(uint8_t address, uint8_t data);
+	void writenvram(uint8_t address, const uint8_t *buf, uint8_t size);
+private:
+	void slow();
+	void fast();
+
+	WatchdogModule::Section m_section;
 };
 
 extern RTCModule RTC;
@@ -0,0 +1,94 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: SHT3x.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo SHT3x I2C sensor driver
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "SHT3x.h"
+
+SHT3xSensor::SHT3xSensor(uint8_t addr) : m_addr(addr) {
+}
+
+SHT3xSensor::Status SHT3xSensor::start() {
+	Wire.beginTransmission(m_addr);
+	Wire.write((uint8_t)(SHT3X_MEASURE >> 8));
+	Wire.write((uint8_t)SHT3X_MEASURE);
+
+	return Wire.endTransmission() == 0 ? ERROR_NONE : ERROR_BUS;
+}
+
+SHT3xSensor::Status SHT3xSensor::poll(Environment *env) {
+	uint8_t data[6];
+
+	if (elapsed() <= SHT3X_CONVERSION_TIME) {
+		return ERROR_RETRY;
+	}
+
+	// temperature msb, lsb, crc, humidity msb, lsb, crc
+	if (Wire.requestFrom(m_addr, (uint8_t)sizeof(data)) != sizeof(data)) {
+		return ERROR_BUS;
+	}
+	for (uint8_t i = 0; i < sizeof(data); i++) {
+		data[i] = Wire.read();
+	}
+	if (crc(data) != data[2] || crc(data + 3) != data[5]) {
+		return ERROR_CHECKSUM;
+	}
+
+	env->temperature = -45.0f + 175.0f * ((data[0] << 8) | data[1]) / 65535.0f;
+	env->humidity = 100.0f * ((data[3] << 8) | data[4]) / 65535.0f;
+
+	return ERROR_NONE;
+}
+
+// CRC-8 over a 16 bit word, polynomial 0x31, initial value 0xff
+uint8_t SHT3xSensor::crc(const uint8_t *data) {
+	uint8_t crc = 0xff;
+
+	for (uint8_t i = 0; i < 2; i++) {
+		crc ^= data[i];
+		for (uint8_t b = 0; b < 8; b++) {
+			crc = (crc & 0x80) ? (crc << 1) ^ 0x31 : crc << 1;
+		}
+	}
+
+	return crc;
+}
+
+uint8_t SHT3xSensor::capabilities() const {
+	return CAP_TEMPERATURE | CAP_HUMIDITY;
+}
+
+int SHT3xSensor::minimumSamplingPeriod() const {
+	return SHT3X_SAMPLING_PERIOD;
+}
+
+int8_t SHT3xSensor::numberOfDecimalsTemperature() const {
+	return 1;
+}
+
+int8_t SHT3xSensor::lowerBoundTemperature() const {
+	return -40;
+}
+
+int8_t SHT3xSensor::upperBoundTemperature() const {
+	return 125;
+}
+
+int8_t SHT3xSensor::numberOfDecimalsHumidity() const {
+	return 1;
+}
+
+int8_t SHT3xSensor::lowerBoundHumidity() const {
+	return 0;
+}
+
+int8_t SHT3xSensor::upperBoundHumidity() const {
+	return 100;
+}
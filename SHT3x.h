@@ -0,0 +1,49 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: SHT3x.h
+ * Created on: 19 Oct 2026
+ * Description: Thimo SHT3x I2C sensor driver
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#ifndef _THIMO_SHT3X_H_
+#define _THIMO_SHT3X_H_
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "Sensor.h"
+
+#define SHT3X_ADDRESS				0x44	// ADDR pin low, 0x45 when high
+#define SHT3X_MEASURE				0x2400	// single shot, high repeatability, no clock stretching
+#define SHT3X_CONVERSION_TIME		15		// ms, worst case at high repeatability
+#define SHT3X_SAMPLING_PERIOD		1000	// ms, faster sampling warms the sensor up
+
+// Single shot measurements on the shared Wire bus: start() sends the command,
+// poll() stays off the bus until the conversion time has passed, then reads
+// the result in one transaction. Neither waits on the sensor.
+class SHT3xSensor : public Sensor {
+public:
+	SHT3xSensor(uint8_t addr = SHT3X_ADDRESS);
+
+	virtual Status start();
+	virtual Status poll(Environment *env);
+
+	virtual uint8_t capabilities() const;
+	virtual int minimumSamplingPeriod() const;
+	virtual int8_t numberOfDecimalsTemperature() const;
+	virtual int8_t lowerBoundTemperature() const;
+	virtual int8_t upperBoundTemperature() const;
+	virtual int8_t numberOfDecimalsHumidity() const;
+	virtual int8_t lowerBoundHumidity() const;
+	virtual int8_t upperBoundHumidity() const;
+private:
+	static uint8_t crc(const uint8_t *data);
+
+	uint8_t m_addr;
+};
+
+#endif
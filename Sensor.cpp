@@ -0,0 +1,67 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Sensor.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo environmental sensor interface
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Sensor.h"
+
+Sensor::Sensor() :
+	m_startTime(0UL),
+	m_sampled(false),
+	m_converting(false),
+	m_captures(0),
+	m_errors(0) {
+}
+
+Sensor::Status Sensor::read(Environment *env) {
+	Status status;
+
+	env->temperature = NAN;
+	env->humidity = NAN;
+
+	if (!m_converting) {
+		// Make sure we don't poll the sensor too often. The very first request
+		// after boot goes through immediately: after a brown-out or watchdog
+		// reset the sensor has been powered all along
+		if (m_sampled && elapsed() < (unsigned long)minimumSamplingPeriod()) {
+			return ERROR_RETRY;
+		}
+		m_startTime = Clock.millis();
+		m_sampled = true;
+		if ((status = start()) != ERROR_NONE) {
+			m_captures++;
+			m_errors++;
+			return status;
+		}
+		m_converting = true;
+	}
+
+	status = poll(env);
+	if (status != ERROR_RETRY) {
+		m_converting = false;
+		m_captures++;
+		if (status != ERROR_NONE) {
+			m_errors++;
+		}
+	}
+
+	return status;
+}
+
+// Milliseconds before read() has something to do, 0 during a conversion
+unsigned long Sensor::idleTime() const {
+	unsigned long period = (unsigned long)minimumSamplingPeriod();
+
+	if (m_converting || !m_sampled || elapsed() >= period) {
+		return 0UL;
+	}
+
+	return period - elapsed();
+}
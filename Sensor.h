@@ -0,0 +1,73 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Sensor.h
+ * Created on: 19 Oct 2026
+ * Description: Thimo environmental sensor interface
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#ifndef _THIMO_SENSOR_H_
+#define _THIMO_SENSOR_H_
+
+#include <Arduino.h>
+#include "Clock.h"
+
+struct Environment {
+	float temperature;
+	float humidity;
+};
+
+// A reading is a conversion started by start() and collected by poll(),
+// which answers ERROR_RETRY until the result is in. read() paces both at
+// the sensor's sampling period and never waits for the conversion.
+class Sensor {
+public:
+	typedef enum {
+		ERROR_NONE = 0,
+		ERROR_RETRY,		// not due yet or conversion in progress
+		ERROR_TIMEOUT,
+		ERROR_CHECKSUM,
+		ERROR_BUS
+	} Status;
+
+	typedef enum {
+		CAP_TEMPERATURE = 0x01,
+		CAP_HUMIDITY = 0x02,
+		CAP_BLOCKING = 0x04		// poll() holds the CPU while it collects the result
+	} Capability;
+
+	Sensor();
+	virtual ~Sensor() {}
+
+	virtual void begin() {}
+	virtual Status start() = 0;
+	virtual Status poll(Environment *env) = 0;
+	Status read(Environment *env);
+	unsigned long idleTime() const;
+	inline uint32_t captures() const { return m_captures; }	// finished, good or not
+	inline uint32_t errors() const { return m_errors; }
+
+	virtual uint8_t capabilities() const = 0;
+	virtual int minimumSamplingPeriod() const = 0;
+	virtual int8_t numberOfDecimalsTemperature() const = 0;
+	virtual int8_t lowerBoundTemperature() const = 0;
+	virtual int8_t upperBoundTemperature() const = 0;
+	virtual int8_t numberOfDecimalsHumidity() const = 0;
+	virtual int8_t lowerBoundHumidity() const = 0;
+	virtual int8_t upperBoundHumidity() const = 0;
+protected:
+	// milliseconds since the conversion in progress was started
+	inline unsigned long elapsed() const { return Clock.millis() - m_startTime; }
+private:
+	unsigned long m_startTime;
+	bool m_sampled;
+	bool m_converting;
+	uint32_t m_captures;
+	uint32_t m_errors;
+};
+
+#endif
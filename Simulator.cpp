@@ -0,0 +1,227 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Simulator.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo thermal room simulator
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Simulator.h"
+#include "Thimo.h"
+
+#ifdef THIMO_SIMULATION
+
+#define SECONDS_PER_YEAR			31536000UL
+
+SimulatedSensor::SimulatedSensor() : m_room(0) {
+}
+
+SimulatedSensor::Status SimulatedSensor::start() {
+	return ERROR_NONE;
+}
+
+SimulatedSensor::Status SimulatedSensor::poll(Environment *env) {
+	env->temperature = Simulator.measure(m_room);
+	env->humidity = SIM_HUMIDITY;
+
+	return ERROR_NONE;
+}
+
+uint8_t SimulatedSensor::capabilities() const {
+	return CAP_TEMPERATURE | CAP_HUMIDITY;
+}
+
+int SimulatedSensor::minimumSamplingPeriod() const {
+	return (int)SIM_STEP;
+}
+
+int8_t SimulatedSensor::numberOfDecimalsTemperature() const {
+	return 1;
+}
+
+int8_t SimulatedSensor::lowerBoundTemperature() const {
+	return -40;
+}
+
+int8_t SimulatedSensor::upperBoundTemperature() const {
+	return 80;
+}
+
+int8_t SimulatedSensor::numberOfDecimalsHumidity() const {
+	return 1;
+}
+
+int8_t SimulatedSensor::lowerBoundHumidity() const {
+	return 0;
+}
+
+int8_t SimulatedSensor::upperBoundHumidity() const {
+	return 100;
+}
+
+SimulatorModule::SimulatorModule() :
+	m_seed(SIM_SEED),
+	m_windowSeed(SIM_WINDOW_SEED),
+	m_days(0),
+	m_passes(0),
+	m_passTime(0),
+	m_runTime(0) {
+	for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+		m_sensors[z].attach(z);
+		m_rooms[z].temperature = SIM_START_TEMPERATURE;
+		m_rooms[z].sensed = SIM_START_TEMPERATURE;
+	}
+}
+
+// Sensor element temperature plus noise, in DHT22 steps
+float SimulatorModule::measure(uint8_t z) {
+	float t = m_rooms[z].sensed + SIM_SENSOR_NOISE * noise(m_seed);
+
+	return roundf(t * 10.0f) / 10.0f;
+}
+
+// Yearly and daily sinusoids, coldest around 20 January and at 3 a.m.
+float SimulatorModule::outdoor(uint32_t unixtime) const {
+	uint32_t t = unixtime - SIM_EPOCH;
+	float year = (float)(t % SECONDS_PER_YEAR) / SECONDS_PER_YEAR - 20.0f / 365.0f;
+	float day = (float)(t % 86400UL) / 86400.0f - 3.0f / 24.0f;
+
+	return SIM_OUTDOOR_MEAN - SIM_OUTDOOR_YEAR * cosf(TWO_PI * year) - SIM_OUTDOOR_DAY * cosf(TWO_PI * day);
+}
+
+// Every run starts on SIM_EPOCH from the same rooms and noise sequence, so
+// two control strategies see exactly the same weather
+void SimulatorModule::run(uint16_t days) {
+	const float dt = SIM_STEP / 1000.0f;
+	const float hours = dt / 3600.0f;
+	const float lag = 1.0f - expf(-dt / SIM_SENSOR_LAG);
+	const uint32_t stepsPerDay = 86400000UL / SIM_STEP;
+	const uint32_t windowSteps = SIM_WINDOW_TIME / SIM_STEP;
+	const uint32_t graceSteps = SIM_WINDOW_GRACE / SIM_STEP;
+	const float windowChance = SIM_WINDOW_PER_DAY / stepsPerDay;
+	uint32_t count = Thimo.controlCount();
+	uint32_t time = Thimo.controlTime();
+	unsigned long start = millis();
+	WatchdogModule::Section section = Watchdog.enter(WatchdogModule::SECTION_SIMULATION);
+
+	Clock.set(SIM_EPOCH);
+	Meter.reset();
+	m_seed = SIM_SEED;
+	m_windowSeed = SIM_WINDOW_SEED;
+	for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+		Room &room = m_rooms[z];
+
+		room.temperature = SIM_START_TEMPERATURE;
+		room.sensed = SIM_START_TEMPERATURE;
+		room.energy = 0.0f;
+		room.occupied = 0.0f;
+		room.deviation = 0.0f;
+		room.cold = 0.0f;
+		room.switches = 0;
+		room.heating = digitalRead(Thimo.zone(z).relayPin) == HIGH;
+		room.windows = 0;
+		room.detected = 0;
+		room.falseAlarms = 0;
+		room.wasted = 0.0f;
+		room.windowLeft = 0;
+		room.closed = 0;
+		room.seen = false;
+		room.flagged = Thimo.zone(z).window.open();
+	}
+
+	for (uint32_t i = 0; i < (uint32_t)days * stepsPerDay; i++) {
+		DateTime now = Clock.now();
+		float out = outdoor(now.unixtime());
+
+		/* rooms move over the step with the heaters as the relays left them */
+		for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+			Room &room = m_rooms[z];
+			float power = room.heating ? SIM_HEATER_POWER : 0.0f;
+			int16_t setpoint = Thimo.setpoint(z, now.hour());
+			float loss = SIM_LOSS;
+
+			// uniform in [-1, 1), above 1 - 2p with probability p
+			if (room.windowLeft == 0 && noise(m_windowSeed) >= 1.0f - 2.0f * windowChance &&
+				room.temperature - out >= SIM_WINDOW_DELTA) {
+				room.windowLeft = windowSteps;
+				room.windows++;
+				room.seen = false;
+			}
+			if (room.windowLeft > 0) {
+				loss += SIM_WINDOW_LOSS;
+				room.wasted += power * hours;
+				if (--room.windowLeft == 0) {
+					room.closed = i + 1;
+				}
+			}
+
+			room.temperature += (power - loss * (room.temperature - out)) * dt / SIM_CAPACITY;
+			room.sensed += (room.temperature - room.sensed) * lag;
+			room.energy += power * hours;
+			if (setpoint > 0) {
+				float error = room.temperature - setpoint / 10.0f;
+				room.occupied += hours;
+				room.deviation += fabsf(error) * hours;
+				if (error < -0.5f) {
+					room.cold += (-0.5f - error) * hours;
+				}
+			}
+		}
+		Clock.advance(SIM_STEP);
+
+		/* every sensor is due now, a regulate() call reads one of them */
+		for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+			Thimo.regulate();
+		}
+
+		for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+			Room &room = m_rooms[z];
+			bool heating = digitalRead(Thimo.zone(z).relayPin) == HIGH;
+
+			if (heating != room.heating) {
+				room.heating = heating;
+				room.switches++;
+			}
+
+			// a flag while a window is open, or was a moment ago, detects it
+			bool flagged = Thimo.zone(z).window.open();
+			bool airing = room.windowLeft > 0 || (room.closed > 0 && i + 1 - room.closed <= graceSteps);
+			if (flagged && airing && !room.seen) {
+				room.seen = true;
+				room.detected++;
+			} else if (flagged && !room.flagged && !airing) {
+				room.falseAlarms++;
+			}
+			room.flagged = flagged;
+		}
+
+		if (i % stepsPerDay == 0) {
+			Watchdog.kick();
+			yield();
+		}
+	}
+	Watchdog.enter(section);
+
+	m_days = days;
+	m_passes = Thimo.controlCount() - count;
+	m_passTime = Thimo.controlTime() - time;
+	m_runTime = millis() - start;
+	Clock.resync();
+}
+
+// xorshift32, uniform in [-1, 1)
+float SimulatorModule::noise(uint32_t &seed) {
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+
+	return (float)(int32_t)seed / 2147483648.0f;
+}
+
+SimulatorModule Simulator;
+
+#endif
@@ -0,0 +1,102 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Simulator.h
+ * Created on: 19 Oct 2026
+ * Description: Thimo thermal room simulator
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#ifndef _THIMO_SIMULATOR_H_
+#define _THIMO_SIMULATOR_H_
+
+#include <Arduino.h>
+#include "Sensor.h"
+#include "Zone.h"
+#include "config.h"
+
+#ifdef THIMO_SIMULATION
+
+// Lumped capacitance room: C dT/dt = P u - UA (T - outdoor). The sensor sees
+// it through a first order lag plus noise, quantized like a DHT22. Windows
+// open at random, adding to UA, to score the open window detection.
+struct Room {
+	float temperature;		// air, °C
+	float sensed;			// what the sensor element has settled to, °C
+	float energy;			// heater output so far, Wh
+	float occupied;			// hours with a setpoint, timetable 0 is off
+	float deviation;		// |temperature - setpoint| over them, K h
+	float cold;				// shortfall below setpoint - 0.5 °C over them, K h
+	uint32_t switches;
+	bool heating;
+	uint32_t windows;		// openings
+	uint32_t detected;		// openings the zone flagged while open or within SIM_WINDOW_GRACE
+	uint32_t falseAlarms;	// flags raised with no window open or just closed
+	float wasted;			// heater output with a window open, Wh
+	uint32_t windowLeft;	// steps the current opening lasts
+	uint32_t closed;		// step the last opening ended, +1, 0 if none
+	bool seen;				// the current opening was flagged
+	bool flagged;			// the zone's detector, as of the last step
+};
+
+// Reads the room of its zone through the simulator, conversions are instant
+class SimulatedSensor : public Sensor {
+public:
+	SimulatedSensor();
+
+	inline void attach(uint8_t room) { m_room = room; }
+
+	virtual Status start();
+	virtual Status poll(Environment *env);
+
+	virtual uint8_t capabilities() const;
+	virtual int minimumSamplingPeriod() const;
+	virtual int8_t numberOfDecimalsTemperature() const;
+	virtual int8_t lowerBoundTemperature() const;
+	virtual int8_t upperBoundTemperature() const;
+	virtual int8_t numberOfDecimalsHumidity() const;
+	virtual int8_t lowerBoundHumidity() const;
+	virtual int8_t upperBoundHumidity() const;
+private:
+	uint8_t m_room;
+};
+
+// Replaces every zone sensor with a simulated room and runs the real control
+// path (sensor reads, controllers, relay pins) on virtual time, SIM_STEP
+// at a time. The relay pins are read back to drive the heaters.
+class SimulatorModule {
+public:
+	SimulatorModule();
+
+	inline Sensor *sensor(uint8_t z) { return &m_sensors[z]; }
+	float measure(uint8_t z);
+
+	void run(uint16_t days);
+
+	inline const Room &room(uint8_t z) const { return m_rooms[z]; }
+	inline uint16_t days() const { return m_days; }
+	inline uint32_t passes() const { return m_passes; }
+	inline uint32_t passTime() const { return m_passTime; }
+	inline uint32_t runTime() const { return m_runTime; }
+	float outdoor(uint32_t unixtime) const;
+private:
+	float noise(uint32_t &seed);
+
+	SimulatedSensor m_sensors[ZONE_COUNT];
+	Room m_rooms[ZONE_COUNT];
+	uint32_t m_seed;
+	uint32_t m_windowSeed;
+	uint16_t m_days;
+	uint32_t m_passes;		// control passes in the last run
+	uint32_t m_passTime;	// µs spent in them
+	uint32_t m_runTime;		// ms the whole run took
+};
+
+extern SimulatorModule Simulator;
+
+#endif
+
+#endif
@@ -12,8 +12,36 @@
 
 #include "Thimo.h"
 
+#if defined(ESP32) && !defined(THIMO_SIMULATION)
+#include <Preferences.h>
+#endif
+
+static_assert(ZONE_COUNT >= 1 && ZONE_COUNT <= 16, "the relay states take two NVRAM bytes");
+
+static const uint8_t nvramTimetable[NVRAM_ZONES] = { NVRAM_TIMETABLE, NVRAM_TIMETABLE2 };
+
+static const uint16_t allZones = (1UL << ZONE_COUNT) - 1;
+static const uint8_t monthDays[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+// Adding a view: a View id, its fields, how to draw it and, optionally, how to edit it
+const ThimoClass::ViewDescriptor ThimoClass::s_views[VIEW_COUNT] = {
+	{ FIELD_TEMPERATURE | FIELD_HUMIDITY | FIELD_RELAY,	&ThimoClass::displayEnvironment,	&ThimoClass::editZone,		0, 0 },
+	{ FIELD_MODE | FIELD_SETPOINT,						&ThimoClass::displayManual,			&ThimoClass::editManual,	0, 0 },
+	{ FIELD_CLOCK,										&ThimoClass::displayClock,			&ThimoClass::editClock,		0, 0 },
+	{ FIELD_TIMETABLE,									&ThimoClass::displayTimetable,		&ThimoClass::editTimetable,	0, 4 },
+	{ FIELD_TIMETABLE,									&ThimoClass::displayTimetable,		&ThimoClass::editTimetable,	5, 9 },
+	{ FIELD_TIMETABLE,									&ThimoClass::displayTimetable,		&ThimoClass::editTimetable,	10, 14 },
+	{ FIELD_TIMETABLE,									&ThimoClass::displayTimetable,		&ThimoClass::editTimetable,	15, 19 },
+	{ FIELD_TIMETABLE,									&ThimoClass::displayTimetable,		&ThimoClass::editTimetable,	20, 23 },
+	{ FIELD_RELAY | FIELD_ENERGY,						&ThimoClass::displayEnergy,			NULL,						0, 0 },
+	{ FIELD_MODE | FIELD_SETPOINT,						&ThimoClass::displayOverride,		&ThimoClass::editOverride,	0, 0 }
+};
+
 ThimoClass::ThimoClass() {
-	
+	for (int i = 0; i < VIEW_COUNT; i++) {
+		m_renderCount[i] = 0;
+		m_renderTime[i] = 0;
+	}
 }
 
 ThimoClass::~ThimoClass() {
@@ -21,171 +49,619 @@ ThimoClass::~ThimoClass() {
 }
 
 void ThimoClass::begin() {
+	uint8_t state[NVRAM_SIZE + sizeof(JournalRecord)];
+	uint8_t *nvram = state;
+	JournalRecord journal;
+	bool journaled;
+
 	if (!RTC.isrunning()) {
-		Serial.println("RTC is not running");
-		RTC.adjust(DateTime(__DATE__, __TIME__));
+		LOG_WARN(LOG_RTC_NOT_RUNNING);
+		/* the build time is local, the RTC keeps UTC */
+		RTC.adjust(DateTime(Clock.toUtc(DateTime(__DATE__, __TIME__).unixtime())));
 	}
+	Clock.begin();
 	
-	for (int i = 0; i < 24; i++) {
-		m_timetable[i] = RTC.readnvram(i);
-		if (m_timetable[i] > 30) {
-			m_timetable[i] = 0;
-		}
+	/* schedules and last relay states in a single NVRAM transfer, the trace starts from them */
+	RTC.readnvram(nvram, NVRAM_SIZE, 0);
+	if (Watchdog.stalled()) {
+		// the saved relay states are the ones latched by the stall
+		memset(nvram + NVRAM_RELAY, 0, NVRAM_TIMETABLE2 - NVRAM_RELAY);
+	}
+	/* the runtime state journal follows the NVRAM image, not after a stall it may have caused */
+	journaled = Journal.load(journal) && !Watchdog.stalled();
+	if (journaled) {
+		memcpy(state + NVRAM_SIZE, &journal, sizeof(journal));
+	}
+	Trace.begin(Clock.now().unixtime(), state, journaled ? sizeof(state) : NVRAM_SIZE);
+
+	/* overrides set before the reboot, the trace starts from them as well */
+	Overrides.begin();
+	for (uint8_t i = 0; i < Overrides.count(); i++) {
+		Trace.override(Overrides.entry(i));
 	}
+	for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+		Zone &zone = m_zones[z];
 
-	pinMode(RELAY_PIN, OUTPUT);
+#ifdef THIMO_SIMULATION
+		zone.sensor = Simulator.sensor(z);
+#else
+		zone.sensor = zoneConfig[z].sensor;
+#endif
+		zone.sensor->begin();
+		zone.relayPin = zoneConfig[z].relayPin;
+	}
+	restoreSchedules(nvram);
+	restoreTimetables();
+	Boot.mark(BootModule::STEP_SCHEDULE);
+
+	/* relay counters saved before the reboot, they go on from the restored states */
+	Meter.begin();
+
+	/* drive the relays as they were before the reset until fresh samples arrive */
+	restoreRelays(nvram);
+	Boot.mark(BootModule::STEP_RELAY);
+
+	/* modes, view and recent temperatures: control resumes before the sensors answer */
+	restoreJournal(journaled ? state + NVRAM_SIZE : NULL);
+
+	/* what the thermal models learned before the reboot */
+	restoreModels();
+
+	/* first reading of every sensor, the conversions run side by side and
+	   are waited for, then a control pass with all of them */
+	uint16_t converting = 0;
+	for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+		if (updateSensor(z) == Sensor::ERROR_RETRY) {
+			converting |= 1 << z;
+		}
+	}
+	unsigned long start = millis();
+	while (converting != 0 && millis() - start < SENSOR_BOOT_WAIT) {
+		delay(1);
+		for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+			if ((converting >> z & 1) && updateSensor(z) != Sensor::ERROR_RETRY) {
+				converting &= ~(1 << z);
+			}
+		}
+	}
+	control();
+	Boot.mark(BootModule::STEP_CONTROL);
 	
-	m_backlightTimer = millis();
+	m_backlightTimer = Clock.millis();
 }
 
-void ThimoClass::loop() {
-	Environment env;
-	
-	/* DHT sensor read */
-	if (DHT.readSensor(&env) == DHTModule::ERROR_NONE) {
-		if (!isnan(env.temperature)) {
-			m_temperature = env.temperature;
+// Back to the state begin() leaves, from an NVRAM image and the journal
+// that came with it, if any (a trace replay)
+void ThimoClass::restore(const uint8_t *nvram, const uint8_t *journal) {
+	restoreSchedules(nvram);
+	restoreRelays(nvram);
+	m_zone = 0;
+	m_sensorZone = 0;
+	m_view = CLOCK;
+	Overrides.reset();
+	restoreJournal(journal);
+	m_dirty = FIELD_ALL;
+	m_backlightTimer = Clock.millis();
+}
+
+void ThimoClass::restoreSchedules(const uint8_t *nvram) {
+	for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+		Zone &zone = m_zones[z];
+		const uint8_t *table = nvram + nvramTimetable[z < NVRAM_ZONES ? z : 0];
+
+		zone.sampled = false;
+		zone.humid = false;
+		zone.failed = false;
+		zone.manualMode = false;
+		zone.manualSetpoint = MANUAL_TEMPERATURE * 10;
+		zone.trend = 0;
+		zone.temperature = 0.0f;
+		zone.humidity = 0.0f;
+		zone.trendTemperature = NAN;
+		zone.trendTimer = 0UL;
+		zone.model.reset();
+		zone.window.reset();
+		for (int i = 0; i < 24; i++) {
+			zone.timetable[i] = table[i] > 30 ? 0 : table[i];
 		}
-		if (!isnan(env.humidity)) {
-			m_humidity = env.humidity;
+	}
+}
+
+void ThimoClass::restoreRelays(const uint8_t *nvram) {
+	for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+		Zone &zone = m_zones[z];
+		zone.relay = (nvram[NVRAM_RELAY + z / 8] >> (z % 8)) & 1;
+		zone.controller.begin(CONTROL_MODE, zone.relay, Clock.millis());
+		Meter.resume(z, zone.relay, Clock.millis());
+		digitalWrite(zone.relayPin, zone.relay ? HIGH : LOW);
+		pinMode(zone.relayPin, OUTPUT);
+	}
+}
+
+// A journal image is unaligned in a trace, it's copied out first. The
+// temperature stands in for a sample until the sensor answers, if it isn't
+// older than JOURNAL_MAX_AGE, and control runs on it right away; the next
+// sample takes over. The age is taken in UTC, local time jumps at DST.
+void ThimoClass::restoreJournal(const uint8_t *image) {
+	JournalRecord journal;
+	uint32_t now = Clock.utc();
+
+	if (image == NULL) {
+		return;
+	}
+	memcpy(&journal, image, sizeof(journal));
+
+	for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+		Zone &zone = m_zones[z];
+		const JournalZone &saved = journal.zones[z];
+
+		zone.manualMode = saved.flags & JOURNAL_MANUAL;
+		if (saved.manual > 0 && saved.manual <= 60) {	// 0: from before it was kept
+			zone.manualSetpoint = saved.manual * 5;
+		}
+		zone.controller.mode(saved.flags & JOURNAL_PID ? Controller::PID : Controller::HYSTERESIS);
+		if (saved.temperature != JOURNAL_NONE && now - journal.time <= JOURNAL_MAX_AGE) {
+			zone.temperature = saved.temperature / 10.0f;
+			zone.sampled = true;
 		}
-		toggleRelay();
 	}
-	
-	/* LCD menu control selection */
-	if (ButtonN.toggled() && ButtonN.read() == Button::PRESSED) {
-		Serial.println("next");
-		Thimo.menuNext();
+	if (journal.view < VIEW_COUNT) {
+		m_view = journal.view;
+	}
+	if (journal.zone < ZONE_COUNT) {
+		m_zone = journal.zone;
 	}
 
-	if (ButtonP.toggled() && ButtonP.read() == Button::PRESSED) {
-		Serial.println("previous");
-		Thimo.menuPrevious();
+	control();
+}
+
+void ThimoClass::loop() {
+#ifdef THIMO_SIMULATION
+	Clock.follow();
+#endif
+	regulate();
+
+	/* runtime state changes, coalesced */
+	Journal.poll();
+
+	/* relay counters to flash, batched */
+	Meter.poll();
+
+	/* learned thermal models to flash, a few times a day */
+	if ((Clock.millis() - m_modelTimer) >= MODEL_SAVE_TIME) {
+		m_modelTimer = Clock.millis();
+		saveModels();
 	}
 
-	if (ButtonS.toggled() && ButtonS.read() == Button::PRESSED) {
-		Serial.println("select");
-		Thimo.menuSelect();
+	/* LCD initialization runs in background, UI starts once it's done */
+	if (!LCD.ready()) {
+		if (!LCD.poll()) {
+			return;
+		}
+		Boot.mark(BootModule::STEP_LCD);
+		Boot.report();
+		Watchdog.report();
+		m_backlightTimer = Clock.millis();
 	}
 	
-	/* LCD backlight control state */
-	if ((millis() - m_backlightTimer) > LCD_BACKLIGHT_DURATION) {
-		LCD.noBacklight();
-	} else {
+	/* LCD menu control selection */
+	buttons();
+	
+	/* LCD backlight control state, the expander is only written on change */
+	if ((Clock.millis() - m_backlightTimer) > LCD_BACKLIGHT_DURATION) {
+		if (m_backlight) {
+			LCD.noBacklight();
+			m_backlight = false;
+		}
+	} else if (!m_backlight) {
 		LCD.backlight();
+		m_backlight = true;
+		m_dirty = FIELD_ALL;
+	}
+
+	/* the clock ticks every second */
+	if ((Clock.millis() - m_clockTick) >= 1000UL) {
+		m_clockTick += 1000UL * ((Clock.millis() - m_clockTick) / 1000UL);
+		m_dirty |= FIELD_CLOCK;
 	}
 	
+	/* send a frame held back by a busy bus */
+	LCD.poll();
+
 	/* refresh display data every 1s */
-	if ((millis() - m_refreshTimer) > LCD_REFRESH_TIME) {
+	if ((Clock.millis() - m_refreshTimer) > LCD_REFRESH_TIME) {
 		refresh();
 	}
 }
 
-void ThimoClass::menuNext() {
-	if ((millis() - m_backlightTimer) < 10000UL) {
-		LCD.clear();
-		if (++m_view > TIMETABLE5) {
-			m_view = 0;
+// ERROR_RETRY means the sensor wasn't due, anything else took a capture
+Sensor::Status ThimoClass::updateSensor(uint8_t z) {
+	Environment env;
+	WatchdogModule::Section section = Watchdog.enter(WatchdogModule::SECTION_SENSOR);
+	Sensor::Status status = m_zones[z].sensor->read(&env);
+	Watchdog.enter(section);
+
+	if (status != Sensor::ERROR_RETRY) {
+		Trace.sensor(z, status, env);
+		sample(z, status, env);
+	}
+
+	return status;
+}
+
+// Takes in the outcome of a capture, live or replayed
+void ThimoClass::sample(uint8_t z, Sensor::Status status, const Environment &env) {
+	Zone &zone = m_zones[z];
+	uint8_t dirty = 0;
+
+	if (status == Sensor::ERROR_NONE) {
+		// displayed with one decimal, smaller changes don't need a redraw
+		if (!isnan(env.temperature)) {
+			if (lroundf(env.temperature * 10.0f) != lroundf(zone.temperature * 10.0f)) {
+				dirty |= FIELD_TEMPERATURE;
+			}
+			zone.temperature = env.temperature;
+			zone.sampled = true;
 		}
-		refresh();
+		if (!isnan(env.humidity)) {
+			if (lroundf(env.humidity * 10.0f) != lroundf(zone.humidity * 10.0f)) {
+				dirty |= FIELD_HUMIDITY;
+			}
+			zone.humidity = env.humidity;
+			zone.humid = true;
+		}
+		zone.failed = false;
+		if (z == m_zone) {
+			m_dirty |= dirty;
+		}
+		updateTrend(z);
+		zone.model.update(zone.temperature, zone.relay, Clock.millis());
+		// a room the model sees warming up with the heater off counts as holding
+		float idle = zone.model.ready() ? fminf(zone.model.rate(0.0f, zone.temperature), 0.0f) : 0.0f;
+		if (zone.window.update((int16_t)lroundf(zone.temperature * 10.0f), Clock.millis(), idle)) {
+			LOG_INFO(LOG_WINDOW, z, zone.window.open());
+			if (z == m_zone) {
+				m_dirty |= FIELD_RELAY;
+			}
+		}
+		if (z == 0) {
+			recordSample();
+		}
+		journal();
+	} else {
+		zone.failed = true;
+		LOG_DEBUG(LOG_SENSOR_ERROR, z, status);
 	}
-	m_backlightTimer = millis();
 }
 
-void ThimoClass::menuPrevious() {
-	if ((millis()  - m_backlightTimer) < 10000UL) {
-		LCD.clear();
-		if (--m_view > TIMETABLE5) {
-			m_view = TIMETABLE5;
+// Compares the temperature with the one a trend period ago
+void ThimoClass::updateTrend(uint8_t z) {
+	Zone &zone = m_zones[z];
+
+	if (isnan(zone.trendTemperature)) {
+		zone.trendTemperature = zone.temperature;
+		zone.trendTimer = Clock.millis();
+		return;
+	}
+
+	if ((Clock.millis() - zone.trendTimer) < TREND_PERIOD) {
+		return;
+	}
+	zone.trendTimer = Clock.millis();
+
+	float delta = zone.temperature - zone.trendTemperature;
+	int8_t trend = delta > TREND_THRESHOLD ? 1 : (delta < -TREND_THRESHOLD ? -1 : 0);
+	zone.trendTemperature = zone.temperature;
+
+	if (trend != zone.trend) {
+		zone.trend = trend;
+		if (z == m_zone) {
+			m_dirty |= FIELD_TEMPERATURE;
 		}
-		refresh();
 	}
-	m_backlightTimer = millis();
+}
+
+bool ThimoClass::timetable(uint8_t z, uint8_t hour, uint8_t temperature) {
+	if (z >= ZONE_COUNT || hour > 23 || temperature > 30) {
+		return false;
+	}
+
+	m_zones[z].timetable[hour] = temperature;
+	Trace.timetable(z, hour, temperature);
+	if (z < NVRAM_ZONES) {
+		RTC.writenvram(nvramTimetable[z] + hour, temperature);
+	} else {
+		saveTimetables();
+	}
+	if (z == m_zone) {
+		m_dirty |= FIELD_TIMETABLE;
+	}
+
+	return true;
+}
+
+bool ThimoClass::timetable(uint8_t z, const uint8_t *table) {
+	if (z >= ZONE_COUNT) {
+		return false;
+	}
+	for (int i = 0; i < 24; i++) {
+		if (table[i] > 30) {
+			return false;
+		}
+	}
+
+	memcpy(m_zones[z].timetable, table, 24);
+	for (int i = 0; i < 24; i++) {
+		Trace.timetable(z, i, table[i]);
+	}
+	if (z < NVRAM_ZONES) {
+		RTC.writenvram(nvramTimetable[z], m_zones[z].timetable, 24);
+	} else {
+		saveTimetables();
+	}
+	if (z == m_zone) {
+		m_dirty |= FIELD_TIMETABLE;
+	}
+
+	return true;
+}
+
+void ThimoClass::controlMode(uint8_t z, Controller::Mode mode) {
+	if (z < ZONE_COUNT) {
+		m_zones[z].controller.mode(mode);
+		Trace.mode(z, m_zones[z].manualMode, mode, m_zones[z].manualSetpoint);
+		journal();
+	}
+}
+
+// One press per call: a replayed press must reach the editor it opens
+// before the next button is looked at
+void ThimoClass::buttons() {
+	if (buttonPressed(BUTTON_NEXT)) {
+		LOG_DEBUG(LOG_BUTTON_NEXT);
+		menuNext();
+	} else if (buttonPressed(BUTTON_PREVIOUS)) {
+		LOG_DEBUG(LOG_BUTTON_PREVIOUS);
+		menuPrevious();
+	} else if (buttonPressed(BUTTON_SELECT)) {
+		LOG_DEBUG(LOG_BUTTON_SELECT);
+		menuSelect();
+	}
+}
+
+void ThimoClass::manualMode(uint8_t z, bool manual) {
+	if (z < ZONE_COUNT && manual != m_zones[z].manualMode) {
+		m_zones[z].manualMode = manual;
+		Trace.mode(z, manual, m_zones[z].controller.mode(), m_zones[z].manualSetpoint);
+		if (z == m_zone) {
+			m_dirty |= FIELD_MODE;
+		}
+		journal();
+	}
+}
+
+// Tenths of °C, 0 to 30 °C like the timetable, to the nearest half degree
+// the journal keeps
+bool ThimoClass::manualSetpoint(uint8_t z, int16_t setpoint) {
+	if (z >= ZONE_COUNT || setpoint < 0 || setpoint > 300) {
+		return false;
+	}
+	setpoint = (setpoint + 2) / 5 * 5;
+	if (setpoint != m_zones[z].manualSetpoint) {
+		m_zones[z].manualSetpoint = setpoint;
+		Trace.mode(z, m_zones[z].manualMode, m_zones[z].controller.mode(), setpoint);
+		if (z == m_zone) {
+			m_dirty |= FIELD_SETPOINT;
+		}
+		journal();
+	}
+
+	return true;
+}
+
+void ThimoClass::menuNext() {
+	if ((Clock.millis() - m_backlightTimer) < 10000UL) {
+		show(m_view + 1 < VIEW_COUNT ? m_view + 1 : 0);
+	}
+	m_backlightTimer = Clock.millis();
+}
+
+void ThimoClass::menuPrevious() {
+	if ((Clock.millis() - m_backlightTimer) < 10000UL) {
+		show(m_view > 0 ? m_view - 1 : VIEW_COUNT - 1);
+	}
+	m_backlightTimer = Clock.millis();
 }
 
 void ThimoClass::menuSelect() {
-	if ((millis()  - m_backlightTimer) < 10000UL) {
-		switch (m_view) {
-			case MANUAL:
-				editManual();
-				break;
-			case CLOCK:
-				editClock();
-				break;
-			case TIMETABLE1:
-				editTimetable(0, 4);
-				break;
-			case TIMETABLE2:
-				editTimetable(5, 9);
-				break;
-			case TIMETABLE3:
-				editTimetable(10, 14);
-				break;
-			case TIMETABLE4:
-				editTimetable(15, 19);
-				break;
-			case TIMETABLE5:
-				editTimetable(20, 23);
-				break;
-		}
-	}
-	m_backlightTimer = millis();
+	if ((Clock.millis() - m_backlightTimer) < 10000UL) {
+		const ViewDescriptor &view = s_views[m_view];
+		if (view.edit != NULL) {
+			WatchdogModule::Section section = Watchdog.enter(WatchdogModule::SECTION_EDITOR);
+			m_editTimer = Clock.millis();
+			m_editAbandoned = false;
+			(this->*view.edit)(view);
+			Watchdog.enter(section);
+			m_dirty = FIELD_ALL;
+			journal();
+		}
+	}
+	m_backlightTimer = Clock.millis();
+}
+
+// A press in an editor: the user is there, the editor's watchdog budget
+// and its EDIT_TIMEOUT start over
+bool ThimoClass::editPressed(ButtonId id) {
+	if (!buttonPressed(id)) {
+		return false;
+	}
+	m_editTimer = Clock.millis();
+	Watchdog.kick();
+
+	return true;
+}
+
+// Select confirms the field being edited. Nothing pressed for EDIT_TIMEOUT
+// abandons the edit: the fields left are skipped, nothing is applied and
+// the view comes back. A replay gets there from the time of the record
+// that follows, which can't be a press.
+bool ThimoClass::editDone() {
+	if (m_editAbandoned || editPressed(BUTTON_SELECT)) {
+		return true;
+	}
+#ifdef THIMO_SIMULATION
+	if (!Trace.replaying()) {
+		Clock.follow();
+	}
+#endif
+	m_editAbandoned = Clock.millis() - m_editTimer >= EDIT_TIMEOUT;
+
+	return m_editAbandoned;
+}
+
+void ThimoClass::show(uint8_t view) {
+	m_view = view;
+	m_dirty = FIELD_ALL;
+	journal();
+	refresh();
 }
 
 void ThimoClass::refresh() {
-	LCD.home();
+	const ViewDescriptor &view = s_views[m_view];
 
-	switch (m_view) {
-		case ENVIRONMENT:
-			displayEnvironment();
-			break;
-		case MANUAL:
-			displayManual();
-			break;
-		case CLOCK:
-			displayClock();
-			break;
-		case TIMETABLE1:
-			displayTimetable(0, 4);
-			break;
-		case TIMETABLE2:
-			displayTimetable(5, 9);
-			break;
-		case TIMETABLE3:
-			displayTimetable(10, 14);
-			break;
-		case TIMETABLE4:
-			displayTimetable(15, 19);
-			break;
-		case TIMETABLE5:
-			displayTimetable(20, 23);
-			break;
-		default:
-			LCD.print("View: ");
-			LCD.print(m_view);
+	m_refreshTimer = Clock.millis();
+
+	// nothing this view shows has changed, or nobody can see it
+	if (!(m_dirty & view.fields) || !m_backlight) {
+		return;
+	}
+
+	render();
+}
+
+// Views draw on a blank frame, only the cells that changed reach the display
+void ThimoClass::render() {
+	draw();
+	Trace.display(checksum());
+}
+
+// Draws any view without making it the current one or tracing it, the
+// current view is drawn again on the next refresh
+void ThimoClass::render(uint8_t view) {
+	uint8_t current = m_view;
+
+	m_view = view;
+	draw();
+	m_view = current;
+	m_dirty = FIELD_ALL;
+}
+
+void ThimoClass::draw() {
+	const ViewDescriptor &view = s_views[m_view];
+
+	Power.boost();
+	WatchdogModule::Section section = Watchdog.enter(WatchdogModule::SECTION_DISPLAY);
+	unsigned long start = micros();
+
+	Glyph.frame();
+	LCD.frame();
+	LCD.clear();
+	(this->*view.render)(view);
+	LCD.swap();
+	m_dirty = 0;
+
+	unsigned long elapsed = micros() - start;
+	m_renderTime[m_view] += elapsed;
+	m_renderCount[m_view]++;
+	Power.measure(PowerModule::TASK_RENDER, elapsed);
+	Watchdog.enter(section);
+}
+
+// CRC-8 of the frame, CGRAM codes count as the glyph they hold so the
+// slot a glyph landed in doesn't matter
+uint8_t ThimoClass::checksum() {
+	uint8_t crc = 0;
+
+	for (uint8_t r = 0; r < LCD.rows(); r++) {
+		const uint8_t *row = LCD.row(r);
+		for (uint8_t c = 0; c < LCD.cols(); c++) {
+			uint8_t code = row[c] < GLYPH_SLOTS ? 0x80 | Glyph.glyph(row[c]) : row[c];
+			crc = crc8(&code, 1, crc);
+		}
+	}
+
+	return crc;
+}
+
+// Big digits for the temperature, with its trend, the burner state (or an
+// open window) and the humidity on the side. Out of the two digit range falls back to text.
+void ThimoClass::displayEnvironment(const ViewDescriptor &view) {
+	const Zone &zone = m_zones[m_zone];
+	long t = lroundf(zone.temperature * 10.0f);
+	char buf[8];
+
+	if (t < 0 || t > 999) {
+		displayEnvironmentText(view);
+		return;
+	}
+
+	if (t >= 100) {
+		Glyph.bigDigit(0, t / 100);
 	}
+	Glyph.bigDigit(4, (t / 10) % 10);
+	LCD.setCursor(7, 1);
+	LCD.print(".");
+	Glyph.bigDigit(8, t % 10);
 
-	m_refreshTimer = millis();
+	LCD.setCursor(11, 0);
+	LCD.print(char(223));
+	LCD.print("C");
+	LCD.setCursor(14, 0);
+	Glyph.print(zone.trend > 0 ? GlyphModule::ARROW_UP : (zone.trend < 0 ? GlyphModule::ARROW_DOWN : GlyphModule::ARROW_STEADY));
+	if (zone.window.open()) {
+		Glyph.print(GlyphModule::WINDOW);
+	} else if (zone.relay) {
+		Glyph.print(GlyphModule::FLAME);
+	}
+
+	snprintf(buf, sizeof(buf), "%3ld%%", lroundf(zone.humidity));
+	LCD.setCursor(12, 1);
+	LCD.print(buf);
+
+	if (ZONE_COUNT > 1) {
+		LCD.setCursor(11, 1);
+		LCD.print((char)('A' + m_zone));
+	}
 }
 
-void ThimoClass::displayEnvironment() {
-	LCD.print("Temper. : ");
+void ThimoClass::displayEnvironmentText(const ViewDescriptor &view) {
+	const Zone &zone = m_zones[m_zone];
+
+	LCD.print(ZONE_COUNT > 1 ? "Temper." : "Temper. : ");
+	if (ZONE_COUNT > 1) {
+		LCD.print((char)('A' + m_zone));
+		LCD.print(":");
+	}
 	LCD.setCursor(10,0);
-	LCD.print(m_temperature, 1);
+	LCD.print(zone.temperature, 1);
 	LCD.print(char(223));
 	LCD.print("C");		
 	LCD.setCursor(0,1);
 	LCD.print("Humidity: ");
 	LCD.setCursor(10,1);
-	LCD.print(m_humidity, 1);
+	LCD.print(zone.humidity, 1);
 	LCD.print(" %");
 }
 
-void ThimoClass::displayManual() {
-	float pt = potTemperature();
+void ThimoClass::displayManual(const ViewDescriptor &view) {
+	float pt = m_zones[m_zone].manualSetpoint / 10.0f;
 	
 	LCD.print("Mode:");
-	if (m_manualMode) {
+	if (ZONE_COUNT > 1) {
+		LCD.setCursor(6, 0);
+		LCD.print((char)('A' + m_zone));
+	}
+	if (m_zones[m_zone].manualMode) {
 		LCD.setCursor(10, 0);
 		LCD.print("MANUAL");
 	} else {
@@ -203,8 +679,8 @@ void ThimoClass::displayManual() {
 	LCD.print("C");
 }
 
-void ThimoClass::displayClock() {
-	DateTime now = RTC.now();
+void ThimoClass::displayClock(const ViewDescriptor &view) {
+	DateTime now = Clock.now();
 	
 	// print current date
 	LCD.setCursor(3,0);
@@ -238,41 +714,218 @@ void ThimoClass::displayClock() {
 	LCD.print(now.second());
 }
 
-void ThimoClass::displayTimetable(int hfrom, int hto) {
+void ThimoClass::displayTimetable(const ViewDescriptor &view) {
+	const uint8_t *timetable = m_zones[m_zone].timetable;
 	int col = 2;
 	
 	LCD.setCursor(0, 0);
-	LCD.print("H ");
+	LCD.print(ZONE_COUNT > 1 ? (char)('A' + m_zone) : 'H');
 	LCD.setCursor(0, 1);
 	LCD.print("T ");
 	
-	for (int h = hfrom; h <= hto; h++) {
+	for (int h = view.hfrom; h <= view.hto; h++) {
 		LCD.setCursor(col, 0);
 		if (h < 10) {
 			LCD.print("0");
 		}
 		LCD.print(h);
-		LCD.setCursor((m_timetable[h] < 9) ? col + 1 : col, 1);
-		LCD.print(m_timetable[h]);
+		LCD.setCursor((timetable[h] < 9) ? col + 1 : col, 1);
+		LCD.print(timetable[h]);
 		col += 3;
 	}
 }
 
-void ThimoClass::editManual() {
+// Burner time and starts today, energy this month
+void ThimoClass::displayEnergy(const ViewDescriptor &view) {
+	const MeterCounter &day = Meter.counter(m_zone, MeterModule::DAY);
+	long energy = lroundf(MeterModule::energy(Meter.counter(m_zone, MeterModule::MONTH).onTime) * 10.0f);
+	char buf[24];
+
+	LCD.print("Today");
+	if (ZONE_COUNT > 1) {
+		LCD.setCursor(6, 0);
+		LCD.print((char)('A' + m_zone));
+	}
+	snprintf(buf, sizeof(buf), "%2lu:%02lu", (unsigned long)(day.onTime / 3600UL), (unsigned long)(day.onTime / 60UL % 60UL));
+	LCD.setCursor(7, 0);
+	LCD.print(buf);
+	snprintf(buf, sizeof(buf), "%3ux", day.cycles);
+	LCD.setCursor(12, 0);
+	LCD.print(buf);
+
+	LCD.setCursor(0, 1);
+	LCD.print("Month");
+	snprintf(buf, sizeof(buf), "%5ld.%ld", energy / 10, energy % 10);
+	LCD.setCursor(6, 1);
+	LCD.print(buf);
+	LCD.print("kWh");
+}
+
+// The override in force on the shown zone, its setpoint and when it ends:
+// the time within a day, the date after. Without one, the schedule's setpoint.
+void ThimoClass::displayOverride(const ViewDescriptor &view) {
+	const Override *entry = Overrides.active(m_zone);
+	const char *name = entry != NULL ? OverrideModule::name(entry->kind) : "schedule";
+	DateTime now = Clock.now();
+	int16_t setpoint = entry != NULL ? entry->setpoint : this->setpoint(m_zone, now.hour());
+	char buf[12];
+
+	LCD.print("Ovr:");
+	if (ZONE_COUNT > 1) {
+		LCD.setCursor(6, 0);
+		LCD.print((char)('A' + m_zone));
+	}
+	LCD.setCursor(16 - strlen(name), 0);
+	LCD.print(name);
+
+	snprintf(buf, sizeof(buf), "%2d.%d", setpoint / 10, setpoint % 10);
+	LCD.setCursor(0, 1);
+	LCD.print(buf);
+	LCD.print(char(223));
+	LCD.print("C");
+	if (entry == NULL) {
+		return;
+	}
+
+	DateTime end(entry->end);
+	if (entry->end == OVERRIDE_FOREVER) {
+		snprintf(buf, sizeof(buf), "--:--");
+	} else if (entry->end - now.unixtime() < 86400UL) {
+		snprintf(buf, sizeof(buf), "%02d:%02d", end.hour(), end.minute());
+	} else {
+		snprintf(buf, sizeof(buf), "%02d/%02d", end.day(), end.month());
+	}
+	LCD.setCursor(11, 1);
+	LCD.print(buf);
+}
+
+void ThimoClass::editManual(const ViewDescriptor &view) {
+	Zone &zone = m_zones[m_zone];
+
 	LCD.setCursor(10, 0);
-	if (m_manualMode) {
+	if (zone.manualMode) {
 		LCD.print(" ");
 		LCD.print(" ");
 		LCD.print("AUTO");
-		m_manualMode = false;
+		zone.manualMode = false;
 	} else {
 		LCD.print("MANUAL");
-		m_manualMode = true;
+		zone.manualMode = true;
+	}
+}
+
+// Select on the environment view moves the display to the next zone
+void ThimoClass::editZone(const ViewDescriptor &view) {
+	m_zone = (m_zone + 1) % ZONE_COUNT;
+}
+
+// Next and previous pick an override, select confirms it, then its
+// temperature the same way. The schedule clears the overrides the buttons
+// set: a boost or a hold of the shown zone, away.
+void ThimoClass::editOverride(const ViewDescriptor &view) {
+	static const uint8_t kinds[] = { OVERRIDE_KINDS, OVERRIDE_AWAY, OVERRIDE_HOLD, OVERRIDE_BOOST };
+	const Override *active = Overrides.active(m_zone);
+	uint8_t choice = 0;
+	int16_t setpoint;
+	bool changed = false;
+	char buf[12];
+	Override entry;
+
+	for (uint8_t i = 1; i < sizeof(kinds); i++) {
+		if (active != NULL && active->kind == kinds[i]) {
+			choice = i;
+		}
+	}
+
+	LCD.setCursor(15, 0);
+	LCD.blink();
+
+	// pick the override
+	while (!editDone()) {
+		if (editPressed(BUTTON_NEXT)) {
+			choice = (choice + 1) % sizeof(kinds);
+			changed = true;
+		}
+		if (editPressed(BUTTON_PREVIOUS)) {
+			choice = (choice + sizeof(kinds) - 1) % sizeof(kinds);
+			changed = true;
+		}
+		if (changed) {
+			const char *name = choice == 0 ? "schedule" : OverrideModule::name(kinds[choice]);
+			LCD.setCursor(8, 0);
+			LCD.print("        ");
+			LCD.setCursor(16 - strlen(name), 0);
+			LCD.print(name);
+			LCD.setCursor(15, 0);
+			changed = false;
+		}
+	}
+	if (m_editAbandoned) {
+		LCD.noBlink();
+		return;
+	}
+
+	entry.kind = kinds[choice];
+	entry.start = Clock.now().unixtime();
+	entry.zones = entry.kind == OVERRIDE_AWAY ? allZones : 1 << m_zone;
+	if (choice == 0) {
+		entry.setpoint = 0;
+		entry.end = 0;
+		for (entry.kind = OVERRIDE_AWAY; entry.kind < OVERRIDE_KINDS; entry.kind++) {
+			entry.zones = entry.kind == OVERRIDE_AWAY ? allZones : 1 << m_zone;
+			applyOverride(entry);
+		}
+		LCD.noBlink();
+		return;
+	}
+
+	if (entry.kind == OVERRIDE_BOOST) {
+		setpoint = OVERRIDE_BOOST_TEMPERATURE * 10;
+		entry.end = entry.start + OVERRIDE_BOOST_TIME;
+	} else if (entry.kind == OVERRIDE_HOLD) {
+		setpoint = this->setpoint(m_zone, DateTime(entry.start).hour());
+		entry.end = holdEnd(m_zone, entry.start);
+	} else {
+		setpoint = OVERRIDE_AWAY_TEMPERATURE * 10;
+		entry.end = OVERRIDE_FOREVER;
+	}
+	if (active != NULL && active->kind == entry.kind) {
+		setpoint = active->setpoint;
+	}
+
+	// adjust the temperature, half a degree a press
+	LCD.setCursor(3, 1);
+	while (!editDone()) {
+		if (editPressed(BUTTON_NEXT)) {
+			if ((setpoint += 5) > 300) {
+				setpoint = 0;
+			}
+			changed = true;
+		}
+		if (editPressed(BUTTON_PREVIOUS)) {
+			if ((setpoint -= 5) < 0) {
+				setpoint = 300;
+			}
+			changed = true;
+		}
+		if (changed) {
+			snprintf(buf, sizeof(buf), "%2d.%d", setpoint / 10, setpoint % 10);
+			LCD.setCursor(0, 1);
+			LCD.print(buf);
+			LCD.setCursor(3, 1);
+			changed = false;
+		}
+	}
+
+	if (!m_editAbandoned) {
+		entry.setpoint = setpoint;
+		applyOverride(entry);
 	}
+	LCD.noBlink();
 }
 
-void ThimoClass::editClock() {
-	DateTime now = RTC.now();
+void ThimoClass::editClock(const ViewDescriptor &view) {
+	DateTime now = Clock.now();
 	uint8_t day = now.day();
 	uint8_t month = now.month();
 	uint16_t year = now.year();
@@ -285,14 +938,14 @@ void ThimoClass::editClock() {
 	LCD.blink();
 
 	// adjust day
-	while (!ButtonS.toggled() || ButtonS.read() != Button::PRESSED) {
-		if (ButtonN.toggled() && ButtonN.read() == Button::PRESSED) {
+	while (!editDone()) {
+		if (editPressed(BUTTON_NEXT)) {
 			if (++day > 31) {
 				day = 1;
 			}
 			changed = true;
 		}
-		if (ButtonP.toggled() && ButtonP.read() == Button::PRESSED) {
+		if (editPressed(BUTTON_PREVIOUS)) {
 			if (--day > 31) {
 				day = 31;
 			}
@@ -311,14 +964,14 @@ void ThimoClass::editClock() {
 
 	// adjust month
 	LCD.setCursor(7,0);
-	while (!ButtonS.toggled() || ButtonS.read() != Button::PRESSED) {
-		if (ButtonN.toggled() && ButtonN.read() == Button::PRESSED) {
+	while (!editDone()) {
+		if (editPressed(BUTTON_NEXT)) {
 			if (++month > 12) {
 				month = 1;
 			}
 			changed = true;
 		}
-		if (ButtonP.toggled() && ButtonP.read() == Button::PRESSED) {
+		if (editPressed(BUTTON_PREVIOUS)) {
 			if (--month > 12) {
 				month = 12;
 			}
@@ -337,14 +990,14 @@ void ThimoClass::editClock() {
 
 	// adjust year
 	LCD.setCursor(12,0);
-	while (!ButtonS.toggled() || ButtonS.read() != Button::PRESSED) {
-		if (ButtonN.toggled() && ButtonN.read() == Button::PRESSED) {
+	while (!editDone()) {
+		if (editPressed(BUTTON_NEXT)) {
 			if (++year > 2049) {
 				year = 2000;
 			}
 			changed = true;
 		}
-		if (ButtonP.toggled() && ButtonP.read() == Button::PRESSED) {
+		if (editPressed(BUTTON_PREVIOUS)) {
 			if (--year < 2000) {
 				year = 2049;
 			}
@@ -360,14 +1013,14 @@ void ThimoClass::editClock() {
 
 	// adjust hour
 	LCD.setCursor(5,1);
-	while (!ButtonS.toggled() || ButtonS.read() != Button::PRESSED) {
-		if (ButtonN.toggled() && ButtonN.read() == Button::PRESSED) {
+	while (!editDone()) {
+		if (editPressed(BUTTON_NEXT)) {
 			if (++hour > 23) {
 				hour = 0;
 			}
 			changed = true;
 		}
-		if (ButtonP.toggled() && ButtonP.read() == Button::PRESSED) {
+		if (editPressed(BUTTON_PREVIOUS)) {
 			if (--hour > 23) {
 				hour = 23;
 			}
@@ -386,14 +1039,14 @@ void ThimoClass::editClock() {
 
 	// adjust minute
 	LCD.setCursor(8,1);
-	while (!ButtonS.toggled() || ButtonS.read() != Button::PRESSED) {
-		if (ButtonN.toggled() && ButtonN.read() == Button::PRESSED) {
+	while (!editDone()) {
+		if (editPressed(BUTTON_NEXT)) {
 			if (++minute > 59) {
 				minute = 0;
 			}
 			changed = true;
 		}
-		if (ButtonP.toggled() && ButtonP.read() == Button::PRESSED) {
+		if (editPressed(BUTTON_PREVIOUS)) {
 			if (--minute > 59) {
 				minute = 59;
 			}
@@ -412,14 +1065,14 @@ void ThimoClass::editClock() {
 
 	// adjust second
 	LCD.setCursor(11,1);
-	while (!ButtonS.toggled() || ButtonS.read() != Button::PRESSED) {
-		if (ButtonN.toggled() && ButtonN.read() == Button::PRESSED) {
+	while (!editDone()) {
+		if (editPressed(BUTTON_NEXT)) {
 			if (++second > 59) {
 				second = 0;
 			}
 			changed = true;
 		}
-		if (ButtonP.toggled() && ButtonP.read() == Button::PRESSED) {
+		if (editPressed(BUTTON_PREVIOUS)) {
 			if (--second > 59) {
 				second = 59;
 			}
@@ -436,67 +1089,511 @@ void ThimoClass::editClock() {
 		}
 	}
 
-	RTC.adjust(DateTime(year, month, day, hour, minute, second));
+	if (!m_editAbandoned) {
+		Clock.set(DateTime(year, month, day, hour, minute, second).unixtime());
+	}
 	LCD.noBlink();
 }
 
-void ThimoClass::editTimetable(int hfrom, int hto) {
+void ThimoClass::editTimetable(const ViewDescriptor &view) {
+	uint8_t *timetable = m_zones[m_zone].timetable;
 	int col = 2;
 	boolean changed = false;
 	
 	LCD.blink();
 
-	for (int h = hfrom; h <= hto; h++) {
+	for (int h = view.hfrom; h <= view.hto; h++) {
+		uint8_t confirmed = timetable[h];
+
 		LCD.setCursor(col, 1);
-		while (!ButtonS.toggled() || ButtonS.read() != Button::PRESSED) {
-			if (ButtonN.toggled() && ButtonN.read() == Button::PRESSED) {
-				if (++m_timetable[h] > 30) {
-					m_timetable[h] = 0;
+		while (!editDone()) {
+			if (editPressed(BUTTON_NEXT)) {
+				if (++timetable[h] > 30) {
+					timetable[h] = 0;
 				}
 				changed = true;
 			}
-			if (ButtonP.toggled() && ButtonP.read() == Button::PRESSED) {
-				if (--m_timetable[h] > 30) {
-					m_timetable[h] = 30;
+			if (editPressed(BUTTON_PREVIOUS)) {
+				if (--timetable[h] > 30) {
+					timetable[h] = 30;
 				}
 				changed = true;
 			}
 			if (changed) {
 				LCD.setCursor(col, 1);
-				if (m_timetable[h] < 10) {
+				if (timetable[h] < 10) {
 					LCD.print(" ");
 				}
-				LCD.print(m_timetable[h]);
+				LCD.print(timetable[h]);
 				LCD.setCursor(col, 1);
 				changed = false;
 			}
 		}
-		RTC.writenvram(h, m_timetable[h]);
+		if (m_editAbandoned) {
+			timetable[h] = confirmed;
+			break;
+		}
+		if (m_zone < NVRAM_ZONES) {
+			RTC.writenvram(nvramTimetable[m_zone] + h, timetable[h]);
+		}
 		col += 3;
 	}
+	if (m_zone >= NVRAM_ZONES) {
+		saveTimetables();
+	}
 	
 	LCD.noBlink();
 }
 
-void ThimoClass::toggleRelay() {
-	uint8_t s;
-	
-	if (m_manualMode) {
-		s = potTemperature() > m_temperature ? HIGH : LOW;
+// Sensor reads are staggered: at most one blocking capture per call, the
+// control pass runs when it brought a new reading
+void ThimoClass::regulate() {
+	for (uint8_t i = 0; i < ZONE_COUNT; i++) {
+		uint8_t z = m_sensorZone;
+		Sensor::Status status = updateSensor(z);
+		m_sensorZone = (m_sensorZone + 1) % ZONE_COUNT;
+		if (status != Sensor::ERROR_RETRY) {
+			if (status == Sensor::ERROR_NONE) {
+				control(z);
+			}
+			break;
+		}
+	}
+}
+
+// Lowers idle to the time left of a timer started at since, 0 once it's due
+static inline void deadline(unsigned long &idle, unsigned long since, unsigned long period) {
+	unsigned long elapsed = Clock.millis() - since;
+	unsigned long left = elapsed < period ? period - elapsed : 0UL;
+
+	if (left < idle) {
+		idle = left;
+	}
+}
+
+// Milliseconds loop() can be left alone: until a sensor is due, until the
+// journal writes what changed and, with the display lit, until the clock
+// ticks, the refresh and the backlight timeout. Control only runs on new
+// samples, so it has no timer of its own.
+unsigned long ThimoClass::idleTime() {
+	unsigned long idle = LCD_REFRESH_TIME;
+
+	if (!LCD.ready() || LCD.busy()) {
+		return 0UL;
+	}
+
+	for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+		unsigned long left = m_zones[z].sensor->idleTime();
+		if (left < idle) {
+			idle = left;
+		}
+	}
+
+	if (Journal.pending()) {
+		deadline(idle, Journal.changed(), JOURNAL_COALESCE);
+	}
+
+	if (m_backlight) {
+		deadline(idle, m_clockTick, 1000UL);
+		deadline(idle, m_refreshTimer, LCD_REFRESH_TIME + 1);
+		deadline(idle, m_backlightTimer, LCD_BACKLIGHT_DURATION + 1);
+	}
+
+	return idle;
+}
+
+// Target of zone z at the given hour in tenths of °C
+int16_t ThimoClass::setpoint(uint8_t z, uint8_t hour) {
+	const Zone &zone = m_zones[z];
+
+	if (zone.manualMode) {
+		return zone.manualSetpoint;
+	}
+
+	return zone.timetable[hour] * 10;
+}
+
+// The setpoint of zone z now, or a higher one coming within MODEL_MAX_LEAD
+// hours if the thermal model says heating has to start now to reach it on
+// time. An override in force takes over from both. Tenths of °C.
+int16_t ThimoClass::target(uint8_t z, const DateTime &time) {
+	const Zone &zone = m_zones[z];
+	const Override *entry = Overrides.active(z);
+	int16_t target = setpoint(z, time.hour());
+	uint32_t until = 3600UL - time.minute() * 60UL - time.second();
+
+	if (entry != NULL) {
+		return entry->setpoint;
+	}
+	if (zone.manualMode || !zone.model.ready()) {
+		return target;
+	}
+
+	for (uint8_t h = 1; h <= MODEL_MAX_LEAD; h++, until += 3600UL) {
+		int16_t next = zone.timetable[(time.hour() + h) % 24] * 10;
+		if (next > target && zone.model.lead(zone.temperature, next / 10.0f) >= until) {
+			target = next;
+		}
+	}
+
+	return target;
+}
+
+void ThimoClass::model(uint8_t z, const ModelState &state) {
+	if (z < ZONE_COUNT) {
+		m_zones[z].model.restore(state);
+	}
+}
+
+// Traced, then applied to the overrides: an entry ending at 0 clears its
+// kind from its zones
+bool ThimoClass::override(const Override &entry) {
+	Trace.override(entry);
+
+	return applyOverride(entry);
+}
+
+// A whole argument in [min, max], nothing may follow the digits
+static bool parseNumber(const char *arg, long min, long max, long &value) {
+	char *end;
+
+	value = strtol(arg, &end, 10);
+
+	return end != arg && *end == '\0' && value >= min && value <= max;
+}
+
+// °C to tenths, 0 to 30
+static bool parseTemperature(const char *arg, int16_t &setpoint) {
+	char *end;
+	float value = strtof(arg, &end);
+
+	if (end == arg || *end != '\0' || !(value >= 0.0f && value <= 30.0f)) {
+		return false;
+	}
+	setpoint = (int16_t)lroundf(value * 10.0f);
+
+	return true;
+}
+
+// Text form shared by the console and the HTTP server, for zone z:
+//   boost [temp [minutes]]             hold temp
+//   away [temp [hours]]                holiday yyyy mm dd days [temp]
+//   clear boost|hold|away|holiday
+// Boosts and holds are for zone z, away and holidays for every zone; away
+// lasts until cleared without hours, a holiday starts at midnight. Numbers
+// must parse whole and in range: 0-30 °C, a day of boost, a year away.
+bool ThimoClass::override(uint8_t z, const char *command) {
+	char buf[48];
+	char *args[6];
+	char *save;
+	uint8_t n = 0;
+	uint32_t now = Clock.now().unixtime();
+	Override entry;
+
+	if (z >= ZONE_COUNT || strlen(command) >= sizeof(buf)) {
+		return false;
+	}
+	strcpy(buf, command);
+	for (char *arg = strtok_r(buf, " \r\n", &save); arg != NULL; arg = strtok_r(NULL, " \r\n", &save)) {
+		if (n == 6) {
+			return false;
+		}
+		args[n++] = arg;
+	}
+	if (n == 0) {
+		return false;
+	}
+
+	entry.start = now;
+	entry.zones = 1 << z;
+	if (!strcmp(args[0], "boost") && n <= 3) {
+		long minutes = OVERRIDE_BOOST_TIME / 60;
+
+		entry.kind = OVERRIDE_BOOST;
+		entry.setpoint = OVERRIDE_BOOST_TEMPERATURE * 10;
+		if ((n > 1 && !parseTemperature(args[1], entry.setpoint)) || (n > 2 && !parseNumber(args[2], 1, 1440, minutes))) {
+			return false;
+		}
+		entry.end = now + minutes * 60UL;
+	} else if (!strcmp(args[0], "hold") && n == 2) {
+		entry.kind = OVERRIDE_HOLD;
+		if (!parseTemperature(args[1], entry.setpoint)) {
+			return false;
+		}
+		entry.end = holdEnd(z, now);
+	} else if (!strcmp(args[0], "away") && n <= 3) {
+		long hours = 0;
+
+		entry.kind = OVERRIDE_AWAY;
+		entry.zones = allZones;
+		entry.setpoint = OVERRIDE_AWAY_TEMPERATURE * 10;
+		if ((n > 1 && !parseTemperature(args[1], entry.setpoint)) || (n > 2 && !parseNumber(args[2], 1, 8760, hours))) {
+			return false;
+		}
+		entry.end = n > 2 ? now + hours * 3600UL : OVERRIDE_FOREVER;
+	} else if (!strcmp(args[0], "holiday") && n >= 5) {
+		long year, month, day, days;
+
+		if (!parseNumber(args[1], 2000, 2099, year) || !parseNumber(args[2], 1, 12, month) || !parseNumber(args[4], 1, 366, days)) {
+			return false;
+		}
+		if (!parseNumber(args[3], 1, monthDays[month - 1] + (month == 2 && year % 4 == 0), day)) {
+			return false;
+		}
+		entry.kind = OVERRIDE_HOLIDAY;
+		entry.zones = allZones;
+		entry.setpoint = OVERRIDE_HOLIDAY_TEMPERATURE * 10;
+		if (n > 5 && !parseTemperature(args[5], entry.setpoint)) {
+			return false;
+		}
+		entry.start = DateTime(year, month, day).unixtime();
+		entry.end = entry.start + days * 86400UL;
+	} else if (!strcmp(args[0], "clear") && n == 2) {
+		for (entry.kind = 0; entry.kind < OVERRIDE_KINDS && strcmp(args[1], OverrideModule::name(entry.kind)); entry.kind++);
+		if (entry.kind == OVERRIDE_KINDS) {
+			return false;
+		}
+		entry.zones = entry.kind <= OVERRIDE_AWAY ? allZones : 1 << z;
+		entry.setpoint = 0;
+		entry.start = 0;
+		entry.end = 0;
+	} else {
+		return false;
+	}
+
+	return override(entry);
+}
+
+// Button edits come here directly, the presses are traced already
+bool ThimoClass::applyOverride(const Override &entry) {
+	uint32_t now = Clock.now().unixtime();
+	bool added = true;
+
+	if (entry.end == 0) {
+		Overrides.remove(entry.kind, entry.zones, now);
 	} else {
-		DateTime now = RTC.now();
-		s = m_timetable[now.hour()] > (uint8_t)m_temperature ? HIGH : LOW;
+		added = Overrides.add(entry, now);
 	}
+	m_dirty |= FIELD_MODE | FIELD_SETPOINT;
+
+	return added;
+}
+
+// A hold ends with the first hour the timetable asks for another
+// temperature, a day later at most
+uint32_t ThimoClass::holdEnd(uint8_t z, uint32_t now) {
+	const uint8_t *timetable = m_zones[z].timetable;
+	DateTime time(now);
+	uint32_t end = now - time.minute() * 60UL - time.second();
 
-	if (s != digitalRead(RELAY_PIN)) {
-		m_backlightTimer = millis();
+	for (uint8_t h = 1; h < 24; h++) {
+		end += 3600UL;
+		if (timetable[(time.hour() + h) % 24] != timetable[time.hour()]) {
+			return end;
+		}
 	}
 
-	digitalWrite(RELAY_PIN, s);
+	return end + 3600UL;
 }
 
-float ThimoClass::potTemperature() {
-	return 30.0f;
+// One pass over all zones, after a restore or the boot readings
+void ThimoClass::control() {
+	control(0, ZONE_COUNT);
+}
+
+// The pass a new sample calls for: the other zones keep their relays until
+// their own samples come, so a round of N samples costs N zone updates
+void ThimoClass::control(uint8_t z) {
+	control(z, z + 1);
+}
+
+// Zones first to last - 1: the clock is read once, each zone runs its
+// controller on integer tenths of °C
+void ThimoClass::control(uint8_t first, uint8_t last) {
+	WatchdogModule::Section section = Watchdog.enter(WatchdogModule::SECTION_CONTROL);
+	unsigned long start = micros();
+	unsigned long now = Clock.millis();
+	DateTime time = Clock.now();
+
+	if (Meter.update(time, now)) {
+		m_dirty |= FIELD_ENERGY;
+	}
+	if (Overrides.update(time.unixtime())) {
+		m_dirty |= FIELD_MODE | FIELD_SETPOINT;
+	}
+	for (uint8_t z = first; z < last; z++) {
+		Zone &zone = m_zones[z];
+
+		if (!zone.sampled) {
+			continue; // keep the restored state until the sensor answers
+		}
+		bool on = zone.window.open() ? zone.controller.suspend(now) :
+			zone.controller.update(target(z, time), (int16_t)lroundf(zone.temperature * 10.0f), now);
+
+		// the pin and the counters only see transitions
+		if (on != zone.relay) {
+			zone.relay = on;
+			digitalWrite(zone.relayPin, on ? HIGH : LOW);
+			Meter.relay(z, on, now);
+			m_backlightTimer = Clock.millis();
+			writeRelays(z);
+			LOG_INFO(LOG_RELAY, z, on);
+			Trace.relay(z, on);
+			if (z == 0) {
+				History.relay(on);
+			}
+			if (z == m_zone) {
+				m_dirty |= FIELD_RELAY;
+			}
+		}
+		if (on && z == m_zone) {
+			m_dirty |= FIELD_ENERGY;
+		}
+	}
+
+	unsigned long elapsed = micros() - start;
+	m_controlTime += elapsed;
+	m_controlCount++;
+	Power.measure(PowerModule::TASK_CONTROL, elapsed);
+	Watchdog.enter(section);
+}
+
+// Relay states are persisted as a bitmask, the byte holding zone z is rewritten
+void ThimoClass::writeRelays(uint8_t z) {
+	uint8_t bits = 0;
+	uint8_t first = z & ~7;
+
+	for (uint8_t i = first; i < first + 8 && i < ZONE_COUNT; i++) {
+		if (m_zones[i].relay) {
+			bits |= 1 << (i - first);
+		}
+	}
+	RTC.writenvram(NVRAM_RELAY + z / 8, bits);
+}
+
+// The models are kept in flash, they take days to learn and a power cut
+// would lose them from RTC memory. The trace starts from them as well.
+// The schedules of the zones past NVRAM_ZONES, in place of zone 0's that
+// restoreSchedules() gave them; the trace gets them as edits
+void ThimoClass::restoreTimetables() {
+#if defined(ESP32) && !defined(THIMO_SIMULATION)
+	uint8_t tables[ZONE_COUNT > NVRAM_ZONES ? ZONE_COUNT - NVRAM_ZONES : 1][24];
+	Preferences preferences;
+
+	if (ZONE_COUNT <= NVRAM_ZONES || !preferences.begin("thimo", true)) {
+		return;
+	}
+	bool found = preferences.getBytes("timetables", tables, sizeof(tables)) == sizeof(tables);
+	preferences.end();
+	if (!found) {
+		return;
+	}
+
+	for (uint8_t z = NVRAM_ZONES; z < ZONE_COUNT; z++) {
+		for (uint8_t h = 0; h < 24; h++) {
+			m_zones[z].timetable[h] = tables[z - NVRAM_ZONES][h] > 30 ? 0 : tables[z - NVRAM_ZONES][h];
+			Trace.timetable(z, h, m_zones[z].timetable[h]);
+		}
+	}
+#endif
+}
+
+// After an edit of one of them, schedules change seldom enough for flash
+void ThimoClass::saveTimetables() {
+#if defined(ESP32) && !defined(THIMO_SIMULATION)
+	uint8_t tables[ZONE_COUNT > NVRAM_ZONES ? ZONE_COUNT - NVRAM_ZONES : 1][24];
+	Preferences preferences;
+
+	if (ZONE_COUNT <= NVRAM_ZONES || !preferences.begin("thimo", false)) {
+		return;
+	}
+	for (uint8_t z = NVRAM_ZONES; z < ZONE_COUNT; z++) {
+		memcpy(tables[z - NVRAM_ZONES], m_zones[z].timetable, 24);
+	}
+	preferences.putBytes("timetables", tables, sizeof(tables));
+	preferences.end();
+#endif
+}
+
+void ThimoClass::restoreModels() {
+#if defined(ESP32) && !defined(THIMO_SIMULATION)
+	ModelState states[ZONE_COUNT];
+	Preferences preferences;
+
+	if (!preferences.begin("thimo", true)) {
+		return;
+	}
+	bool found = preferences.getBytes("models", states, sizeof(states)) == sizeof(states);
+	preferences.end();
+	if (!found) {
+		return;
+	}
+
+	m_modelUpdates = 0;
+	for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+		m_zones[z].model.restore(states[z]);
+		Trace.model(z, states[z]);
+		m_modelUpdates += states[z].updates;
+	}
+#endif
+}
+
+// Only when a model learned something since the last save, flash wears out
+void ThimoClass::saveModels() {
+	uint32_t updates = 0;
+
+	for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+		updates += m_zones[z].model.updates();
+	}
+	if (updates == m_modelUpdates) {
+		return;
+	}
+	m_modelUpdates = updates;
+
+#if defined(ESP32) && !defined(THIMO_SIMULATION)
+	ModelState states[ZONE_COUNT];
+	Preferences preferences;
+
+	for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+		m_zones[z].model.save(states[z]);
+	}
+	if (preferences.begin("thimo", false)) {
+		preferences.putBytes("models", states, sizeof(states));
+		preferences.end();
+	}
+#endif
+}
+
+// Hands the runtime state to the journal, which writes it if it changed
+void ThimoClass::journal() {
+	JournalRecord journal;
+
+	memset(&journal, 0, sizeof(journal));
+	journal.view = m_view;
+	journal.zone = m_zone;
+	journal.time = Clock.utc();
+	for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+		const Zone &zone = m_zones[z];
+
+		journal.zones[z].temperature = zone.sampled ? (int16_t)lroundf(zone.temperature * 10.0f) : JOURNAL_NONE;
+		journal.zones[z].manual = zone.manualSetpoint / 5;
+		if (zone.manualMode) {
+			journal.zones[z].flags |= JOURNAL_MANUAL;
+		}
+		if (zone.controller.mode() == Controller::PID) {
+			journal.zones[z].flags |= JOURNAL_PID;
+		}
+	}
+	Journal.save(journal);
+}
+
+void ThimoClass::recordSample() {
+	Sample sample;
+
+	sample.time = Clock.now().unixtime();
+	sample.temperature = (int16_t)lroundf(m_zones[0].temperature * 10.0f);
+	sample.humidity = (int16_t)lroundf(m_zones[0].humidity * 10.0f);
+	History.record(sample);
 }
 
 ThimoClass Thimo;
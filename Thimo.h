@@ -15,10 +15,30 @@
 
 #include "LCD.h"
 #include "RTC.h"
-#include "DHT.h"
+#include "Zone.h"
 #include "Button.h"
+#include "History.h"
+#include "Boot.h"
+#include "Log.h"
+#include "Glyph.h"
+#include "Clock.h"
+#include "Power.h"
+#include "Journal.h"
+#include "Meter.h"
+#include "Watchdog.h"
+#include "Simulator.h"
+#include "Trace.h"
+#include "Override.h"
 
-enum {
+// DS1307 NVRAM layout: relay states are a bitmask (bit 0 is zone 0), only the
+// first two zone schedules fit, the others are kept in Preferences
+#define NVRAM_TIMETABLE				0
+#define NVRAM_RELAY					24
+#define NVRAM_TIMETABLE2			26
+#define NVRAM_SIZE					50
+#define NVRAM_ZONES					2
+
+enum View {
 	ENVIRONMENT,
 	MANUAL,
 	CLOCK,
@@ -26,8 +46,22 @@ enum {
 	TIMETABLE2,
 	TIMETABLE3,
 	TIMETABLE4,
-	TIMETABLE5
-}	View;
+	TIMETABLE5,
+	ENERGY,
+	OVERRIDE,
+	VIEW_COUNT
+};
+
+// data shown on the display, a view is redrawn only when one of its fields changed
+#define FIELD_TEMPERATURE			0x01
+#define FIELD_HUMIDITY				0x02
+#define FIELD_MODE					0x04
+#define FIELD_SETPOINT				0x08
+#define FIELD_CLOCK					0x10
+#define FIELD_TIMETABLE				0x20
+#define FIELD_RELAY					0x40
+#define FIELD_ENERGY				0x80
+#define FIELD_ALL					0xff
 
 class ThimoClass {
 public:
@@ -35,30 +69,109 @@ public:
 	virtual ~ThimoClass();
 
 	void begin();
+	void restore(const uint8_t *nvram, const uint8_t *journal = NULL);
 	void loop();
+	void regulate();
+	void sample(uint8_t z, Sensor::Status status, const Environment &env);
+	void control();
+	void control(uint8_t z);
+	void buttons();
 	void refresh();
+	void render();
+	void render(uint8_t view);
+	uint8_t checksum();
 	void menuNext();
 	void menuPrevious();
 	void menuSelect();
+
+	inline const Zone &zone(uint8_t z) const { return m_zones[z]; }
+	inline float temperature(uint8_t z = 0) const { return m_zones[z].temperature; }
+	inline float humidity(uint8_t z = 0) const { return m_zones[z].humidity; }
+	inline int8_t trend(uint8_t z = 0) const { return m_zones[z].trend; }
+	inline bool relay(uint8_t z = 0) const { return m_zones[z].relay; }
+	inline bool manualMode(uint8_t z = 0) const { return m_zones[z].manualMode; }
+	void manualMode(uint8_t z, bool manual);
+	inline int16_t manualSetpoint(uint8_t z = 0) const { return m_zones[z].manualSetpoint; }
+	bool manualSetpoint(uint8_t z, int16_t setpoint);
+	void controlMode(uint8_t z, Controller::Mode mode);
+	inline uint8_t timetable(uint8_t z, uint8_t hour) const { return m_zones[z].timetable[hour]; }
+	bool timetable(uint8_t z, uint8_t hour, uint8_t temperature);
+	bool timetable(uint8_t z, const uint8_t *table);
+	int16_t setpoint(uint8_t z, uint8_t hour);
+	int16_t target(uint8_t z, const DateTime &time);
+	void model(uint8_t z, const ModelState &state);
+	bool override(const Override &entry);
+	bool override(uint8_t z, const char *command);
+	unsigned long idleTime();
+
+	inline uint8_t shownZone() const { return m_zone; }
+	inline uint32_t controlCount() const { return m_controlCount; }
+	inline uint32_t controlTime() const { return m_controlTime; }
+
+	inline uint8_t view() const { return m_view; }
+	inline uint32_t renderCount(uint8_t view) const { return m_renderCount[view]; }
+	inline uint32_t renderTime(uint8_t view) const { return m_renderTime[view]; }
 private:
+	struct ViewDescriptor {
+		uint8_t fields;
+		void (ThimoClass::*render)(const ViewDescriptor &view);
+		void (ThimoClass::*edit)(const ViewDescriptor &view);
+		uint8_t hfrom;
+		uint8_t hto;
+	};
+
+	static const ViewDescriptor s_views[VIEW_COUNT];
+
+	Zone m_zones[ZONE_COUNT];
+	uint8_t m_zone = 0;			// shown on the display
+	uint8_t m_sensorZone = 0;	// next sensor to read
 	uint8_t m_view = CLOCK;
-	uint8_t m_timetable[24];
-	bool m_manualMode = false;
 	unsigned long m_sensorTimer = 0UL;
 	unsigned long m_refreshTimer = 0UL;
 	unsigned long m_backlightTimer = 0UL;
-	float m_humidity = 0.0f;
-	float m_temperature = 0.0f;
+	unsigned long m_clockTick = 0UL;
+	uint8_t m_dirty = FIELD_ALL;
+	bool m_backlight = false;
+	uint32_t m_renderCount[VIEW_COUNT];
+	uint32_t m_renderTime[VIEW_COUNT];
+	uint32_t m_controlCount = 0;
+	uint32_t m_controlTime = 0;
+	unsigned long m_modelTimer = 0UL;
+	uint32_t m_modelUpdates = 0;	// at the last save
+	unsigned long m_editTimer = 0UL;	// last press in an editor
+	bool m_editAbandoned = false;
 
-	void displayEnvironment();
-	void displayManual();
-	void displayClock();
-	void displayTimetable(int hfrom, int hto);
-	void editManual();
-	void editClock();
-	void editTimetable(int hfrom, int hto);
-	void toggleRelay();
-	float potTemperature();
+	void show(uint8_t view);
+	void draw();
+	void displayEnvironment(const ViewDescriptor &view);
+	void displayEnvironmentText(const ViewDescriptor &view);
+	void displayManual(const ViewDescriptor &view);
+	void displayClock(const ViewDescriptor &view);
+	void displayTimetable(const ViewDescriptor &view);
+	void displayEnergy(const ViewDescriptor &view);
+	void displayOverride(const ViewDescriptor &view);
+	void editManual(const ViewDescriptor &view);
+	void editClock(const ViewDescriptor &view);
+	void editTimetable(const ViewDescriptor &view);
+	void editZone(const ViewDescriptor &view);
+	void editOverride(const ViewDescriptor &view);
+	bool editPressed(ButtonId id);
+	bool editDone();
+	bool applyOverride(const Override &entry);
+	uint32_t holdEnd(uint8_t z, uint32_t now);
+	void restoreSchedules(const uint8_t *nvram);
+	void restoreRelays(const uint8_t *nvram);
+	void restoreJournal(const uint8_t *journal);
+	void restoreTimetables();
+	void saveTimetables();
+	void restoreModels();
+	void saveModels();
+	void journal();
+	Sensor::Status updateSensor(uint8_t z);
+	void control(uint8_t first, uint8_t last);
+	void updateTrend(uint8_t z);
+	void writeRelays(uint8_t z);
+	void recordSample();
 };
 
 extern ThimoClass Thimo;
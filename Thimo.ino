@@ -35,11 +35,19 @@
 
 #include <Wire.h>
 #include "Thimo.h"
+#include "Console.h"
+#include "Power.h"
+#include "Watchdog.h"
+#include "Http.h"
+#include "Ntp.h"
 
 /**
  * main initializatione routine
  */
 void setup() {
+	/* stall supervision, first: it reads what the last reset left behind */
+	Watchdog.begin();
+
 	/*/ Serial initialization (for debug porpouse only) */
 	Serial.begin(9600);
 
@@ -48,25 +56,65 @@ void setup() {
 
 	/* RTC module initialization */
 	RTC.begin();
+	Boot.mark(BootModule::STEP_RTC);
 
-	/* LCD module initialization */
-	LCD.begin(16, 2);
+	/* History module initialization */
+	History.begin();
 
-	/* DHT module initialization */
-	DHT.begin();
+	/* Thimo module initialization: restores schedule and relay, runs first control */
+	Thimo.begin();
 	
 	/* Buttons initialization */
 	ButtonS.begin();
 	ButtonN.begin();
 	ButtonP.begin();
+	Boot.mark(BootModule::STEP_UI);
 
-	/* Thimo module initialization */
-	Thimo.begin();
+	/* LCD module initialization (completed in background by Thimo.loop) */
+	LCD.start(16, 2);
+
+	/* Wi-Fi join and HTTP server, it starts listening once the link is up */
+	Http.begin();
+
+	/* time server, asked once the link is up */
+	Ntp.begin();
+
+	/* light sleep wakeup sources, after buttons and serial are set up */
+	Power.begin();
 }
 
 /**
  * main loop function
  */
 void loop() {
+	/* every pass restarts the stall supervision clock */
+	Watchdog.feed();
 	Thimo.loop();
+
+	/* serial console, its replies take precedence over log output */
+	Watchdog.enter(WatchdogModule::SECTION_CONSOLE);
+	Console.poll(Serial);
+
+	/* HTTP server, at most HTTP_POLL_BYTES of a request or a response per pass */
+	Watchdog.enter(WatchdogModule::SECTION_HTTP);
+	Http.poll();
+
+	/* time sync: sends a request or looks for the reply */
+	Watchdog.enter(WatchdogModule::SECTION_NTP);
+	Ntp.poll();
+
+	/* idle work: flush pending log messages without waiting on the UART */
+	Watchdog.enter(WatchdogModule::SECTION_LOG);
+	if (Console.idle()) {
+		Log.drain(Serial);
+	}
+
+	/* CPU back to the idle frequency once bursty work is over */
+	Power.govern();
+
+	/* nothing left to send and nobody typing: sleep until the next deadline, light sleep drops Wi-Fi */
+	if (Console.idle() && Log.idle() && Console.quiet() >= POWER_SERIAL_AWAKE && !Http.online()) {
+		Watchdog.enter(WatchdogModule::SECTION_SLEEP);
+		Power.sleep(Serial, Thimo.idleTime());
+	}
 }
@@ -0,0 +1,587 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Trace.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo input trace recorder and replayer
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Trace.h"
+#include "Codec.h"
+#include "Clock.h"
+
+#ifdef THIMO_SIMULATION
+#include "Thimo.h"
+#endif
+
+static int16_t traceValue(float value) {
+	return isnan(value) ? TRACE_NAN : (int16_t)lroundf(value * 100.0f);
+}
+
+static float traceFloat(int32_t value) {
+	return value == TRACE_NAN ? NAN : value / 100.0f;
+}
+
+TraceModule::TraceModule() :
+	m_head(0),
+	m_count(0),
+	m_started(false),
+	m_last(0UL),
+	m_unixtime(0),
+	m_unixMillis(0UL),
+	m_records(0)
+#ifdef THIMO_SIMULATION
+	,
+	m_replaying(false),
+	m_exact(false),
+	m_peeked(false),
+	m_block(0),
+	m_pos(NULL),
+	m_button(-1),
+	m_replayed(0),
+	m_relayErrors(0),
+	m_displayErrors(0),
+	m_replayTime(0)
+#endif
+{
+}
+
+// Starts recording from the NVRAM image the unit booted with
+void TraceModule::begin(uint32_t unixtime, const uint8_t *state, uint8_t length) {
+	uint8_t record[TRACE_MAX_RECORD];
+	uint8_t n;
+
+	m_head = 0;
+	m_count = 1;
+	m_length[0] = 0;
+	m_records = 0;
+	m_last = Clock.millis();
+	m_unixtime = unixtime;
+	m_unixMillis = m_last;
+	m_started = true;
+
+	if (length > TRACE_MAX_RECORD - 12) {
+		length = TRACE_MAX_RECORD - 12;
+	}
+	n = start(record, TRACE_STATE);
+	n += codecPutVarint(record + n, unixtime);
+	record[n++] = length;
+	memcpy(record + n, state, length);
+	put(record, n + length);
+}
+
+void TraceModule::sensor(uint8_t zone, uint8_t status, const Environment &env) {
+	uint8_t record[16];
+	uint8_t n = start(record, TRACE_SENSOR);
+
+	record[n++] = zone;
+	record[n++] = status;
+	if (status == Sensor::ERROR_NONE) {
+		n += codecPutVarint(record + n, codecZigzag(traceValue(env.temperature)));
+		n += codecPutVarint(record + n, codecZigzag(traceValue(env.humidity)));
+	}
+	put(record, n);
+}
+
+void TraceModule::button(uint8_t id) {
+	uint8_t record[8];
+	uint8_t n = start(record, TRACE_BUTTON);
+
+	record[n++] = id;
+	put(record, n);
+}
+
+// Only a reading the prediction gets wrong is recorded
+void TraceModule::clock(uint32_t unixtime) {
+	uint8_t record[12];
+	unsigned long now = Clock.millis();
+	uint32_t expected = predicted(now);
+
+	if (!m_started || unixtime == expected) {
+		return;
+	}
+
+	uint8_t n = start(record, TRACE_CLOCK);
+	n += codecPutVarint(record + n, codecZigzag((int32_t)(unixtime - expected)));
+	put(record, n);
+	m_unixtime = unixtime;
+	m_unixMillis = now;
+}
+
+void TraceModule::timetable(uint8_t zone, uint8_t hour, uint8_t temperature) {
+	uint8_t record[8];
+	uint8_t n = start(record, TRACE_TIMETABLE);
+
+	record[n++] = zone;
+	record[n++] = hour;
+	record[n++] = temperature;
+	put(record, n);
+}
+
+void TraceModule::mode(uint8_t zone, bool manual, uint8_t controller, int16_t setpoint) {
+	uint8_t record[12];
+	uint8_t n = start(record, TRACE_MODE);
+
+	record[n++] = zone;
+	record[n++] = manual ? 1 : 0;
+	record[n++] = controller;
+	n += codecPutVarint(record + n, codecZigzag(setpoint));
+	put(record, n);
+}
+
+void TraceModule::model(uint8_t zone, const ModelState &state) {
+	uint8_t record[8 + sizeof(ModelState)];
+	uint8_t n = start(record, TRACE_MODEL);
+
+	record[n++] = zone;
+	memcpy(record + n, &state, sizeof(state));
+	put(record, n + sizeof(state));
+}
+
+void TraceModule::override(const Override &entry) {
+	uint8_t record[24];
+	uint8_t n = start(record, TRACE_OVERRIDE);
+
+	record[n++] = entry.kind;
+	n += codecPutVarint(record + n, entry.zones);
+	n += codecPutVarint(record + n, codecZigzag(entry.setpoint));
+	n += codecPutVarint(record + n, entry.start);
+	n += codecPutVarint(record + n, entry.end);
+	put(record, n);
+}
+
+void TraceModule::relay(uint8_t zone, bool state) {
+	uint8_t record[8];
+	uint8_t n = start(record, TRACE_RELAY);
+
+	record[n++] = zone;
+	record[n++] = state ? 1 : 0;
+	put(record, n);
+}
+
+void TraceModule::display(uint8_t checksum) {
+	uint8_t record[8];
+	uint8_t n = start(record, TRACE_DISPLAY);
+
+	record[n++] = checksum;
+	put(record, n);
+}
+
+uint8_t TraceModule::blocks() const {
+	return m_count;
+}
+
+const uint8_t *TraceModule::block(uint8_t index, size_t &length) const {
+	if (index >= m_count) {
+		length = 0;
+		return NULL;
+	}
+
+	// index 0 is the oldest block
+	uint8_t b = (m_head + TRACE_BLOCKS - m_count + 1 + index) % TRACE_BLOCKS;
+	length = m_length[b];
+
+	return m_data[b];
+}
+
+size_t TraceModule::bytes() const {
+	size_t n = 0;
+
+	for (uint8_t i = 0; i < m_count; i++) {
+		n += m_length[(m_head + TRACE_BLOCKS - i) % TRACE_BLOCKS];
+	}
+
+	return n;
+}
+
+// Reads one record, false for a truncated or unknown one
+bool TraceModule::decode(const uint8_t *&pos, const uint8_t *end, TraceRecord &record) {
+	const uint8_t *p = pos;
+	uint32_t v;
+	uint8_t n;
+
+	if (p >= end) {
+		return false;
+	}
+	record.tag = *p++;
+	if ((n = codecGetVarint(p, end, record.dt)) == 0) {
+		return false;
+	}
+	p += n;
+
+	switch (record.tag) {
+		case TRACE_STATE:
+			if ((n = codecGetVarint(p, end, record.time)) == 0 || p + n >= end) {
+				return false;
+			}
+			p += n;
+			record.length = *p++;
+			record.state = p;
+			p += record.length;
+			if (p > end) {
+				return false;
+			}
+			break;
+		case TRACE_KEY:
+			if ((n = codecGetVarint(p, end, v)) == 0) {
+				return false;
+			}
+			p += n;
+			if ((n = codecGetVarint(p, end, record.time)) == 0) {
+				return false;
+			}
+			p += n;
+			break;
+		case TRACE_SENSOR:
+			if (p + 2 > end) {
+				return false;
+			}
+			record.zone = *p++;
+			record.value = *p++;
+			record.env.temperature = NAN;
+			record.env.humidity = NAN;
+			if (record.value == Sensor::ERROR_NONE) {
+				if ((n = codecGetVarint(p, end, v)) == 0) {
+					return false;
+				}
+				p += n;
+				record.env.temperature = traceFloat(codecUnzigzag(v));
+				if ((n = codecGetVarint(p, end, v)) == 0) {
+					return false;
+				}
+				p += n;
+				record.env.humidity = traceFloat(codecUnzigzag(v));
+			}
+			break;
+		case TRACE_BUTTON:
+		case TRACE_DISPLAY:
+			if (p >= end) {
+				return false;
+			}
+			record.value = *p++;
+			break;
+		case TRACE_CLOCK:
+			if ((n = codecGetVarint(p, end, v)) == 0) {
+				return false;
+			}
+			p += n;
+			record.offset = codecUnzigzag(v);
+			break;
+		case TRACE_RELAY:
+			if (p + 2 > end) {
+				return false;
+			}
+			record.zone = *p++;
+			record.value = *p++;
+			break;
+		case TRACE_TIMETABLE:
+			if (p + 3 > end) {
+				return false;
+			}
+			record.zone = *p++;
+			record.index = *p++;
+			record.value = *p++;
+			break;
+		case TRACE_MODE:
+			if (p + 3 > end) {
+				return false;
+			}
+			record.zone = *p++;
+			record.value = *p++;
+			record.index = *p++;
+			if ((n = codecGetVarint(p, end, v)) == 0) {
+				return false;
+			}
+			p += n;
+			record.offset = codecUnzigzag(v);
+			break;
+		case TRACE_MODEL:
+			if (p + 1 + sizeof(ModelState) > end) {
+				return false;
+			}
+			record.zone = *p++;
+			record.state = p;
+			record.length = sizeof(ModelState);
+			p += record.length;
+			break;
+		case TRACE_OVERRIDE:
+			if (p >= end) {
+				return false;
+			}
+			record.value = *p++;
+			if ((n = codecGetVarint(p, end, v)) == 0) {
+				return false;
+			}
+			p += n;
+			record.zones = v;
+			if ((n = codecGetVarint(p, end, v)) == 0) {
+				return false;
+			}
+			p += n;
+			record.offset = codecUnzigzag(v);
+			if ((n = codecGetVarint(p, end, v)) == 0) {
+				return false;
+			}
+			p += n;
+			record.time = v;
+			if ((n = codecGetVarint(p, end, v)) == 0) {
+				return false;
+			}
+			p += n;
+			record.until = v;
+			break;
+		default:
+			return false;
+	}
+
+	pos = p;
+
+	return true;
+}
+
+// Tag and milliseconds since the previous record
+uint8_t TraceModule::start(uint8_t *record, uint8_t tag) {
+	unsigned long now = Clock.millis();
+	uint8_t n = 0;
+
+	record[n++] = tag;
+	n += codecPutVarint(record + n, now - m_last);
+	m_last = now;
+
+	return n;
+}
+
+void TraceModule::put(const uint8_t *record, uint8_t n) {
+#ifdef THIMO_SIMULATION
+	if (m_replaying) {
+		return;
+	}
+#endif
+	if (!m_started) {
+		return;
+	}
+
+	if (m_length[m_head] == 0 || m_length[m_head] + n > TRACE_BLOCK_SIZE) {
+		rotate();
+	}
+	memcpy(m_data[m_head] + m_length[m_head], record, n);
+	m_length[m_head] += n;
+	m_records++;
+}
+
+// Opens a block with a KEY record, the block is decodable without the others
+void TraceModule::rotate() {
+	uint8_t *key;
+
+	if (m_length[m_head] > 0) {
+		m_head = (m_head + 1) % TRACE_BLOCKS;
+		if (m_count < TRACE_BLOCKS) {
+			m_count++;
+		}
+	}
+
+	key = m_data[m_head];
+	key[0] = TRACE_KEY;
+	key[1] = 0;
+	m_length[m_head] = 2;
+	m_length[m_head] += codecPutVarint(key + m_length[m_head], m_last);
+	m_length[m_head] += codecPutVarint(key + m_length[m_head], predicted(m_last));
+}
+
+#ifdef THIMO_SIMULATION
+
+// Uploaded blocks replace the trace, block 0 at offset 0 starts over
+bool TraceModule::load(uint8_t index, uint16_t offset, const uint8_t *data, size_t n) {
+	if (index >= TRACE_BLOCKS || offset + n > TRACE_BLOCK_SIZE) {
+		return false;
+	}
+
+	if (index == 0 && offset == 0) {
+		m_started = false;		// the bench stops recording its own inputs
+		m_count = 0;
+		m_records = 0;
+	}
+	if (offset == 0) {
+		if (index != m_count) {
+			return false;
+		}
+		m_head = index;
+		m_count++;
+		m_length[index] = 0;
+	} else if (index != m_head || offset != m_length[index]) {
+		return false;
+	}
+
+	memcpy(m_data[index] + offset, data, n);
+	m_length[index] += n;
+
+	return true;
+}
+
+// Feeds the recorded inputs to the control path and the views on virtual
+// time, as fast as they go, and checks the outputs they produce
+void TraceModule::replay() {
+	unsigned long start = millis();
+
+	m_replaying = true;
+	m_exact = false;
+	m_peeked = false;
+	m_block = 0;
+	m_pos = NULL;
+	m_button = -1;
+	m_replayed = 0;
+	m_relayErrors = 0;
+	m_displayErrors = 0;
+
+	while (next()) {
+		m_peeked = false;
+		apply(m_record);
+	}
+
+	m_replaying = false;
+	m_replayTime = millis() - start;
+	Clock.resync();
+}
+
+// Presses come from the record being applied while the main loop looks for
+// one, then from the records that follow while an editor waits for them.
+// The KEY records of the blocks opened meanwhile go by. Anything else was
+// recorded after the editor timed out, the clock is at it now and the
+// editor sees the timeout. The end of the trace leaves the editor with
+// select.
+bool TraceModule::pressed(uint8_t id) {
+	if (m_button >= 0) {
+		if (m_button != id) {
+			return false;
+		}
+		m_button = -1;
+		return true;
+	}
+
+	for (;;) {
+		if (!next()) {
+			return id == BUTTON_SELECT;
+		}
+		if (m_record.tag != TRACE_KEY) {
+			break;
+		}
+		m_peeked = false;
+		apply(m_record);
+	}
+	if (m_record.tag != TRACE_BUTTON || m_record.value != id) {
+		return false;
+	}
+	m_peeked = false;
+
+	return true;
+}
+
+// Looks at the next record and moves the clock to it, it stays current
+// until m_peeked is cleared
+bool TraceModule::next() {
+	if (m_peeked) {
+		return true;
+	}
+
+	for (;;) {
+		size_t length;
+		const uint8_t *data = block(m_block, length);
+
+		if (data == NULL) {
+			return false;
+		}
+		if (m_pos == NULL) {
+			m_pos = data;
+		}
+		if (m_pos < data + length && decode(m_pos, data + length, m_record)) {
+			break;
+		}
+		// end of the block, or garbage up to it
+		m_block++;
+		m_pos = NULL;
+	}
+
+	Clock.advance(m_record.dt);
+	m_peeked = true;
+	m_replayed++;
+
+	return true;
+}
+
+void TraceModule::apply(const TraceRecord &record) {
+	switch (record.tag) {
+		case TRACE_STATE:
+			Clock.set(record.time);
+			if (record.length >= NVRAM_SIZE) {
+				Thimo.restore(record.state, record.length >= NVRAM_SIZE + sizeof(JournalRecord) ? record.state + NVRAM_SIZE : NULL);
+				m_exact = true;
+			}
+			break;
+		case TRACE_KEY:
+			if (!m_exact) {
+				Clock.set(record.time);
+			}
+			break;
+		case TRACE_SENSOR:
+			if (record.zone < ZONE_COUNT) {
+				Thimo.sample(record.zone, (Sensor::Status)record.value, record.env);
+				if (record.value == Sensor::ERROR_NONE) {
+					Thimo.control(record.zone);
+				}
+			}
+			break;
+		case TRACE_BUTTON:
+			m_button = record.value;
+			Thimo.buttons();
+			m_button = -1;
+			break;
+		case TRACE_CLOCK:
+			Clock.set(Clock.now().unixtime() + record.offset);
+			break;
+		case TRACE_TIMETABLE:
+			Thimo.timetable(record.zone, record.index, record.value);
+			break;
+		case TRACE_MODE:
+			Thimo.manualMode(record.zone, record.value != 0);
+			Thimo.manualSetpoint(record.zone, record.offset);
+			Thimo.controlMode(record.zone, record.index == Controller::PID ? Controller::PID : Controller::HYSTERESIS);
+			break;
+		case TRACE_MODEL:
+			if (record.zone < ZONE_COUNT) {
+				ModelState state;
+				memcpy(&state, record.state, sizeof(state));
+				Thimo.model(record.zone, state);
+			}
+			break;
+		case TRACE_OVERRIDE:
+			if (record.value < OVERRIDE_KINDS) {
+				Override entry;
+				entry.kind = record.value;
+				entry.zones = record.zones;
+				entry.setpoint = record.offset;
+				entry.start = record.time;
+				entry.end = record.until;
+				Thimo.override(entry);
+			}
+			break;
+		case TRACE_RELAY:
+			if (record.zone < ZONE_COUNT && Thimo.relay(record.zone) != (record.value != 0)) {
+				m_relayErrors++;
+			}
+			break;
+		case TRACE_DISPLAY:
+			Thimo.render();
+			if (Thimo.checksum() != record.value) {
+				m_displayErrors++;
+			}
+			break;
+	}
+}
+
+#endif
+
+TraceModule Trace;
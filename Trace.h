@@ -0,0 +1,143 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Trace.h
+ * Created on: 19 Oct 2026
+ * Description: Thimo input trace recorder and replayer
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#ifndef _THIMO_TRACE_H_
+#define _THIMO_TRACE_H_
+
+#include <Arduino.h>
+#include "Sensor.h"
+#include "Journal.h"
+#include "Model.h"
+#include "Override.h"
+#include "config.h"
+
+// Everything the control path and the user interface take from the outside
+// world, with the outputs they produced to check a replay against. A record
+// is a tag, a varint of milliseconds since the previous record and a payload:
+//   STATE    unixtime length state[length]   NVRAM the unit booted from, then its journal
+//   KEY      millis unixtime                 opens every block
+//   SENSOR   zone status [T H]               zigzag hundredths, TRACE_NAN if missing
+//   BUTTON   id                              a debounced press (see Button.h)
+//   CLOCK    seconds                         zigzag RTC offset from the predicted time
+//   TIMETABLE zone hour temperature          set from the console
+//   MODE     zone manual controller setpoint set from the console, zigzag tenths
+//   RELAY    zone state                      output
+//   DISPLAY  checksum                        output, see ThimoClass::checksum()
+//   MODEL    zone state[]                    thermal model restored at boot, raw ModelState
+//   OVERRIDE kind zones setpoint start end   set from the console or restored at boot, end 0 clears
+// Numbers are varints. The clock is predicted from the last KEY or CLOCK
+// record plus the elapsed milliseconds, a CLOCK record is only written
+// when the RTC disagrees.
+#define TRACE_STATE					0x01
+#define TRACE_KEY					0x02
+#define TRACE_SENSOR				0x03
+#define TRACE_BUTTON				0x04
+#define TRACE_CLOCK					0x05
+#define TRACE_RELAY					0x06
+#define TRACE_DISPLAY				0x07
+#define TRACE_TIMETABLE				0x08
+#define TRACE_MODE					0x09
+#define TRACE_MODEL					0x0a
+#define TRACE_OVERRIDE				0x0b
+
+#define TRACE_NAN					-32768
+#define TRACE_MAX_RECORD			(72 + sizeof(JournalRecord))	// a STATE record with the whole NVRAM and the journal
+
+struct TraceRecord {
+	uint8_t tag;
+	uint32_t dt;			// ms since the previous record
+	uint8_t zone;			// SENSOR, RELAY, TIMETABLE, MODE
+	uint16_t zones;			// OVERRIDE
+	uint8_t index;			// TIMETABLE hour, MODE controller
+	uint8_t value;			// SENSOR status, BUTTON id, RELAY state, DISPLAY checksum,
+							// TIMETABLE temperature, MODE manual, OVERRIDE kind
+	uint32_t time;			// STATE and KEY unixtime, OVERRIDE start
+	uint32_t until;			// OVERRIDE end
+	int32_t offset;			// CLOCK, MODE and OVERRIDE setpoint
+	Environment env;		// SENSOR
+	const uint8_t *state;	// STATE, MODEL
+	uint8_t length;
+};
+
+// Records into a ring of self contained blocks, each opened by a KEY record.
+// A replay is exact from a STATE record on, that is for a trace recorded
+// since boot which the ring hasn't wrapped yet.
+class TraceModule {
+public:
+	TraceModule();
+
+	void begin(uint32_t unixtime, const uint8_t *state, uint8_t length);
+	void sensor(uint8_t zone, uint8_t status, const Environment &env);
+	void button(uint8_t id);
+	void clock(uint32_t unixtime);
+	void timetable(uint8_t zone, uint8_t hour, uint8_t temperature);
+	void mode(uint8_t zone, bool manual, uint8_t controller, int16_t setpoint);
+	void model(uint8_t zone, const ModelState &state);
+	void override(const Override &entry);
+	void relay(uint8_t zone, bool state);
+	void display(uint8_t checksum);
+
+	uint8_t blocks() const;
+	const uint8_t *block(uint8_t index, size_t &length) const;
+	size_t bytes() const;
+	inline uint32_t records() const { return m_records; }
+
+	static bool decode(const uint8_t *&pos, const uint8_t *end, TraceRecord &record);
+
+#ifdef THIMO_SIMULATION
+	bool load(uint8_t index, uint16_t offset, const uint8_t *data, size_t n);
+	void replay();
+	bool pressed(uint8_t id);
+
+	inline bool replaying() const { return m_replaying; }
+	inline uint32_t replayed() const { return m_replayed; }
+	inline uint32_t relayErrors() const { return m_relayErrors; }
+	inline uint32_t displayErrors() const { return m_displayErrors; }
+	inline uint32_t replayTime() const { return m_replayTime; }
+	inline bool exact() const { return m_exact; }
+#endif
+private:
+	void put(const uint8_t *record, uint8_t n);
+	void rotate();
+	uint8_t start(uint8_t *record, uint8_t tag);
+	inline uint32_t predicted(unsigned long now) const { return m_unixtime + (now - m_unixMillis) / 1000UL; }
+
+	uint8_t m_data[TRACE_BLOCKS][TRACE_BLOCK_SIZE];
+	uint16_t m_length[TRACE_BLOCKS];
+	uint8_t m_head;
+	uint8_t m_count;
+	bool m_started;
+	unsigned long m_last;		// time of the last record
+	uint32_t m_unixtime;		// clock prediction reference
+	unsigned long m_unixMillis;
+	uint32_t m_records;
+#ifdef THIMO_SIMULATION
+	bool next();
+	void apply(const TraceRecord &record);
+
+	bool m_replaying;
+	bool m_exact;
+	bool m_peeked;
+	TraceRecord m_record;
+	uint8_t m_block;
+	const uint8_t *m_pos;
+	int8_t m_button;			// press handed to ThimoClass::buttons()
+	uint32_t m_replayed;
+	uint32_t m_relayErrors;
+	uint32_t m_displayErrors;
+	uint32_t m_replayTime;
+#endif
+};
+
+extern TraceModule Trace;
+
+#endif
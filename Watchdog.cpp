@@ -0,0 +1,193 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Watchdog.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo stall supervision
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Watchdog.h"
+#include "Log.h"
+#include "Zone.h"
+
+#ifdef ESP32
+#include <esp_system.h>
+#include <esp_task_wdt.h>
+#else
+#define RTC_NOINIT_ATTR
+#endif
+
+#define WATCHDOG_MAGIC				0x7448574dUL
+
+// Survives every reset but a power cycle, magic tells it from power-on noise
+struct WatchdogState {
+	uint32_t magic;
+	uint8_t section;		// live mark
+	uint32_t entered;		// ms, when the section was entered
+	uint8_t lastSection;	// last stall
+	uint32_t lastDuration;
+	uint32_t stalls;
+	bool pending;			// a stall waits to be picked up by the next boot
+};
+
+static RTC_NOINIT_ATTR WatchdogState state;
+
+#define WATCHDOG_BUDGET(section, budget, name)	budget,
+static const uint32_t budgets[WatchdogModule::SECTION_COUNT] = {
+	WATCHDOG_SECTIONS(WATCHDOG_BUDGET)
+};
+#undef WATCHDOG_BUDGET
+
+#define WATCHDOG_NAME(section, budget, name)	name,
+static const char *const names[WatchdogModule::SECTION_COUNT] = {
+	WATCHDOG_SECTIONS(WATCHDOG_NAME)
+};
+#undef WATCHDOG_NAME
+
+#ifdef ESP32
+static void supervise(void *arg) {
+	esp_task_wdt_add(NULL);
+	for (;;) {
+		vTaskDelay(pdMS_TO_TICKS(WATCHDOG_CHECK_TIME));
+		esp_task_wdt_reset();
+		Watchdog.check();
+	}
+}
+#endif
+
+WatchdogModule::WatchdogModule() :
+	m_stalled(false),
+	m_passing(false),
+	m_passStart(0UL),
+	m_passes(0),
+	m_passTime(0),
+	m_passMax(0) {
+}
+
+// First thing in setup(): picks up what the last reset left in RTC memory
+// before any section mark overwrites it
+void WatchdogModule::begin() {
+	bool cold = state.magic != WATCHDOG_MAGIC;
+
+#ifdef ESP32
+	esp_reset_reason_t reason = esp_reset_reason();
+	cold = cold || reason == ESP_RST_POWERON || reason == ESP_RST_BROWNOUT;
+	if (!cold && !state.pending && state.section < SECTION_COUNT &&
+		(reason == ESP_RST_TASK_WDT || reason == ESP_RST_INT_WDT || reason == ESP_RST_WDT || reason == ESP_RST_PANIC)) {
+		// the supervisor didn't get to it, blame the section marked at the time
+		state.lastSection = state.section;
+		state.lastDuration = 0;
+		state.stalls++;
+		state.pending = true;
+	}
+#endif
+	if (cold) {
+		state.magic = WATCHDOG_MAGIC;
+		state.lastSection = SECTION_COUNT;
+		state.lastDuration = 0;
+		state.stalls = 0;
+		state.pending = false;
+	}
+
+	m_stalled = state.pending;
+	state.pending = false;
+	enter(SECTION_BOOT);
+
+#ifdef ESP32
+	xTaskCreatePinnedToCore(supervise, "watchdog", 2048, NULL, configMAX_PRIORITIES - 1, NULL, 0);
+#endif
+}
+
+// Once the log is up
+void WatchdogModule::report() {
+	if (m_stalled) {
+		LOG_ERROR(LOG_STALL, state.lastSection, state.lastDuration);
+	}
+}
+
+void WatchdogModule::feed() {
+	pass();
+	enter(SECTION_LOOP);
+	m_passStart = micros();
+	m_passing = true;
+}
+
+// Returns the section left, to return to it
+WatchdogModule::Section WatchdogModule::enter(Section section) {
+	Section previous = (Section)state.section;
+
+	if (section == SECTION_SLEEP) {
+		pass();
+	}
+
+	// the supervisor reads the section first: a new section comes with its time
+	state.entered = millis();
+	__atomic_store_n(&state.section, (uint8_t)section, __ATOMIC_RELEASE);
+
+	return previous;
+}
+
+void WatchdogModule::kick() {
+	state.entered = millis();
+}
+
+// Supervisor side
+void WatchdogModule::check() {
+	uint8_t section = __atomic_load_n(&state.section, __ATOMIC_ACQUIRE);
+	uint32_t elapsed = millis() - state.entered;
+
+	if (section >= SECTION_COUNT || elapsed <= budgets[section]) {
+		return;
+	}
+
+	for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+		digitalWrite(zoneConfig[z].relayPin, LOW);
+	}
+	state.lastSection = section;
+	state.lastDuration = elapsed;
+	state.stalls++;
+	state.pending = true;
+#ifdef ESP32
+	esp_restart();
+#endif
+}
+
+// The pass in progress is over
+void WatchdogModule::pass() {
+	if (!m_passing) {
+		return;
+	}
+	uint32_t elapsed = micros() - m_passStart;
+	m_passing = false;
+	m_passes++;
+	m_passTime += elapsed;
+	if (elapsed > m_passMax) {
+		m_passMax = elapsed;
+	}
+}
+
+const char *WatchdogModule::name(uint8_t section) {
+	return section < SECTION_COUNT ? names[section] : "none";
+}
+
+uint8_t WatchdogModule::stalledSection() const {
+	return state.lastSection;
+}
+
+uint32_t WatchdogModule::stalledFor() const {
+	return state.lastDuration;
+}
+
+uint32_t WatchdogModule::stalls() const {
+	return state.stalls;
+}
+
+WatchdogModule::Section WatchdogModule::section() const {
+	return (Section)state.section;
+}
+
+WatchdogModule Watchdog;
@@ -0,0 +1,89 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Watchdog.h
+ * Created on: 19 Oct 2026
+ * Description: Thimo stall supervision
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#ifndef _THIMO_WATCHDOG_H_
+#define _THIMO_WATCHDOG_H_
+
+#include <Arduino.h>
+#include "config.h"
+
+// one X(section, time budget in ms, name) per supervised part of the loop
+#define WATCHDOG_SECTIONS(X) \
+	X(SECTION_BOOT,			WATCHDOG_STALL_TIME,	"boot") \
+	X(SECTION_LOOP,			WATCHDOG_STALL_TIME,	"loop") \
+	X(SECTION_SENSOR,		WATCHDOG_STALL_TIME,	"sensor") \
+	X(SECTION_CONTROL,		WATCHDOG_STALL_TIME,	"control") \
+	X(SECTION_DISPLAY,		WATCHDOG_STALL_TIME,	"display") \
+	X(SECTION_EDITOR,		WATCHDOG_EDIT_TIME,		"editor") \
+	X(SECTION_RTC,			WATCHDOG_STALL_TIME,	"rtc") \
+	X(SECTION_CONSOLE,		WATCHDOG_STALL_TIME,	"console") \
+	X(SECTION_HTTP,			WATCHDOG_STALL_TIME,	"http") \
+	X(SECTION_NTP,			WATCHDOG_STALL_TIME,	"ntp") \
+	X(SECTION_LOG,			WATCHDOG_STALL_TIME,	"log") \
+	X(SECTION_SLEEP,		WATCHDOG_STALL_TIME,	"sleep") \
+	X(SECTION_SIMULATION,	WATCHDOG_STALL_TIME,	"simulation")
+
+// The loop marks the section it's in, the mark lives in RTC memory that a
+// reset leaves alone. A supervisor task on the other core checks the mark
+// every WATCHDOG_CHECK_TIME: when a section overruns its budget it records
+// the stall, switches the relays off and restarts. The task watchdog keeps
+// an eye on the supervisor, and a reset by it, by the interrupt watchdog or
+// by a panic is attributed to the section marked at the time.
+//
+// A section's clock starts when it's entered or returned to, kick() restarts
+// it for long work that is making progress.
+//
+// A loop pass runs from feed() to the sleep section or the next feed(), the
+// time it kept the CPU busy is summed up and the longest one kept.
+class WatchdogModule {
+public:
+#define WATCHDOG_SECTION(section, budget, name)	section,
+	typedef enum {
+		WATCHDOG_SECTIONS(WATCHDOG_SECTION)
+		SECTION_COUNT
+	} Section;
+#undef WATCHDOG_SECTION
+
+	WatchdogModule();
+
+	void begin();
+	void report();
+	void feed();
+	Section enter(Section section);
+	void kick();
+	void check();
+
+	static const char *name(uint8_t section);
+
+	inline bool stalled() const { return m_stalled; }	// the last reset was a stall
+	uint8_t stalledSection() const;
+	uint32_t stalledFor() const;	// ms the section had run, 0 after a hardware watchdog reset
+	uint32_t stalls() const;		// since power-on
+	Section section() const;
+
+	inline uint32_t passes() const { return m_passes; }
+	inline uint32_t passTime() const { return (uint32_t)(m_passTime / 1000ULL); }	// ms
+	inline uint32_t passMax() const { return m_passMax; }	// us
+private:
+	bool m_stalled;
+	bool m_passing;
+	unsigned long m_passStart;
+	uint32_t m_passes;
+	uint64_t m_passTime;		// us
+	uint32_t m_passMax;
+
+	void pass();
+};
+
+extern WatchdogModule Watchdog;
+
+#endif
@@ -0,0 +1,92 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Window.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo open window detection
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Window.h"
+
+#define WINDOW_SK					((int32_t)WINDOW_SAMPLES * (WINDOW_SAMPLES - 1) / 2)
+#define WINDOW_SKK					((int32_t)(WINDOW_SAMPLES - 1) * WINDOW_SAMPLES * (2 * WINDOW_SAMPLES - 1) / 6)
+
+WindowDetector::WindowDetector() {
+	reset();
+}
+
+void WindowDetector::reset() {
+	m_head = 0;
+	m_count = 0;
+	m_sum = 0;
+	m_weighted = 0;
+	m_open = false;
+	m_opened = 0UL;
+	m_detections = 0;
+}
+
+// Takes a sample in tenths of °C, true when the window state changed
+bool WindowDetector::update(int16_t temperature, unsigned long now, float idle) {
+	bool open = m_open;
+
+	if (m_count > 0) {
+		unsigned long elapsed = now - m_times[(m_head + WINDOW_SAMPLES - 1) % WINDOW_SAMPLES];
+		if (elapsed < WINDOW_INTERVAL) {
+			return false;
+		}
+		if (elapsed > WINDOW_INTERVAL * WINDOW_SAMPLES) {
+			// samples went missing, start over
+			m_head = 0;
+			m_count = 0;
+			m_sum = 0;
+			m_weighted = 0;
+		}
+	}
+
+	if (m_count < WINDOW_SAMPLES) {
+		m_weighted += (int32_t)m_count * temperature;
+		m_sum += temperature;
+		m_count++;
+	} else {
+		// every sample moves one place down, the oldest leaves
+		int16_t oldest = m_samples[m_head];
+		m_weighted += (int32_t)(WINDOW_SAMPLES - 1) * temperature - (m_sum - oldest);
+		m_sum += temperature - oldest;
+	}
+	m_samples[m_head] = temperature;
+	m_times[m_head] = now;
+	m_head = (m_head + 1) % WINDOW_SAMPLES;
+
+	float rate = slope();
+	float drop = fminf(-WINDOW_DROP, idle - WINDOW_MARGIN);
+	bool full = m_count == WINDOW_SAMPLES;
+
+	if (m_open) {
+		if (now - m_opened >= WINDOW_SUSPEND || (full && rate > drop + WINDOW_DROP - WINDOW_RECOVER)) {
+			m_open = false;
+		}
+	} else if (full && rate <= drop) {
+		m_open = true;
+		m_opened = now;
+		m_detections++;
+	}
+
+	return m_open != open;
+}
+
+// °C/h over the window, 0 until it's full
+float WindowDetector::slope() const {
+	if (m_count < WINDOW_SAMPLES) {
+		return 0.0f;
+	}
+
+	// the ring is full, the head is the oldest sample
+	unsigned long span = m_times[(m_head + WINDOW_SAMPLES - 1) % WINDOW_SAMPLES] - m_times[m_head];
+	float perSample = (float)(WINDOW_SAMPLES * m_weighted - WINDOW_SK * m_sum) / (WINDOW_SAMPLES * WINDOW_SKK - WINDOW_SK * WINDOW_SK);
+
+	return span > 0 ? perSample * (WINDOW_SAMPLES - 1) * 360000.0f / span : 0.0f;
+}
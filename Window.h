@@ -0,0 +1,53 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Window.h
+ * Created on: 19 Oct 2026
+ * Description: Thimo open window detection
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#ifndef _THIMO_WINDOW_H_
+#define _THIMO_WINDOW_H_
+
+#include <Arduino.h>
+#include "config.h"
+
+// Least squares slope of the last WINDOW_SAMPLES temperatures, taken at
+// least WINDOW_INTERVAL apart. The sums of y and of k * y, k the position
+// in the window, are moved along with each sample, so the slope costs the
+// same whatever the window length:
+//   slope = (N * Sky - Sk * Sy) / (N * Skk - Sk * Sk)
+// A drop faster than WINDOW_DROP means an open window: heating stays off
+// for WINDOW_SUSPEND, or until the drop slows below WINDOW_RECOVER. A
+// small room can lose more than that after every heating cycle, so the
+// drop also has to be WINDOW_MARGIN faster than the room cools with the
+// heater off, as the zone's thermal model predicts it; the recovery
+// moves along. Until the model is ready the room is taken to hold its
+// temperature.
+class WindowDetector {
+public:
+	WindowDetector();
+
+	void reset();
+	bool update(int16_t temperature, unsigned long now, float idle = 0.0f);	// idle: °C/h with the heater off, <= 0
+
+	inline bool open() const { return m_open; }
+	inline uint32_t detections() const { return m_detections; }
+	float slope() const;
+private:
+	int16_t m_samples[WINDOW_SAMPLES];	// tenths of °C, a ring
+	unsigned long m_times[WINDOW_SAMPLES];
+	uint8_t m_head;						// oldest once full, next free before
+	uint8_t m_count;
+	int32_t m_sum;						// Sy
+	int32_t m_weighted;					// Sky, oldest at k = 0
+	bool m_open;
+	unsigned long m_opened;
+	uint32_t m_detections;
+};
+
+#endif
@@ -0,0 +1,42 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Zone.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo heating zones
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Zone.h"
+
+#include "DHT.h"
+#include "SHT3x.h"
+
+// One driver per sensor, shared by zones naming the same pin or address.
+// DHT drivers are specialized on their pin at compile time.
+template<uint8_t PIN>
+struct ZoneDHT {
+	static typename DHTDriver<DHTBase::DHT_MODEL, PIN>::Type sensor;
+};
+
+template<uint8_t PIN>
+typename DHTDriver<DHTBase::DHT_MODEL, PIN>::Type ZoneDHT<PIN>::sensor;
+
+template<uint8_t ADDR>
+struct ZoneSHT3x {
+	static SHT3xSensor sensor;
+};
+
+template<uint8_t ADDR>
+SHT3xSensor ZoneSHT3x<ADDR>::sensor(ADDR);
+
+#define ZONE_DHT(pin)				&ZoneDHT<pin>::sensor
+#define ZONE_SHT3X(addr)			&ZoneSHT3x<addr>::sensor
+#define ZONE_CONFIG(sensor, relay)	{ sensor, relay },
+
+const ZoneConfig zoneConfig[ZONE_COUNT] = {
+	ZONES(ZONE_CONFIG)
+};
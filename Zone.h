@@ -0,0 +1,57 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Zone.h
+ * Created on: 19 Oct 2026
+ * Description: Thimo heating zones
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#ifndef _THIMO_ZONE_H_
+#define _THIMO_ZONE_H_
+
+#include <Arduino.h>
+#include "Sensor.h"
+#include "Control.h"
+#include "Model.h"
+#include "Window.h"
+#include "config.h"
+
+#define ZONE_COUNT_ONE(sensor, relay)	+1
+
+enum {
+	ZONE_COUNT = 0 ZONES(ZONE_COUNT_ONE)
+};
+
+// Everything the control pass needs about a room, zones are kept in one array
+struct Zone {
+	Sensor *sensor;
+	Controller controller;
+	ThermalModel model;
+	WindowDetector window;
+	uint8_t relayPin;
+	bool sampled;			// a valid reading arrived since boot
+	bool humid;				// one with the humidity in it
+	bool failed;			// the last capture was an error, the readings are stale
+	bool relay;
+	bool manualMode;
+	int8_t trend;
+	int16_t manualSetpoint;	// tenths of °C
+	uint8_t timetable[24];
+	float temperature;
+	float humidity;
+	float trendTemperature;
+	unsigned long trendTimer;
+};
+
+struct ZoneConfig {
+	Sensor *sensor;
+	uint8_t relayPin;
+};
+
+extern const ZoneConfig zoneConfig[ZONE_COUNT];
+
+#endif
@@ -13,15 +13,179 @@
 #ifndef _THIMO_CONFIG_H_
 #define _THIMO_CONFIG_H_
 
+//#define I2C_FAST_MODE						// 400 kHz for backpacks that take it, the PCF8574 is rated for 100 kHz
+#ifdef I2C_FAST_MODE
+#define I2C_CLOCK					400000UL	// Fast-mode for the LCD backpack
+#else
+#define I2C_CLOCK					100000UL	// Standard-mode, within every device's rating
+#endif
+#define RTC_I2C_CLOCK				100000UL	// DS1307 is Standard-mode only
+
 #define LCD_I2C_ADDRESS				0x27
+//#define LCD_PARALLEL						// direct 4-bit wiring instead of I2C
+#define LCD_ASYNC							// ESP32: display frames go out from a background task
+#define LCD_RS_PIN					16
+#define LCD_EN_PIN					17
+#define LCD_D4_PIN					18
+#define LCD_D5_PIN					19
+#define LCD_D6_PIN					32
+#define LCD_D7_PIN					33
+#define LCD_BL_PIN					4
 #define LCD_BACKLIGHT_DURATION		10000UL	// turn off backlight after 10"
 #define LCD_REFRESH_TIME			1000UL	// refresh display every 1"
+#define EDIT_TIMEOUT				60000UL	// ms without a press that abandons an edit
+#define TREND_PERIOD				600000UL	// temperature trend over 10'
+#define TREND_THRESHOLD				0.2f	// °C, smaller changes are steady
 
 #define DHT_PIN						23
+#define DHT_MODEL					DHT22	// DHT11, DHT22, AM2302, RHT03 or AUTO_DETECT
 #define RELAY_PIN					2
 
+// one X(sensor, relay pin) per zone, up to 16. A sensor is ZONE_DHT(pin)
+// for a DHT_MODEL sensor or ZONE_SHT3X(I2C address) on the Wire bus. A
+// build may give its own list before this file
+#ifndef ZONES
+#define ZONES(X) \
+	X(ZONE_DHT(DHT_PIN), RELAY_PIN)
+#endif
+#define SENSOR_BOOT_WAIT			40UL	// ms, at most, for the first conversions at boot
+
+#define CONTROL_MODE				Controller::HYSTERESIS	// or Controller::PID
+#define CONTROL_HYSTERESIS			3		// tenths of °C each side of the setpoint
+#define CONTROL_MIN_ON				120000UL	// ms, shortest burner run
+#define CONTROL_MIN_OFF				120000UL	// ms, shortest pause
+#define CONTROL_WINDOW				900000UL	// ms, PID time-proportioning window
+#define CONTROL_KP					800		// PID gains: duty per mille per °C of error,
+#define CONTROL_KI					400		// per °C and hour of error,
+#define CONTROL_KD					0		// per °C/h of temperature rise (see host/tuning.cpp)
+
+//#define THIMO_SIMULATION					// zones read simulated rooms, console "sim" runs them
+#define SIM_EPOCH					1609459200UL	// 1 Jan 2021 00:00, every run starts here
+#define SIM_STEP					60000UL	// ms of virtual time per step and sensor reading
+#define SIM_SEED					0x2545f491UL	// sensor noise sequence
+#define SIM_START_TEMPERATURE		15.0f	// °C, rooms at the start of a run
+#define SIM_HEATER_POWER			2000.0f	// W per zone
+#define SIM_LOSS					80.0f	// W/K through walls and ventilation
+#define SIM_CAPACITY				3.0e6f	// J/K, air, furniture and inner walls
+#define SIM_SENSOR_LAG				300.0f	// s, sensor time constant
+#define SIM_SENSOR_NOISE			0.1f	// °C peak
+#define SIM_HUMIDITY				50.0f	// %RH, constant
+#define SIM_OUTDOOR_MEAN			10.0f	// °C, yearly mean
+#define SIM_OUTDOOR_YEAR			10.0f	// °C, seasonal amplitude
+#define SIM_OUTDOOR_DAY				4.0f	// °C, day/night amplitude
+#define SIM_WINDOW_SEED				0x6b8b4567UL	// window openings sequence
+#define SIM_WINDOW_PER_DAY			2.0f	// openings a day, when it's SIM_WINDOW_DELTA colder outside
+#define SIM_WINDOW_DELTA			8.0f	// K, warmer outside nobody airs the room
+#define SIM_WINDOW_TIME				900000UL	// ms a window stays open
+#define SIM_WINDOW_LOSS				400.0f	// W/K on top of SIM_LOSS while it is
+#define SIM_WINDOW_GRACE			600000UL	// ms after closing a detection still counts
+
 #define BUTTON_S_PIN				26
 #define BUTTON_N_PIN				27
 #define BUTTON_P_PIN				25
 
+#define LOG_LEVEL					LOG_LEVEL_INFO	// messages above this level are compiled out
+#ifndef LOG_TOKENIZED
+#define LOG_TOKENIZED				1		// 1: binary records, 0: plain text lines
+#endif
+#define LOG_QUEUE_SIZE				32		// pending messages, must be a power of two
+
+#define CONSOLE_LINE_SIZE			64		// longest text command
+#define CONSOLE_FRAME_SIZE			64		// longest encoded binary request
+#define CONSOLE_OUT_SIZE			256		// pending response bytes
+#define CONSOLE_POLL_BYTES			32		// input bytes parsed per loop
+
+#define HISTORY_BLOCK_SIZE			256		// bytes per encoded history block
+#define HISTORY_BLOCKS				16		// blocks kept in RAM (oldest overwritten)
+#define HISTORY_PERIOD				2		// nominal seconds between samples
+
+#define TRACE_BLOCK_SIZE			256		// bytes per input trace block
+#define TRACE_BLOCKS				8		// blocks kept in RAM (oldest overwritten)
+
+#define POWER_SLEEP					0		// 1: light sleep between scheduled tasks (ESP32), not while on Wi-Fi
+#define POWER_MIN_SLEEP				5		// ms, shorter idle times are spent awake
+#define POWER_SERIAL_AWAKE			10000UL	// ms awake after serial input
+#define POWER_GOVERNOR				1		// 1: CPU frequency follows the workload (ESP32)
+#define POWER_IDLE_MHZ				80		// 80, 160 or 240
+#define POWER_BURST_MHZ				240		// redraws, dumps, network exchanges
+#define POWER_BOOST_HOLD			200UL	// ms at the burst frequency after the work
+#define POWER_VOLTAGE				3.3f	// V, supply for the energy estimate
+#define POWER_CURRENT_80			31.0f	// mA at 80 MHz (datasheet, radio off)
+#define POWER_CURRENT_160			44.0f	// mA at 160 MHz
+#define POWER_CURRENT_240			68.0f	// mA at 240 MHz
+#define POWER_CURRENT_SLEEP			0.8f	// mA in light sleep
+
+#define WATCHDOG_STALL_TIME			5000UL	// ms a section may run before it's a stall
+#define WATCHDOG_EDIT_TIME			120000UL	// ms between presses in the blocking editors
+#define WATCHDOG_CHECK_TIME			100UL	// ms between supervisor checks
+
+#define JOURNAL_COALESCE			1000UL	// ms, the changes within are written together
+#define JOURNAL_REFRESH				300UL	// s, an unchanged temperature is stamped again
+#define JOURNAL_MAX_AGE				900UL	// s, an older journaled temperature isn't resumed from
+
+#define MODEL_PERIOD				600000UL	// ms, window a heating rate is measured over
+#define MODEL_FORGET				0.998f	// RLS forgetting factor, about 500 windows of memory
+#define MODEL_P_INITIAL				1000.0f	// initial covariance, nothing known
+#define MODEL_P_RESTORED			10.0f	// covariance of a model restored at boot
+#define MODEL_MIN_UPDATES			36		// windows before the model is trusted
+#define MODEL_ERROR_WINDOW			144		// windows the prediction error is averaged over
+#define MODEL_MAX_LEAD				3		// h, heating starts at most this early
+#define MODEL_SAVE_TIME				21600000UL	// ms between saves of the models to flash
+
+#define WINDOW_SAMPLES				10		// samples the temperature slope is taken over
+#define WINDOW_INTERVAL				30000UL	// ms, at least between two of them
+#define WINDOW_DROP					4.0f	// °C/h, a faster drop is an open window
+#define WINDOW_RECOVER				3.0f	// °C/h, heating resumes once the drop is slower
+#define WINDOW_MARGIN				1.0f	// °C/h, a drop has to be faster than the room cools with the heater off by
+#define WINDOW_SUSPEND				1800000UL	// ms heating stays off at most
+
+#define METER_POWER					24000.0f	// W, burner output of a zone for the energy figures
+#define METER_SHORT_RUN				300000UL	// ms, a shorter burner run counts as a short cycle
+#define METER_SAVE_TIME				3600000UL	// ms between saves of the relay counters to flash
+
+#define WIFI_SSID					""		// empty: no Wi-Fi, no HTTP server
+#define WIFI_PASSWORD				""
+#define HTTP_PORT					80
+#define HTTP_HOST_PORT				8080	// the server on a Linux host build
+#define HTTP_CONNECTIONS			4		// requests read at once
+#define HTTP_LINE_SIZE				128		// longest request or header line kept
+#define HTTP_BODY_SIZE				128		// longest request body
+#define HTTP_RESPONSE_BASE			2048	// headers and the body without the zones, /metrics is the largest
+#define HTTP_RESPONSE_ZONE			400		// and each zone's part of it (see Http.cpp)
+#define HTTP_POLL_BYTES				512		// request bytes per connection, response bytes, per loop
+#define HTTP_TIMEOUT				2000UL	// ms a client has to send its request
+
+#define TIME_ZONE					60		// minutes east of UTC, standard time
+#define TIME_DST					60		// minutes ahead in summer, 0: no daylight saving
+#define TIME_DST_START_MONTH		3		// summer starts on a Sunday of March,
+#define TIME_DST_START_WEEK			5		// the 1st to 4th, 5: the last one,
+#define TIME_DST_START_HOUR			2		// at this local standard time
+#define TIME_DST_END_MONTH			10		// and ends on the last Sunday of October
+#define TIME_DST_END_WEEK			5
+#define TIME_DST_END_HOUR			3		// at this local summer time
+#define TIME_FIRST_YEAR				2020	// the transitions are precomputed
+#define TIME_YEARS					64		// for this many years, standard time after
+#define CLOCK_RTC_PERIOD			7200000UL	// ms, without a time server the RTC is read again after
+#define CLOCK_RTC_LIMIT				60		// s, a larger RTC error is set right
+#define CLOCK_DRIFT_SPAN			86400UL	// s the RTC runs from an exact setting before its drift is measured
+#define CLOCK_DRIFT_LIMIT			1000.0f	// ppm, no RTC drifts more
+
+#define NTP_SERVER					"pool.ntp.org"
+#define NTP_PORT					123
+#define NTP_HOST_PORT				12300	// the time server of a Linux host build, on the loopback
+#define NTP_PERIOD					3600000UL	// ms between time syncs
+#define NTP_RETRY					60000UL	// ms, after a failed one
+#define NTP_TIMEOUT					2000UL	// ms to wait for the reply
+#define NTP_MAX_DELAY				500UL	// ms, replies that took longer are not trusted
+
+#define MANUAL_TEMPERATURE			20		// °C, manual mode setpoint until one is set
+#define OVERRIDE_SLOTS				8		// overrides set at once, expired ones free theirs
+#define OVERRIDE_BOOST_TIME			3600UL	// s a boost lasts
+#define OVERRIDE_BOOST_TEMPERATURE	22		// °C
+#define OVERRIDE_AWAY_TEMPERATURE	15		// °C
+#define OVERRIDE_HOLIDAY_TEMPERATURE	7		// °C, frost protection
+
+#define BENCH_RUNS					5		// timed runs per benchmark, the fastest counts
+#define BENCH_TOLERANCE				10		// %, slower than the baseline by more is a regression
+
 #endif
@@ -0,0 +1,58 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Devices.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo host build, models of the devices on the board
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Devices.h"
+
+DHTDevice::DHTDevice() {
+	set(20.0f, 50.0f);
+}
+
+void DHTDevice::set(float temperature, float humidity) {
+	int16_t t = (int16_t)lroundf(temperature * 10.0f);
+	uint16_t h = (uint16_t)lroundf(humidity * 10.0f);
+	uint16_t raw = t < 0 ? (uint16_t)(-t) | 0x8000 : (uint16_t)t;
+
+	m_data[0] = h >> 8;
+	m_data[1] = h;
+	m_data[2] = raw >> 8;
+	m_data[3] = raw;
+	m_data[4] = m_data[0] + m_data[1] + m_data[2] + m_data[3];
+}
+
+int DHTDevice::level(unsigned long us) {
+	if (us < 20) {
+		return HIGH;
+	}
+	if (us < 100) {
+		return LOW;
+	}
+	if (us < 180) {
+		return HIGH;
+	}
+	us -= 180;
+
+	for (uint8_t bit = 0; bit < 40; bit++) {
+		unsigned long high = (m_data[bit / 8] >> (7 - bit % 8)) & 1 ? 70 : 26;
+
+		if (us < 50) {
+			return LOW;
+		}
+		us -= 50;
+		if (us < high) {
+			return HIGH;
+		}
+		us -= high;
+	}
+
+	// the last bit ends low, then the line is released
+	return us < 50 ? LOW : HIGH;
+}
@@ -0,0 +1,33 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Devices.h
+ * Created on: 19 Oct 2026
+ * Description: Thimo host build, models of the devices on the board
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#ifndef _THIMO_HOST_DEVICES_H_
+#define _THIMO_HOST_DEVICES_H_
+
+#include "Host.h"
+
+// DHT22 on a pin (see hostAttach()): once the start signal is released it
+// answers with the datasheet waveform, 20us high, 80us low, 80us high,
+// then 40 bits of 50us low and 26us (0) or 70us (1) high, humidity and
+// temperature in tenths and a checksum.
+class DHTDevice : public PinDevice {
+public:
+	DHTDevice();
+
+	void set(float temperature, float humidity);
+
+	virtual int level(unsigned long us);
+private:
+	uint8_t m_data[5];
+};
+
+#endif
@@ -0,0 +1,509 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Host.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo host build, the Arduino API on Linux
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Host.h"
+#include <poll.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+
+#define HOST_PINS					64
+#define HOST_PRESSES				64
+#define HOST_NVRAM					56
+
+static bool virtualTime = false;
+static uint64_t virtualMicros = 0;
+
+static uint8_t pins[HOST_PINS];
+static bool outputs[HOST_PINS];
+static PinDevice *devices[HOST_PINS];
+static uint64_t released[HOST_PINS];	// when the pin last turned into an input
+
+static uint8_t presses[HOST_PRESSES];
+static uint8_t pressHead = 0;
+static uint8_t pressCount = 0;
+
+static double rtcSeconds = 0.0;		// UTC at rtcMicros
+static uint64_t rtcMicros = 0;
+static double rtcRate = 1.0;
+static bool rtcSet = false;
+static uint32_t rtcWrites = 0;
+static uint8_t nvram[HOST_NVRAM];
+static bool quiet = false;
+
+uint64_t hostMicros() {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (uint64_t)now.tv_sec * 1000000ULL + now.tv_nsec / 1000;
+}
+
+// Whenever the first global constructor asks for it
+static uint64_t realStart() {
+	static uint64_t start = hostMicros();
+
+	return start;
+}
+
+// The time the firmware runs on, without moving it. The start is taken
+// first, on the first call it must not come after the time it's taken from.
+static uint64_t elapsed() {
+	uint64_t start = realStart();
+
+	return virtualTime ? virtualMicros : hostMicros() - start;
+}
+
+void hostVirtualTime() {
+	virtualMicros = elapsed();
+	virtualTime = true;
+}
+
+void hostAdvance(unsigned long us) {
+	virtualMicros += us;
+}
+
+static double rtcNow() {
+	if (!rtcSet) {
+		rtcSeconds = (double)time(NULL);
+		rtcMicros = elapsed();
+		rtcSet = true;
+	}
+
+	return rtcSeconds + (double)(elapsed() - rtcMicros) * 1e-6 * rtcRate;
+}
+
+void hostRtcDrift(float ppm) {
+	rtcSeconds = rtcNow();
+	rtcMicros = elapsed();
+	rtcRate = 1.0 + ppm * 1e-6;
+}
+
+uint32_t hostRtcWrites() {
+	return rtcWrites;
+}
+
+void hostAttach(uint8_t pin, PinDevice *device) {
+	if (pin < HOST_PINS) {
+		devices[pin] = device;
+	}
+}
+
+void hostPress(uint8_t pin) {
+	if (pressCount < HOST_PRESSES) {
+		presses[(pressHead + pressCount++) % HOST_PRESSES] = pin;
+	}
+}
+
+void hostQuiet() {
+	quiet = true;
+}
+
+unsigned long millis() {
+	return micros() / 1000UL;
+}
+
+unsigned long micros() {
+	if (virtualTime) {
+		return ++virtualMicros;
+	}
+
+	return elapsed();
+}
+
+void delay(unsigned long ms) {
+	delayMicroseconds(ms * 1000UL);
+}
+
+void delayMicroseconds(unsigned int us) {
+	if (virtualTime) {
+		virtualMicros += us;
+		return;
+	}
+
+	struct timespec wait = { (time_t)(us / 1000000U), (long)(us % 1000000U) * 1000L };
+	nanosleep(&wait, NULL);
+}
+
+void yield() {
+	sched_yield();
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+	if (pin >= HOST_PINS) {
+		return;
+	}
+	if (outputs[pin] && mode != OUTPUT) {
+		released[pin] = elapsed();
+	}
+	outputs[pin] = mode == OUTPUT;
+	if (mode == INPUT_PULLUP) {
+		pins[pin] = HIGH;
+	}
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+	if (pin < HOST_PINS) {
+		pins[pin] = value ? HIGH : LOW;
+	}
+}
+
+int digitalRead(uint8_t pin) {
+	if (pin >= HOST_PINS) {
+		return LOW;
+	}
+	if (devices[pin] != NULL && !outputs[pin]) {
+		return devices[pin]->level(elapsed() - released[pin]);
+	}
+
+	return pins[pin];
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+	size_t n = 0;
+
+	while (size--) {
+		n += write(*buffer++);
+	}
+
+	return n;
+}
+
+size_t Print::print(const char *s) {
+	return write(s);
+}
+
+size_t Print::print(char c) {
+	return write((uint8_t)c);
+}
+
+size_t Print::print(unsigned char n, int base) {
+	return number(n, base);
+}
+
+size_t Print::print(int n, int base) {
+	return print((long)n, base);
+}
+
+size_t Print::print(unsigned int n, int base) {
+	return number(n, base);
+}
+
+size_t Print::print(long n, int base) {
+	if (n < 0 && base == DEC) {
+		return print('-') + number(-(unsigned long)n, base);
+	}
+
+	return number(n, base);
+}
+
+size_t Print::print(unsigned long n, int base) {
+	return number(n, base);
+}
+
+size_t Print::print(double n, int digits) {
+	char text[48];
+
+	snprintf(text, sizeof(text), "%.*f", digits, n);
+
+	return write(text);
+}
+
+size_t Print::println() {
+	return write("\r\n");
+}
+
+size_t Print::println(const char *s) {
+	return print(s) + println();
+}
+
+size_t Print::println(int n, int base) {
+	return print(n, base) + println();
+}
+
+size_t Print::println(unsigned int n, int base) {
+	return print(n, base) + println();
+}
+
+size_t Print::println(long n, int base) {
+	return print(n, base) + println();
+}
+
+size_t Print::println(unsigned long n, int base) {
+	return print(n, base) + println();
+}
+
+size_t Print::println(double n, int digits) {
+	return print(n, digits) + println();
+}
+
+size_t Print::number(unsigned long n, int base) {
+	char text[24];
+
+	snprintf(text, sizeof(text), base == HEX ? "%lX" : "%lu", n);
+
+	return write(text);
+}
+
+HardwareSerial::HardwareSerial() :
+	m_inPos(0),
+	m_inLength(0),
+	m_closed(false) {
+}
+
+void HardwareSerial::begin(unsigned long baud) {
+}
+
+int HardwareSerial::available() {
+	struct pollfd input = { STDIN_FILENO, POLLIN, 0 };
+
+	if (m_inPos == m_inLength && !m_closed && poll(&input, 1, 0) > 0) {
+		ssize_t n = ::read(STDIN_FILENO, m_in, sizeof(m_in));
+		m_inPos = 0;
+		m_inLength = n > 0 ? n : 0;
+		m_closed = n <= 0;
+	}
+
+	return m_inLength - m_inPos;
+}
+
+int HardwareSerial::read() {
+	return available() > 0 ? m_in[m_inPos++] : -1;
+}
+
+int HardwareSerial::peek() {
+	return available() > 0 ? m_in[m_inPos] : -1;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+	return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+	return quiet ? size : fwrite(buffer, 1, size, stdout);
+}
+
+int HardwareSerial::availableForWrite() {
+	return BUFSIZ;
+}
+
+HardwareSerial Serial;
+
+TwoWire::TwoWire() :
+	m_clock(100000UL),
+	m_address(0),
+	m_txLength(0),
+	m_rxPos(0),
+	m_rxLength(0) {
+	pthread_mutex_init(&m_lock, NULL);
+	memset(m_devices, 0, sizeof(m_devices));
+}
+
+void TwoWire::begin() {
+}
+
+void TwoWire::setClock(uint32_t frequency) {
+	m_clock = frequency;
+}
+
+void TwoWire::attach(uint8_t address, WireDevice *device) {
+	m_devices[address % I2C_DEVICES] = device;
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+	pthread_mutex_lock(&m_lock);
+	m_address = address % I2C_DEVICES;
+	m_txLength = 0;
+}
+
+// 0 sent, 2 NACK on the address
+uint8_t TwoWire::endTransmission(bool stop) {
+	WireDevice *device = m_devices[m_address];
+
+	if (device != NULL) {
+		device->write(m_tx, m_txLength);
+	}
+	pthread_mutex_unlock(&m_lock);
+
+	return device != NULL ? 0 : 2;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity) {
+	WireDevice *device = m_devices[address % I2C_DEVICES];
+
+	pthread_mutex_lock(&m_lock);
+	m_rxPos = 0;
+	m_rxLength = 0;
+	if (device != NULL) {
+		m_rxLength = device->read(m_rx, quantity < sizeof(m_rx) ? quantity : sizeof(m_rx));
+	}
+	pthread_mutex_unlock(&m_lock);
+
+	return m_rxLength;
+}
+
+size_t TwoWire::write(uint8_t c) {
+	return write(&c, 1);
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t n) {
+	if (n > sizeof(m_tx) - m_txLength) {
+		n = sizeof(m_tx) - m_txLength;
+	}
+	memcpy(m_tx + m_txLength, data, n);
+	m_txLength += n;
+
+	return n;
+}
+
+int TwoWire::available() {
+	return m_rxLength - m_rxPos;
+}
+
+int TwoWire::read() {
+	return m_rxPos < m_rxLength ? m_rx[m_rxPos++] : -1;
+}
+
+int TwoWire::peek() {
+	return m_rxPos < m_rxLength ? m_rx[m_rxPos] : -1;
+}
+
+TwoWire Wire;
+
+// Days from 1970-01-01 to a date and back, see
+// http://howardhinnant.github.io/date_algorithms.html
+static int32_t daysFromCivil(int32_t y, uint8_t m, uint8_t d) {
+	y -= m <= 2;
+	int32_t era = (y >= 0 ? y : y - 399) / 400;
+	uint32_t yoe = (uint32_t)(y - era * 400);
+	uint32_t doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+	uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+	return era * 146097 + (int32_t)doe - 719468;
+}
+
+DateTime::DateTime(uint32_t t) :
+	m_unixtime(t) {
+	split();
+}
+
+DateTime::DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t minute, uint8_t second) {
+	m_unixtime = (uint32_t)daysFromCivil(year, month, day) * 86400UL + hour * 3600UL + minute * 60UL + second;
+	split();
+}
+
+DateTime::DateTime(const char *date, const char *time) {
+	static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+	char name[4] = { date[0], date[1], date[2], 0 };
+	const char *month = strstr(months, name);
+
+	*this = DateTime(atoi(date + 7), month != NULL ? (month - months) / 3 + 1 : 1, atoi(date + 4),
+		atoi(time), atoi(time + 3), atoi(time + 6));
+}
+
+void DateTime::split() {
+	int32_t z = m_unixtime / 86400UL + 719468;
+	int32_t era = z / 146097;
+	uint32_t doe = (uint32_t)(z - era * 146097);
+	uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	uint32_t mp = (5 * doy + 2) / 153;
+	uint32_t seconds = m_unixtime % 86400UL;
+
+	m_day = doy - (153 * mp + 2) / 5 + 1;
+	m_month = mp < 10 ? mp + 3 : mp - 9;
+	m_year = yoe + era * 400 + (m_month <= 2);
+	m_hour = seconds / 3600;
+	m_minute = seconds / 60 % 60;
+	m_second = seconds % 60;
+}
+
+bool RTC_DS1307::begin(TwoWire *wire) {
+	return true;
+}
+
+uint8_t RTC_DS1307::isrunning() {
+	return 1;
+}
+
+// Writing the seconds restarts the divider chain, the next tick is 1s away
+void RTC_DS1307::adjust(const DateTime &dt) {
+	rtcSeconds = dt.unixtime();
+	rtcMicros = elapsed();
+	rtcSet = true;
+	rtcWrites++;
+}
+
+DateTime RTC_DS1307::now() {
+	return DateTime((uint32_t)rtcNow());
+}
+
+uint8_t RTC_DS1307::readnvram(uint8_t address) {
+	return address < HOST_NVRAM ? nvram[address] : 0;
+}
+
+void RTC_DS1307::readnvram(uint8_t *buf, uint8_t size, uint8_t address) {
+	for (uint8_t i = 0; i < size; i++) {
+		buf[i] = readnvram(address + i);
+	}
+}
+
+void RTC_DS1307::writenvram(uint8_t address, uint8_t data) {
+	if (address < HOST_NVRAM) {
+		nvram[address] = data;
+	}
+}
+
+void RTC_DS1307::writenvram(uint8_t address, const uint8_t *buf, uint8_t size) {
+	for (uint8_t i = 0; i < size; i++) {
+		writenvram(address + i, buf[i]);
+	}
+}
+
+Button::Button(uint8_t pin, uint16_t debounce_ms) :
+	m_pin(pin),
+	m_state(RELEASED) {
+}
+
+void Button::begin() {
+}
+
+bool Button::read() {
+	return m_state;
+}
+
+bool Button::toggled() {
+	if (m_state == PRESSED) {
+		m_state = RELEASED;
+		return true;
+	}
+	if (pressCount > 0 && presses[pressHead] == m_pin) {
+		pressHead = (pressHead + 1) % HOST_PRESSES;
+		pressCount--;
+		m_state = PRESSED;
+		return true;
+	}
+
+	return false;
+}
+
+bool Button::pressed() {
+	return toggled() && m_state == PRESSED;
+}
+
+bool Button::released() {
+	return toggled() && m_state == RELEASED;
+}
+
+bool Button::has_changed() {
+	return toggled();
+}
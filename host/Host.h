@@ -0,0 +1,60 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Host.h
+ * Created on: 19 Oct 2026
+ * Description: Thimo host build, the hardware as the host programs see it
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#ifndef _THIMO_HOST_H_
+#define _THIMO_HOST_H_
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <RTClib.h>
+#include <Button.h>
+
+// The host build runs the firmware against the Arduino API in stubs/:
+// millis() and micros() are the monotonic clock, Serial is stdin/stdout,
+// I2C transactions go to the WireDevice attached at their address, the
+// DS1307 keeps UTC from the system clock and buttons are pressed from
+// here. An input pin reads what was last written to it, unless a PinDevice
+// drives it (see Devices.h).
+
+// What drives an input pin: level() is asked at every digitalRead() with
+// the microseconds since the pin last turned from an output into an input
+class PinDevice {
+public:
+	virtual ~PinDevice() {}
+
+	virtual int level(unsigned long us) = 0;
+};
+
+// From now on the time only moves with delay(), hostAdvance() and by 1us
+// at every millis() or micros(), so that a busy wait comes to an end.
+// Whatever runs on it is deterministic and as fast as the host allows.
+void hostVirtualTime();
+void hostAdvance(unsigned long us);
+
+// The RTC runs ppm fast (slow if negative) from now on
+void hostRtcDrift(float ppm);
+uint32_t hostRtcWrites();	// adjust() calls so far
+
+// device drives pin while it's an input, NULL leaves it alone
+void hostAttach(uint8_t pin, PinDevice *device);
+
+// One debounced press of the button on pin, see Button.h
+void hostPress(uint8_t pin);
+
+// Real time, whatever the firmware runs on
+uint64_t hostMicros();
+
+// What the sketch writes to Serial is dropped from now on, the log with it:
+// what the program prints itself comes out alone
+void hostQuiet();
+
+#endif
@@ -0,0 +1,130 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: bench.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo host build, runs the micro-benchmarks
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Host.h"
+#include "Bench.h"
+#include "Thimo.h"
+#include <errno.h>
+
+#define BENCH_ROUNDS				50		// times the suite runs, the fastest of each case counts
+
+void setup();
+
+// Line by line, the cycles of every case the file names: the JSON lines
+// "bench json" prints, one case each. Cases it doesn't name get 0, no
+// baseline.
+static bool baselines(const char *path, uint32_t *baseline) {
+	FILE *file = fopen(path, "r");
+	char line[256];
+
+	if (file == NULL) {
+		return false;
+	}
+	for (uint8_t i = 0; i < Bench.cases(); i++) {
+		baseline[i] = 0;
+	}
+	while (fgets(line, sizeof(line), file) != NULL) {
+		char name[32];
+		const char *c = strstr(line, "\"case\":\"");
+		const char *n = strstr(line, "\"cycles\":");
+
+		if (c == NULL || n == NULL || sscanf(c, "\"case\":\"%31[^\"]", name) != 1) {
+			continue;
+		}
+		for (uint8_t i = 0; i < Bench.cases(); i++) {
+			if (strcmp(Bench.name(i), name) == 0) {
+				baseline[i] = strtoul(n + 9, NULL, 10);
+			}
+		}
+	}
+	fclose(file);
+
+	return true;
+}
+
+// Every case of the "bench" command once the sketch is up, on virtual time
+// so the start delays of the display go by at once: cycles() reads the
+// clock itself. The whole suite runs BENCH_ROUNDS times and the fastest of
+// each case counts, a host shares its cores and a slow spell would catch
+// every run of a case timed one after the other. Cycles are host time at
+// F_CPU: good to compare two builds on the same host, not the ESP32 (see
+// Bench.h).
+//
+//   ./bench              as a table
+//   ./bench json         a JSON line per case, as "bench" on the console
+//   ./bench cmp FILE     against the cycles of FILE, as "bench cmp": fails
+//                        if a case is BENCH_TOLERANCE % slower
+int main(int argc, char **argv) {
+	bool json = argc > 1 && (strcmp(argv[1], "json") == 0 || strcmp(argv[1], "cmp") == 0);
+	bool compare = argc > 2 && strcmp(argv[1], "cmp") == 0;
+	uint32_t baseline[BENCH_CASES];
+	uint8_t regressions = 0;
+	BenchResult results[BENCH_CASES];
+	BenchResult result;
+
+	if (compare && !baselines(argv[2], baseline)) {
+		fprintf(stderr, "%s: %s\n", argv[2], strerror(errno));
+		return 2;
+	}
+
+	hostVirtualTime();
+	hostQuiet();
+	setup();
+	while (!LCD.ready()) {
+		delay(1);
+		LCD.poll();
+	}
+
+	if (!json) {
+		printf("%-22s %6s %10s %6s %6s\n", "case", "n", "cycles", "bytes", "trans");
+	}
+	// round 0 only warms the host up, a core left idle starts slow
+	for (uint8_t r = 0; r <= BENCH_ROUNDS; r++) {
+		for (uint8_t i = 0; i < Bench.cases(); i++) {
+			Bench.run(i, result);
+			if (r == 1 || (r > 1 && result.cycles < results[i].cycles)) {
+				results[i] = result;
+			}
+		}
+	}
+
+	for (uint8_t i = 0; i < Bench.cases(); i++) {
+		result = results[i];
+		if (!json) {
+			printf("%-22s %6u %10u %6u %6u\n", result.name, result.iterations, result.cycles, result.bytes, result.transactions);
+			continue;
+		}
+		printf("{\"case\":\"%s\",\"n\":%u,\"cycles\":%u", result.name, result.iterations, result.cycles);
+		if (result.bytes > 0) {
+			printf(",\"bytes\":%u,\"transactions\":%u", result.bytes, result.transactions);
+		}
+		if (compare) {
+			result.baseline = baseline[i];
+			bool regression = BenchModule::regression(result);
+			if (result.baseline > 0) {
+				printf(",\"baseline\":%u", result.baseline);
+			} else {
+				printf(",\"baseline\":null");
+			}
+			printf(",\"regression\":%s", regression ? "true" : "false");
+			regressions += regression;
+		}
+		printf("}\n");
+	}
+	if (compare) {
+		printf("{\"cases\":%u,\"regressions\":%u}\n", Bench.cases(), regressions);
+	} else if (json) {
+		printf("{\"cases\":%u}\n", Bench.cases());
+	}
+
+	return regressions > 0 ? 1 : 0;
+}
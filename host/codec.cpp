@@ -0,0 +1,341 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: codec.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo host build, benchmarks the sample stream codec
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Devices.h"
+#include "History.h"
+#include "Thimo.h"
+#include "Trace.h"
+
+#define CODEC_STEP					10000UL		// us of virtual time per loop pass
+#define CODEC_START					1610690400UL	// 15 Jan 2021 06:00 UTC
+#define CODEC_RECORDS				(HISTORY_BLOCKS * HISTORY_BLOCK_SIZE)
+#define CODEC_TIME					500000ULL	// us spent encoding, then decoding
+#define CODEC_FLOAT_SAMPLE			8			// bytes of a sample kept as two floats
+
+void setup();
+void loop();
+
+// A room heated by the relay, for the sketch to read through a DHT22 with
+// its noise: up to a tenth either way, relative humidity falling as the
+// room warms up
+struct Room {
+	const char *name;
+	float outdoor;			// °C
+	float heater;			// W
+	float loss;				// W/K
+	float capacity;			// J/K
+	float temperature;		// °C at the start
+};
+
+static const Room rooms[] = {
+	{ "heating", 5.0f, 2000.0f, 80.0f, 2.0e5f, 18.0f },	// relay cycling on the schedule
+	{ "cooling", 5.0f, 0.0f, 40.0f, 1.0e6f, 21.0f },		// heating off, slowly cooling down
+};
+
+static DHTDevice dht;
+static SampleRecord inputs[CODEC_RECORDS];		// what the history was handed
+static SampleRecord records[CODEC_RECORDS];		// what it decodes to
+static uint8_t blocks[HISTORY_BLOCKS][HISTORY_BLOCK_SIZE];	// the records encoded again
+static size_t lengths[HISTORY_BLOCKS];
+static uint8_t encoded;							// blocks of them
+
+static uint32_t noise() {
+	static uint32_t seed = 1;
+
+	seed = seed * 1103515245UL + 12345UL;
+
+	return seed >> 16 & 0x7fff;
+}
+
+// Field by field, the time within a sampling period: the encoder puts a
+// sample in the slot of the period grid nearest to it (see Codec.cpp)
+static bool same(const SampleRecord &a, const SampleRecord &b) {
+	uint32_t dt = a.sample.time > b.sample.time ? a.sample.time - b.sample.time : b.sample.time - a.sample.time;
+
+	return a.type == b.type && dt <= HISTORY_PERIOD && a.sample.temperature == b.sample.temperature &&
+		a.sample.humidity == b.sample.humidity && a.relay == b.relay;
+}
+
+// Appends a record as the decoder gives it back: a relay transition with
+// the sample it follows, a sample with the relay false
+static size_t append(SampleRecord *list, size_t n, SampleRecord::Type type, const Sample &sample, bool relay) {
+	if (n < CODEC_RECORDS) {
+		list[n].type = type;
+		list[n].sample = sample;
+		list[n].relay = type == SampleRecord::RELAY && relay;
+		n++;
+	}
+
+	return n;
+}
+
+// The sketch on virtual time until its history ring is full, one block
+// more and the oldest would go. Every sample and relay transition of zone
+// 0 goes to inputs too, as the sketch hands it to the history; returns
+// how many.
+static size_t record(const Room &room) {
+	const float dt = CODEC_STEP / 1e6f;
+	float t = room.temperature;
+	Sample last = { 0, 0, 0 };
+	bool sampled = false;
+	size_t n = 0;
+
+	while (History.blocks() < HISTORY_BLOCKS) {
+		uint32_t samples = History.samples();
+		bool relay = digitalRead(RELAY_PIN) == HIGH;
+
+		hostAdvance(CODEC_STEP);
+		loop();
+		// the sample comes first, the control pass it starts may switch
+		if (History.samples() != samples) {
+			last.time = Clock.now().unixtime();
+			last.temperature = (int16_t)lroundf(Thimo.temperature(0) * 10.0f);
+			last.humidity = (int16_t)lroundf(Thimo.humidity(0) * 10.0f);
+			n = append(inputs, n, SampleRecord::SAMPLE, last, false);
+			sampled = true;
+		}
+		// before the first sample the history has nothing to tie it to
+		if ((digitalRead(RELAY_PIN) == HIGH) != relay && sampled) {
+			n = append(inputs, n, SampleRecord::RELAY, last, !relay);
+		}
+
+		float power = digitalRead(RELAY_PIN) == HIGH ? room.heater : 0.0f;
+		t += (power - room.loss * (t - room.outdoor)) * dt / room.capacity;
+		dht.set(t + ((int)(noise() % 3) - 1) * 0.05f, 60.0f - 2.0f * t + ((int)(noise() % 3) - 1) * 0.1f);
+	}
+
+	return n;
+}
+
+// The samples and relay transitions of zone 0 in a trace written by
+// record.cpp, timed by its KEY records; returns how many, 0 if the file
+// can't be read
+static size_t replay(const char *path) {
+	static uint8_t data[TRACE_BLOCKS * (TRACE_BLOCK_SIZE + 2)];
+	FILE *file = fopen(path, "rb");
+	Sample last = { 0, 0, 0 };
+	bool sampled = false;
+	uint32_t key = 0;
+	uint32_t ms = 0;
+	size_t n = 0;
+
+	if (file == NULL) {
+		return 0;
+	}
+	size_t size = fread(data, 1, sizeof(data), file);
+	fclose(file);
+
+	for (size_t pos = 0; pos + 2 <= size; ) {
+		size_t length = data[pos] | data[pos + 1] << 8;
+		const uint8_t *p = data + pos + 2;
+		const uint8_t *end = p + length;
+		TraceRecord r;
+
+		if (end > data + size) {
+			return 0;
+		}
+		while (TraceModule::decode(p, end, r)) {
+			ms += r.dt;
+			if (r.tag == TRACE_KEY) {
+				key = r.time;
+				ms = 0;
+			} else if (r.tag == TRACE_SENSOR && r.zone == 0 && r.value == Sensor::ERROR_NONE) {
+				last.time = key + ms / 1000UL;
+				last.temperature = (int16_t)lroundf(r.env.temperature * 10.0f);
+				last.humidity = (int16_t)lroundf(r.env.humidity * 10.0f);
+				n = append(inputs, n, SampleRecord::SAMPLE, last, false);
+				sampled = true;
+			} else if (r.tag == TRACE_RELAY && r.zone == 0 && sampled) {
+				n = append(inputs, n, SampleRecord::RELAY, last, r.value);
+			}
+		}
+		pos = end - data;
+	}
+
+	return n;
+}
+
+// The history as it stands, decoded into records; returns how many
+static size_t history() {
+	size_t n = 0;
+
+	for (uint8_t b = 0; b < History.blocks(); b++) {
+		size_t length;
+		const uint8_t *data = History.block(b, length);
+		SampleDecoder decoder(data, length);
+		while (n < CODEC_RECORDS && decoder.next(records[n])) {
+			n++;
+		}
+	}
+
+	return n;
+}
+
+// Whether the history decoded to what it was handed. A block a relay
+// transition opens starts over from the last sample, the decoder gives
+// that one once more: it's skipped.
+static bool matches(size_t n, size_t m) {
+	size_t j = 0;
+
+	for (size_t i = 0; i < n; i++, j++) {
+		if (j < m && !same(records[i], inputs[j]) && j > 0 && inputs[j].type == SampleRecord::RELAY && same(records[i], inputs[j - 1])) {
+			j--;
+			continue;
+		}
+		if (j >= m || !same(records[i], inputs[j])) {
+			return false;
+		}
+	}
+
+	return j == m;
+}
+
+// The records into HISTORY_BLOCK_SIZE blocks the way the history does it,
+// returns the bytes, 0 if they need more blocks than the history has
+static size_t encode(const SampleRecord *list, size_t n) {
+	SampleEncoder encoder;
+	const Sample *last = NULL;
+	size_t bytes = 0;
+
+	encoded = 0;
+	encoder.begin(blocks[0], HISTORY_BLOCK_SIZE, HISTORY_PERIOD);
+	for (size_t i = 0; i < n; i++) {
+		const SampleRecord &r = list[i];
+		bool ok = r.type == SampleRecord::SAMPLE ? encoder.push(r.sample) : encoder.relay(r.relay);
+		if (!ok) {
+			encoder.flush();
+			lengths[encoded] = encoder.length();
+			bytes += lengths[encoded];
+			if (++encoded == HISTORY_BLOCKS) {
+				return 0;
+			}
+			encoder.begin(blocks[encoded], HISTORY_BLOCK_SIZE, HISTORY_PERIOD);
+			if (r.type == SampleRecord::SAMPLE) {
+				encoder.push(r.sample);
+			} else {
+				encoder.push(*last);
+				encoder.relay(r.relay);
+			}
+		}
+		if (r.type == SampleRecord::SAMPLE) {
+			last = &r.sample;
+		}
+	}
+	encoder.flush();
+	lengths[encoded] = encoder.length();
+
+	return bytes + lengths[encoded++];
+}
+
+// Decodes the blocks encode() wrote, returns the records; with a list to
+// check against, stops at the first record that differs from it
+static size_t decode(const SampleRecord *list = NULL) {
+	SampleRecord record;
+	size_t n = 0;
+
+	for (uint8_t b = 0; b < encoded; b++) {
+		SampleDecoder decoder(blocks[b], lengths[b]);
+		while (decoder.next(record)) {
+			if (list != NULL && (n == CODEC_RECORDS || !same(record, list[n]))) {
+				return n;
+			}
+			n++;
+		}
+	}
+
+	return n;
+}
+
+// Reports the compression of the records against samples kept as floats,
+// then encodes and decodes them over and over for CODEC_TIME each to time
+// it. Fails if they don't decode to themselves, field by field.
+static bool bench(const char *name, const SampleRecord *list, size_t n) {
+	size_t samples = 0;
+
+	for (size_t j = 0; j < n; j++) {
+		samples += list[j].type == SampleRecord::SAMPLE;
+	}
+	size_t bytes = encode(list, n);
+	if (bytes == 0 || decode(list) != n) {
+		printf("%s: the records don't decode to themselves again\n", name);
+		return false;
+	}
+
+	uint64_t start = hostMicros();
+	uint64_t elapsed;
+	uint32_t encodes = 0;
+	do {
+		encode(list, n);
+		encodes++;
+	} while ((elapsed = hostMicros() - start) < CODEC_TIME);
+	double encodeRate = (double)samples * encodes * 1e6 / elapsed;
+
+	start = hostMicros();
+	uint32_t decodes = 0;
+	do {
+		decode();
+		decodes++;
+	} while ((elapsed = hostMicros() - start) < CODEC_TIME);
+	double decodeRate = (double)samples * decodes * 1e6 / elapsed;
+
+	printf("%-8s %8u %8u %8u %7.2f %6.1fx %10.0f %10.0f\n", name, (unsigned)samples, (unsigned)(n - samples), (unsigned)bytes,
+		(double)bytes / samples, (double)samples * CODEC_FLOAT_SAMPLE / bytes, encodeRate, decodeRate);
+
+	return true;
+}
+
+// For each room the sketch runs until its history is full, sampling every
+// HISTORY_PERIOD, and its history has to decode to the samples and relay
+// transitions it was handed. Then the records of the recorded trace, if
+// one is given. The log of the sketch is left out, the table only.
+//
+//   ./codec [file.trace]
+int main(int argc, char **argv) {
+	static const uint8_t table[24] = {
+		16, 16, 16, 16, 16, 16, 20, 20, 20, 20, 20, 20,
+		20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 16, 16
+	};
+
+	hostVirtualTime();
+	hostQuiet();
+	hostAttach(DHT_PIN, &dht);
+	RTC.adjust(DateTime(CODEC_START));
+	setup();
+	Thimo.timetable(0, table);
+
+	printf("%-8s %8s %8s %8s %7s %7s %10s %10s\n", "trace", "samples", "relays", "bytes", "B/smp", "ratio", "enc smp/s", "dec smp/s");
+	for (uint8_t i = 0; i < sizeof(rooms) / sizeof(rooms[0]); i++) {
+		History.begin();
+		size_t m = record(rooms[i]);
+		size_t n = history();
+		if (!matches(n, m)) {
+			printf("%s: the history doesn't decode to what it was handed\n", rooms[i].name);
+			return 1;
+		}
+		if (!bench(rooms[i].name, records, n)) {
+			return 1;
+		}
+	}
+
+	if (argc > 1) {
+		size_t m = replay(argv[1]);
+		if (m == 0) {
+			fprintf(stderr, "%s: no samples\n", argv[1]);
+			return 2;
+		}
+		if (!bench("trace", inputs, m)) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
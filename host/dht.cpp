@@ -0,0 +1,74 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: dht.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo host build, benchmarks the DHT drivers
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Devices.h"
+#include "DHT.h"
+
+#define DHT_BENCH_READS				20000
+#define DHT_BENCH_CALLS				1000000
+
+static DHTDevice device;
+static DHTModule<DHT_PIN> runtime;
+static DHTSensor<DHTBase::DHT22, DHT_PIN> fixed;
+
+// Host time per capture: the conversion started, its start delay gone by
+// and the answer collected, on virtual time so only the CPU work counts.
+// Fails unless every capture decodes to what the device sends.
+static double capture(Sensor &sensor) {
+	Environment env;
+	uint64_t start = hostMicros();
+
+	for (uint32_t i = 0; i < DHT_BENCH_READS; i++) {
+		sensor.start();
+		hostAdvance(5000UL);
+		if (sensor.poll(&env) != Sensor::ERROR_NONE || lroundf(env.temperature * 10.0f) != -123 || lroundf(env.humidity * 10.0f) != 456) {
+			return -1.0;
+		}
+	}
+
+	return (double)(hostMicros() - start) * 1000.0 / DHT_BENCH_READS;
+}
+
+// Host time of the model constants the sketch asks for, through Sensor
+static double constants(Sensor &sensor) {
+	volatile int sum = 0;
+	uint64_t start = hostMicros();
+
+	for (uint32_t i = 0; i < DHT_BENCH_CALLS; i++) {
+		Sensor *volatile s = &sensor;
+		sum += s->minimumSamplingPeriod() + s->numberOfDecimalsTemperature() + s->lowerBoundTemperature() +
+			s->upperBoundTemperature() + s->lowerBoundHumidity() + s->upperBoundHumidity();
+	}
+
+	return (double)(hostMicros() - start) * 1000.0 / DHT_BENCH_CALLS;
+}
+
+// The runtime driver, auto detected, against the one specialized on the
+// model and pin, on a DHT22 answering -12.3 °C and 45.6 %RH. The code each
+// takes is listed by "make bench" from the objects. All of it is the
+// host's: a capture here is mostly the pin model of Devices.cpp and on the
+// device the waveform of the sensor sets it, the sizes are x86 code. They
+// tell the two drivers decode alike, not what either costs on the ESP32.
+int main() {
+	hostVirtualTime();
+	hostAttach(DHT_PIN, &device);
+	device.set(-12.3f, 45.6f);
+	runtime.begin();
+
+	printf("%-10s %12s %14s\n", "driver", "ns/capture", "ns/constants");
+	double r = capture(runtime);
+	double f = capture(fixed);
+	printf("%-10s %12.1f %14.2f\n", "runtime", r, constants(runtime));
+	printf("%-10s %12.1f %14.2f\n", "DHT22", f, constants(fixed));
+
+	return r > 0.0 && f > 0.0 && runtime.minimumSamplingPeriod() == 2000 ? 0 : 1;
+}
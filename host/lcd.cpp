@@ -0,0 +1,178 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: lcd.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo host build, tests the asynchronous display transfers
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Host.h"
+#include "LCD.h"
+#include "config.h"
+
+#define LCD_TEST_ADDRESS			0x3f	// clear of the display and the RTC of the sketch
+#define LCD_TEST_FRAMES				200
+#define LCD_TEST_PERIOD				25000UL	// us, frames are drawn up to this far apart
+#define LCD_TEST_COLS				16
+#define LCD_TEST_ROWS				2
+
+// HD44780 behind a PCF8574 backpack, as far as writing text goes: a nibble
+// is latched on the falling edge of En. It starts in 8 bit mode, where a
+// nibble is a whole instruction, until it's told to go 4 bit; then two
+// nibbles make an instruction or, with Rs, a character for DDRAM at the
+// address counter, which moves on. Each byte takes its time on the bus.
+class HD44780Device : public WireDevice {
+public:
+	HD44780Device() : m_last(0), m_fourBit(false), m_half(false), m_high(0), m_address(0) {
+		memset(m_ddram, ' ', sizeof(m_ddram));
+	}
+
+	virtual void write(const uint8_t *data, size_t n) {
+		for (size_t i = 0; i < n; i++) {
+			if ((m_last & En) && !(data[i] & En)) {
+				latch(data[i]);
+			}
+			m_last = data[i];
+		}
+		delayMicroseconds(n * 9 * 1000000UL / Wire.clock());
+	}
+
+	inline const uint8_t *row(uint8_t r) const { return m_ddram + (r ? 0x40 : 0x00); }
+private:
+	void latch(uint8_t value) {
+		uint8_t nibble = value & 0xf0;
+
+		if (!m_fourBit) {
+			if (nibble == LCD_FUNCTIONSET) {
+				m_fourBit = true;
+			}
+			return;
+		}
+		if (!m_half) {
+			m_high = nibble;
+			m_half = true;
+			return;
+		}
+		m_half = false;
+		execute(m_high | nibble >> 4, value & Rs);
+	}
+
+	void execute(uint8_t value, bool data) {
+		if (data) {
+			m_ddram[m_address] = value;
+			m_address = (m_address + 1) & 0x7f;
+		} else if (value & LCD_SETDDRAMADDR) {
+			m_address = value & 0x7f;
+		} else if (value == LCD_CLEARDISPLAY) {
+			memset(m_ddram, ' ', sizeof(m_ddram));
+			m_address = 0;
+		} else if (value == LCD_RETURNHOME) {
+			m_address = 0;
+		}
+	}
+
+	uint8_t m_last;
+	bool m_fourBit;
+	bool m_half;
+	uint8_t m_high;
+	uint8_t m_address;
+	uint8_t m_ddram[0x80];
+};
+
+static HD44780Device device;
+static AsyncPCF8574Bus bus(LCD_TEST_ADDRESS, I2C_CLOCK);
+static LCDModule lcd(bus);
+
+static uint32_t completed = 0;
+static uint32_t torn = 0;
+static uint32_t latest = 0;
+
+// Frame k: its number on both rows, and around it cells that all change
+// from one frame to the next
+static void text(uint32_t k, uint8_t r, char *dst) {
+	snprintf(dst, LCD_TEST_COLS + 1, "%c%05u", r ? 'B' : 'A', k);
+	for (uint8_t c = 6; c < LCD_TEST_COLS; c++) {
+		dst[c] = 'a' + (k + c * 3 + r) % 26;
+	}
+	dst[LCD_TEST_COLS] = '\0';
+}
+
+// The frame number a row shows, if the whole row is that frame
+static bool shown(uint8_t r, uint32_t &k) {
+	char expected[LCD_TEST_COLS + 1];
+	char row[LCD_TEST_COLS + 1];
+
+	memcpy(row, device.row(r), LCD_TEST_COLS);
+	row[LCD_TEST_COLS] = '\0';
+	k = strtoul(row + 1, NULL, 10);
+	text(k, r, expected);
+
+	return strcmp(row, expected) == 0;
+}
+
+// From the transfer task, once a frame is on the bus: the display has to
+// show a whole frame, the same on both rows, never an older one than the
+// last time
+static void complete(void *arg) {
+	uint32_t k0;
+	uint32_t k1;
+
+	if (!shown(0, k0) || !shown(1, k1) || k0 != k1 || k0 < latest) {
+		if (torn++ < 4) {
+			printf("torn frame after %u: \"%.16s\" \"%.16s\"\n", latest, device.row(0), device.row(1));
+		}
+	} else {
+		latest = k0;
+	}
+	__atomic_add_fetch(&completed, 1, __ATOMIC_RELEASE);
+}
+
+// The main thread draws LCD_TEST_FRAMES frames at uneven intervals, about
+// as long as a transfer, while the transfer thread puts them on the
+// display; frames finding the bus busy are left pending and may be drawn
+// over before they go. Fails if a completed transfer ever leaves the
+// display with anything but one whole frame, or the last one isn't shown.
+int main() {
+	char line[LCD_TEST_COLS + 1];
+	uint32_t pending = 0;
+
+	Wire.attach(LCD_TEST_ADDRESS, &device);
+	bus.onComplete(complete, NULL);
+	lcd.begin(LCD_TEST_COLS, LCD_TEST_ROWS);
+
+	uint64_t start = hostMicros();
+	for (uint32_t k = 1; k <= LCD_TEST_FRAMES; k++) {
+		lcd.frame();
+		for (uint8_t r = 0; r < LCD_TEST_ROWS; r++) {
+			text(k, r, line);
+			lcd.setCursor(0, r);
+			lcd.print(line);
+		}
+		if (!lcd.swap()) {
+			pending++;
+		}
+		// as the loop would, at any point of a transfer
+		uint64_t next = hostMicros() + k * 2654435761UL % LCD_TEST_PERIOD;
+		while (hostMicros() < next) {
+			lcd.poll();
+		}
+	}
+	while (lcd.pending()) {
+		lcd.poll();
+	}
+	lcd.wait();
+	uint64_t elapsed = hostMicros() - start;
+	// the callback runs right after the bus is free
+	while (__atomic_load_n(&completed, __ATOMIC_ACQUIRE) != bus.transfers() && hostMicros() - start < elapsed + 1000000ULL) {
+		yield();
+	}
+
+	printf("%u frames drawn, %u transfers, %u pending, %u completed, %u torn, last shown %u, %.1f ms\n",
+		LCD_TEST_FRAMES, bus.transfers(), pending, completed, torn, latest, elapsed / 1e3);
+
+	return torn == 0 && latest == LCD_TEST_FRAMES && completed == bus.transfers() ? 0 : 1;
+}
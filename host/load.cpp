@@ -0,0 +1,194 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: load.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo host build, load test of the HTTP server
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Host.h"
+#include "Http.h"
+#include "Zone.h"
+#include <pthread.h>
+#include <algorithm>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define LOAD_CLIENTS				32		// looping on /status and /metrics
+#define LOAD_STALLED				3		// sending half a request, then nothing
+#define LOAD_TIME					10		// s, unless given
+#define LOAD_RESPONSE_SIZE			(HTTP_RESPONSE_SIZE + 1)
+
+void setup();
+void loop();
+
+struct Client {
+	pthread_t thread;
+	const char *path;
+	uint32_t failures;
+	std::vector<uint32_t> latencies;	// us, of every good response
+};
+
+static uint64_t deadline;
+static int active = LOAD_CLIENTS + LOAD_STALLED;	// threads not done yet
+static size_t largest = 0;							// bytes of the longest response
+
+static int connectServer() {
+	struct sockaddr_in address;
+	struct timeval timeout = { 5, 0 };
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+	if (fd < 0) {
+		return -1;
+	}
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = htons(HTTP_HOST_PORT);
+	if (connect(fd, (struct sockaddr *)&address, sizeof(address)) < 0) {
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+// One request on its own connection, good if it's a 200 with the body
+// its Content-Length says and, for /metrics, the last zone in it; the
+// server closes the connection after it
+static bool request(const char *path) {
+	char last[16];
+	char response[LOAD_RESPONSE_SIZE + 1];
+	char line[64];
+	size_t length = 0;
+	ssize_t n;
+	int fd = connectServer();
+
+	if (fd < 0) {
+		return false;
+	}
+	int size = snprintf(line, sizeof(line), "GET %s HTTP/1.1\r\nHost: thimo\r\n\r\n", path);
+	if (send(fd, line, size, MSG_NOSIGNAL) != size) {
+		close(fd);
+		return false;
+	}
+	while (length < LOAD_RESPONSE_SIZE && (n = recv(fd, response + length, LOAD_RESPONSE_SIZE - length, 0)) > 0) {
+		length += n;
+	}
+	close(fd);
+	response[length] = '\0';
+
+	const char *field = strstr(response, "Content-Length: ");
+	const char *body = strstr(response, "\r\n\r\n");
+	snprintf(last, sizeof(last), "{zone=\"%u\"}", ZONE_COUNT - 1);
+	for (size_t n = largest; length > n && !__sync_bool_compare_and_swap(&largest, n, length); n = largest) {
+	}
+
+	return strncmp(response, "HTTP/1.1 200 ", 13) == 0 && field != NULL && body != NULL &&
+		strtoul(field + 16, NULL, 10) == length - (body + 4 - response) &&
+		(strcmp(path, "/metrics") != 0 || strstr(body, last) != NULL);
+}
+
+static void *client(void *arg) {
+	Client *c = (Client *)arg;
+
+	while (hostMicros() < deadline) {
+		uint64_t start = hostMicros();
+		if (request(c->path)) {
+			c->latencies.push_back(hostMicros() - start);
+		} else {
+			c->failures++;
+		}
+	}
+	__sync_fetch_and_sub(&active, 1);
+
+	return NULL;
+}
+
+// Holds a connection with half a request until the server drops it, then
+// does it again
+static void *stalled(void *arg) {
+	static const char half[] = "GET /status HTTP/1.1\r\n";
+	char data[256];
+
+	while (hostMicros() < deadline) {
+		int fd = connectServer();
+		if (fd < 0) {
+			continue;
+		}
+		send(fd, half, sizeof(half) - 1, MSG_NOSIGNAL);
+		while (hostMicros() < deadline && recv(fd, data, sizeof(data), 0) > 0) {
+		}
+		close(fd);
+	}
+	__sync_fetch_and_sub(&active, 1);
+
+	return NULL;
+}
+
+// The sketch runs in real time, as on the device, while LOAD_CLIENTS
+// threads fetch /status and /metrics over and over and LOAD_STALLED ones
+// hold connections with unfinished requests. Reports the good responses,
+// their latency and the longest HTTP poll of the loop; fails if any
+// response was missing or wrong.
+//
+//   ./load [seconds]
+int main(int argc, char **argv) {
+	static Client clients[LOAD_CLIENTS];
+	static pthread_t stalls[LOAD_STALLED];
+	std::vector<uint32_t> latencies;
+	uint32_t failures = 0;
+	uint64_t seconds = argc > 1 ? strtoul(argv[1], NULL, 10) : LOAD_TIME;
+
+	setup();
+	if (!Http.online()) {
+		fprintf(stderr, "no HTTP server on port %u\n", HTTP_HOST_PORT);
+		return 2;
+	}
+
+	uint64_t start = hostMicros();
+	deadline = start + seconds * 1000000ULL;
+	for (uint8_t i = 0; i < LOAD_CLIENTS; i++) {
+		clients[i].path = i % 2 ? "/metrics" : "/status";
+		pthread_create(&clients[i].thread, NULL, client, &clients[i]);
+	}
+	for (uint8_t i = 0; i < LOAD_STALLED; i++) {
+		pthread_create(&stalls[i], NULL, stalled, NULL);
+	}
+
+	// until the last request is answered
+	while (__sync_fetch_and_add(&active, 0) > 0) {
+		loop();
+	}
+
+	for (uint8_t i = 0; i < LOAD_CLIENTS; i++) {
+		pthread_join(clients[i].thread, NULL);
+		failures += clients[i].failures;
+		latencies.insert(latencies.end(), clients[i].latencies.begin(), clients[i].latencies.end());
+	}
+	for (uint8_t i = 0; i < LOAD_STALLED; i++) {
+		pthread_join(stalls[i], NULL);
+	}
+	std::sort(latencies.begin(), latencies.end());
+
+	if (latencies.empty()) {
+		printf("no responses, %u failures\n", failures);
+		return 1;
+	}
+	printf("%u zones, %u requests in %lu s, %u failures, %u clients, %u stalled, largest response %u of %u bytes\n",
+		ZONE_COUNT, (unsigned)latencies.size(), (unsigned long)seconds, failures, LOAD_CLIENTS, LOAD_STALLED,
+		(unsigned)largest, HTTP_RESPONSE_SIZE);
+	printf("latency p50 %.1f ms, p99 %.1f ms, max %.1f ms, longest poll %.1f ms\n",
+		latencies[latencies.size() / 2] / 1e3, latencies[latencies.size() * 99 / 100] / 1e3,
+		latencies.back() / 1e3, Http.pollMax() / 1e3);
+
+	return failures == 0 ? 0 : 1;
+}
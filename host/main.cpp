@@ -0,0 +1,34 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: main.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo host build, the sketch as a Linux program
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Host.h"
+#include "Console.h"
+#include "Log.h"
+
+void setup();
+void loop();
+
+// Runs the sketch with the console on stdin/stdout, until stdin is over and
+// everything it asked for is answered. The loop never sleeps, as on the
+// device while the HTTP server is up.
+//
+//   echo "sim 365 pid" | ./thimo-sim
+int main() {
+	setup();
+
+	while (!Serial.closed() || Serial.available() > 0 || !Console.idle() || !Log.idle()) {
+		loop();
+	}
+	fflush(stdout);
+
+	return 0;
+}
@@ -0,0 +1,191 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: ntp.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo host build, tests the clock against a local time server
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Host.h"
+#include "Clock.h"
+#include "Ntp.h"
+#include <time.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#define NTP_TEST_START				1774000000UL	// 20 Mar 2026 09:46:40 UTC
+#define NTP_TEST_STEP				100000UL	// us of virtual time per poll
+#define NTP_TEST_LATENCY			20UL		// ms each way on the network
+#define NTP_TEST_RTC_ERROR			100UL		// s the RTC is ahead at boot
+#define NTP_TEST_RTC_DRIFT			40.0f		// ppm it runs fast
+#define NTP_TEST_DRIFT_ERROR		0.5f		// ppm off the true drift after three days
+#define NTP_TEST_SYNC_ERROR			100L		// ms off the server after a sync
+#define NTP_TEST_RTC_LIMIT			1000L		// ms off on the corrected RTC alone
+
+static int server = -1;
+static bool serving = true;
+static uint64_t start;
+
+// The true time, in ms since 1970: the virtual time from the start
+static uint64_t truth() {
+	return (uint64_t)NTP_TEST_START * 1000ULL + (micros() - start) / 1000ULL;
+}
+
+static void put32(uint8_t *dst, uint32_t value) {
+	dst[0] = value >> 24;
+	dst[1] = value >> 16;
+	dst[2] = value >> 8;
+	dst[3] = value;
+}
+
+// The stand-in time server: a stratum 2 server answering on the loopback
+// with the true time, as it is when the request has come across the
+// network. It holds nothing, receive and transmit times are the same.
+static void serve() {
+	uint8_t request[NTP_PACKET_SIZE];
+	uint8_t reply[NTP_PACKET_SIZE];
+	struct sockaddr_in address;
+	socklen_t length = sizeof(address);
+
+	if (recvfrom(server, request, sizeof(request), 0, (struct sockaddr *)&address, &length) != NTP_PACKET_SIZE || !serving) {
+		return;
+	}
+
+	uint64_t now = truth() + NTP_TEST_LATENCY;
+	uint32_t seconds = now / 1000ULL + NTP_UNIX_OFFSET;
+	uint32_t fraction = ((now % 1000ULL) << 32) / 1000ULL;
+
+	memset(reply, 0, sizeof(reply));
+	reply[0] = 0x24;		// no leap second warning, version 4, server
+	reply[1] = 2;
+	memcpy(reply + 24, request + 40, 8);
+	put32(reply + 32, seconds);
+	put32(reply + 36, fraction);
+	put32(reply + 40, seconds);
+	put32(reply + 44, fraction);
+	sendto(server, reply, sizeof(reply), 0, (struct sockaddr *)&address, length);
+}
+
+// The clock as the firmware drives it: the client polled from the loop,
+// the local time asked for once a second
+static void run(unsigned long seconds) {
+	for (unsigned long i = 0; i < seconds * (1000000UL / NTP_TEST_STEP); i++) {
+		hostAdvance(NTP_TEST_STEP);
+		Ntp.poll();
+		serve();
+		if (i % (1000000UL / NTP_TEST_STEP) == 0) {
+			Clock.now();
+		}
+	}
+}
+
+// ms the clock is ahead of the true time, taken as its seconds tick over:
+// moves the time on by a second at most
+static long error() {
+	uint32_t utc = Clock.utc();
+
+	for (int i = 0; i < 1000 && Clock.utc() == utc; i++) {
+		hostAdvance(1000UL);
+	}
+
+	return (long)((int64_t)Clock.utc() * 1000LL - (int64_t)truth());
+}
+
+static bool check(bool ok, const char *what) {
+	if (!ok) {
+		printf("FAILED: %s\n", what);
+	}
+
+	return ok;
+}
+
+// The time zone table against the system rules for Europe/Rome, every half
+// hour of the tabulated years, which takes in every transition: local time
+// both ways, the skipped spring hour taken as standard time
+static uint32_t zones() {
+	uint32_t first = DateTime(TIME_FIRST_YEAR, 1, 1).unixtime();
+	uint32_t last = DateTime(TIME_FIRST_YEAR + TIME_YEARS, 1, 1).unixtime();
+	uint32_t mismatches = 0;
+
+	setenv("TZ", "Europe/Rome", 1);
+	tzset();
+	for (uint32_t utc = first; utc < last; utc += 1800) {
+		time_t t = utc;
+		struct tm tm;
+
+		localtime_r(&t, &tm);
+		uint32_t local = utc + tm.tm_gmtoff;
+		uint32_t back = Clock.toUtc(local);
+		if (Clock.toLocal(utc) != local || (back != utc && !(tm.tm_isdst == 0 && back == utc - 3600))) {
+			if (mismatches++ < 4) {
+				printf("zone mismatch at %u: local %u, table %u\n", utc, local, Clock.toLocal(utc));
+			}
+		}
+	}
+	printf("time zone: %u to %u, %u mismatches\n", TIME_FIRST_YEAR, TIME_FIRST_YEAR + TIME_YEARS - 1, mismatches);
+
+	return mismatches;
+}
+
+// The device build with a DS1307 ahead and running fast, against the
+// stand-in server on NTP_HOST_PORT: the first sync sets the clock and the
+// RTC, the next ones measure the RTC drift. Then the server goes away and
+// the clock runs on the RTC alone, corrected for the drift, for ten days
+// until it comes back. Fails if anything is out of bounds.
+int main() {
+	struct sockaddr_in address;
+	bool ok = true;
+
+	if (!check(zones() == 0, "time zone table")) {
+		return 1;
+	}
+
+	server = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = htons(NTP_HOST_PORT);
+	if (server < 0 || bind(server, (struct sockaddr *)&address, sizeof(address)) < 0) {
+		perror("time server");
+		return 2;
+	}
+
+	hostVirtualTime();
+	start = micros();
+	RTC.adjust(DateTime(NTP_TEST_START + NTP_TEST_RTC_ERROR));
+	hostRtcDrift(NTP_TEST_RTC_DRIFT);
+	uint32_t writes = hostRtcWrites();
+	Clock.begin();
+	Ntp.begin();
+
+	long boot = error();
+	run(10);
+	printf("first sync: %ld ms off at boot, %ld ms after, %u RTC writes\n", boot, error(), hostRtcWrites() - writes);
+	ok &= check(Ntp.syncs() == 1 && labs(error()) <= NTP_TEST_SYNC_ERROR, "first sync");
+	ok &= check(hostRtcWrites() - writes == 1 && Clock.record().exact, "RTC set by the first sync");
+
+	run(3 * 86400UL);
+	printf("3 days: %u syncs, %u failures, drift %.2f ppm (%.1f), %ld ms off, %u RTC writes\n",
+		Ntp.syncs(), Ntp.failures(), Clock.record().drift, NTP_TEST_RTC_DRIFT, error(), hostRtcWrites() - writes);
+	ok &= check(Ntp.failures() == 0 && labs(error()) <= NTP_TEST_SYNC_ERROR, "syncs");
+	ok &= check(fabsf(Clock.record().drift - NTP_TEST_RTC_DRIFT) <= NTP_TEST_DRIFT_ERROR, "RTC drift");
+	ok &= check(hostRtcWrites() - writes == 1, "RTC written once");
+
+	serving = false;
+	run(10 * 86400UL);
+	long rtc = (long)((int64_t)RTC.now().unixtime() * 1000LL - (int64_t)truth());
+	printf("10 days without server: %ld ms off, %ld ms on the RTC itself\n", error(), rtc);
+	ok &= check(labs(error()) <= NTP_TEST_RTC_LIMIT, "clock on the RTC");
+
+	serving = true;
+	run(NTP_RETRY / 1000UL + 10);
+	printf("server back: %u syncs, %ld ms off, %u RTC writes\n", Ntp.syncs(), error(), hostRtcWrites() - writes);
+	ok &= check(labs(error()) <= NTP_TEST_SYNC_ERROR, "sync after the server is back");
+
+	return ok ? 0 : 1;
+}
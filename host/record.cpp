@@ -0,0 +1,118 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: record.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo host build, records the trace fixture
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Devices.h"
+#include "Thimo.h"
+
+#define RECORD_STEP					10000UL		// us of virtual time per loop pass
+#define RECORD_START				1610690400UL	// 15 Jan 2021 06:00 UTC
+#define RECORD_OUTDOOR				5.0f		// °C
+#define RECORD_HEATER				2000.0f		// W
+#define RECORD_LOSS					80.0f		// W/K
+#define RECORD_CAPACITY				5.0e4f		// J/K, a small room so the relay cycles in minutes
+
+void setup();
+void loop();
+
+static DHTDevice dht;
+static float room = 19.0f;
+
+// Passes of the sketch on virtual time, the room follows the relay, until
+// the trace ring is full: one block more and the oldest would go
+static bool run(unsigned long seconds) {
+	const float dt = RECORD_STEP / 1e6f;
+
+	for (unsigned long i = 0; i < seconds * (1000000UL / RECORD_STEP); i++) {
+		if (Trace.blocks() >= TRACE_BLOCKS) {
+			return false;
+		}
+		hostAdvance(RECORD_STEP);
+		loop();
+		float power = digitalRead(RELAY_PIN) == HIGH ? RECORD_HEATER : 0.0f;
+		room += (power - RECORD_LOSS * (room - RECORD_OUTDOOR)) * dt / RECORD_CAPACITY;
+		dht.set(room, 45.0f);
+	}
+
+	return true;
+}
+
+static void press(uint8_t pin) {
+	hostPress(pin);
+	run(2);
+}
+
+// The sketch boots on virtual time with a DHT22 in a small room heated by
+// the relay, gets a schedule, is driven from the buttons, edits an
+// override and goes on until the trace ring is about to wrap. Then the
+// trace is written out as 16 bit little endian block lengths, each
+// followed by its block. Anything that changes the outputs for the same
+// inputs changes the fixture, it is recorded again with `make fixtures`.
+int main(int argc, char **argv) {
+	static const uint8_t table[24] = {
+		16, 16, 16, 16, 16, 16, 20, 20, 20, 20, 20, 20,
+		20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 16, 16
+	};
+
+	if (argc != 2) {
+		fprintf(stderr, "usage: record file.trace\n");
+		return 2;
+	}
+
+	hostVirtualTime();
+	hostAttach(DHT_PIN, &dht);
+	RTC.adjust(DateTime(RECORD_START));
+	setup();
+
+	Thimo.timetable(0, table);
+	run(20);
+
+	// through the views and back, then a boost from the override editor
+	press(BUTTON_N_PIN);
+	press(BUTTON_N_PIN);
+	press(BUTTON_N_PIN);
+	press(BUTTON_P_PIN);
+	for (int i = 0; i < VIEW_COUNT && Thimo.view() != OVERRIDE; i++) {
+		press(BUTTON_P_PIN);
+	}
+	hostPress(BUTTON_S_PIN);
+	hostPress(BUTTON_P_PIN);
+	hostPress(BUTTON_S_PIN);
+	hostPress(BUTTON_S_PIN);
+	run(60);
+
+	// manual mode from the console, then back to the schedule
+	Thimo.manualSetpoint(0, 185);
+	Thimo.manualMode(0, true);
+	run(60);
+	Thimo.manualMode(0, false);
+	while (run(60)) {
+	}
+
+	FILE *file = fopen(argv[1], "wb");
+	if (file == NULL) {
+		perror(argv[1]);
+		return 1;
+	}
+	for (uint8_t i = 0; i < Trace.blocks(); i++) {
+		size_t length;
+		const uint8_t *data = Trace.block(i, length);
+		uint8_t header[2] = { (uint8_t)length, (uint8_t)(length >> 8) };
+		fwrite(header, 1, sizeof(header), file);
+		fwrite(data, 1, length, file);
+	}
+	fclose(file);
+
+	printf("%u records %u bytes in %u blocks, %u overrides, %lu s\n",
+		Trace.records(), (unsigned)Trace.bytes(), Trace.blocks(), Overrides.count(), millis() / 1000UL);
+
+	return 0;
+}
@@ -0,0 +1,83 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: replay.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo host build, replays a trace and checks its outputs
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Host.h"
+#include "Thimo.h"
+
+#define REPLAY_TIME					1000000ULL	// us spent replaying again, to time it
+
+void setup();
+
+// Loads a trace written by record.cpp into the simulation build the way
+// the console TRACE_LOAD frames do and replays it like the "replay"
+// command. Fails unless the replay is exact, from the boot state, and
+// every relay and display output matches the recording. Then replays it
+// over and over for REPLAY_TIME to time it.
+int main(int argc, char **argv) {
+	static uint8_t data[TRACE_BLOCKS * (TRACE_BLOCK_SIZE + 2) + 1];
+	size_t n;
+	uint8_t blocks = 0;
+
+	if (argc != 2) {
+		fprintf(stderr, "usage: replay file.trace\n");
+		return 2;
+	}
+
+	FILE *file = fopen(argv[1], "rb");
+	if (file == NULL) {
+		perror(argv[1]);
+		return 2;
+	}
+	n = fread(data, 1, sizeof(data), file);
+	fclose(file);
+
+	hostVirtualTime();
+	setup();
+	while (!LCD.ready()) {
+		hostAdvance(1000UL);
+		LCD.poll();
+	}
+
+	for (size_t pos = 0; pos + 2 <= n; blocks++) {
+		size_t length = data[pos] | data[pos + 1] << 8;
+		if (pos + 2 + length > n || !Trace.load(blocks, 0, data + pos + 2, length)) {
+			fprintf(stderr, "%s: bad block %u\n", argv[1], blocks);
+			return 2;
+		}
+		pos += 2 + length;
+	}
+
+	Trace.replay();
+	uint32_t records = Trace.replayed();
+	bool ok = Trace.exact() && Trace.relayErrors() == 0 && Trace.displayErrors() == 0;
+	printf("%u records in %u blocks, relay errors %u, display errors %u%s\n",
+		records, blocks, Trace.relayErrors(), Trace.displayErrors(), Trace.exact() ? "" : ", not exact");
+	if (!ok || records == 0) {
+		return 1;
+	}
+
+	uint64_t start = hostMicros();
+	uint64_t elapsed = 0;
+	uint32_t replays = 0;
+	while (elapsed < REPLAY_TIME) {
+		Trace.replay();
+		if (Trace.relayErrors() != 0 || Trace.displayErrors() != 0) {
+			printf("replay %u differs\n", replays + 1);
+			return 1;
+		}
+		replays++;
+		elapsed = hostMicros() - start;
+	}
+	printf("%u replays, %.0f records/s\n", replays, (double)records * replays * 1e6 / elapsed);
+
+	return 0;
+}
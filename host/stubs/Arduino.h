@@ -0,0 +1,128 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Arduino.h
+ * Created on: 19 Oct 2026
+ * Description: Arduino core API for the host build (see ../Host.cpp)
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#ifndef _THIMO_HOST_ARDUINO_H_
+#define _THIMO_HOST_ARDUINO_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifndef F_CPU
+#define F_CPU						240000000L	// what the cycle counts are scaled to, as on the device
+#endif
+
+#define HIGH						1
+#define LOW							0
+
+#define INPUT						0
+#define OUTPUT						1
+#define INPUT_PULLUP				2
+
+#define DEC							10
+#define HEX							16
+
+#define B00000001					1
+#define B00000010					2
+#define B00000100					4
+
+#define F(s)						(s)
+
+#define TWO_PI						6.283185307179586476925286766559
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+template<class T> inline T constrain(T x, T low, T high) {
+	return x < low ? low : (x > high ? high : x);
+}
+
+class Print {
+public:
+	virtual ~Print() {}
+
+	virtual size_t write(uint8_t c) = 0;
+	virtual size_t write(const uint8_t *buffer, size_t size);
+	inline size_t write(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+	virtual int availableForWrite() { return 0; }
+	virtual void flush() {}
+
+	size_t print(const char *s);
+	size_t print(char c);
+	size_t print(unsigned char n, int base = DEC);
+	size_t print(int n, int base = DEC);
+	size_t print(unsigned int n, int base = DEC);
+	size_t print(long n, int base = DEC);
+	size_t print(unsigned long n, int base = DEC);
+	size_t print(double n, int digits = 2);
+
+	size_t println();
+	size_t println(const char *s);
+	size_t println(int n, int base = DEC);
+	size_t println(unsigned int n, int base = DEC);
+	size_t println(long n, int base = DEC);
+	size_t println(unsigned long n, int base = DEC);
+	size_t println(double n, int digits = 2);
+private:
+	size_t number(unsigned long n, int base);
+};
+
+class Stream : public Print {
+public:
+	virtual int available() = 0;
+	virtual int read() = 0;
+	virtual int peek() = 0;
+};
+
+// stdin and stdout, nothing ever waits: input is taken as it comes and
+// output is written straight through
+class HardwareSerial : public Stream {
+public:
+	HardwareSerial();
+
+	void begin(unsigned long baud);
+	inline bool closed() const { return m_closed; }	// stdin is over and all of it read
+
+	virtual int available();
+	virtual int read();
+	virtual int peek();
+	virtual size_t write(uint8_t c);
+	virtual size_t write(const uint8_t *buffer, size_t size);
+	virtual int availableForWrite();
+
+	using Print::write;
+private:
+	uint8_t m_in[256];
+	size_t m_inPos;
+	size_t m_inLength;
+	bool m_closed;
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,38 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Button.h
+ * Created on: 19 Oct 2026
+ * Description: Button library API for the host build (see ../Host.cpp)
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#ifndef _THIMO_HOST_BUTTON_LIB_H_
+#define _THIMO_HOST_BUTTON_LIB_H_
+
+#include <Arduino.h>
+
+// Presses come from hostPress(), already debounced, in the order they were
+// made: a press toggles to PRESSED, the next look toggles back to RELEASED
+class Button {
+public:
+	static const bool PRESSED = LOW;
+	static const bool RELEASED = HIGH;
+
+	Button(uint8_t pin, uint16_t debounce_ms = 100);
+
+	void begin();
+	bool read();
+	bool toggled();
+	bool pressed();
+	bool released();
+	bool has_changed();
+private:
+	uint8_t m_pin;
+	bool m_state;
+};
+
+#endif
@@ -0,0 +1,61 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: RTClib.h
+ * Created on: 19 Oct 2026
+ * Description: RTClib API for the host build (see ../Host.cpp)
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#ifndef _THIMO_HOST_RTCLIB_H_
+#define _THIMO_HOST_RTCLIB_H_
+
+#include <Arduino.h>
+#include <Wire.h>
+
+// Seconds since 1970, broken down in the proleptic Gregorian calendar
+class DateTime {
+public:
+	DateTime(uint32_t t = 0);
+	DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour = 0, uint8_t minute = 0, uint8_t second = 0);
+	DateTime(const char *date, const char *time);	// __DATE__ and __TIME__
+
+	inline uint16_t year() const { return m_year; }
+	inline uint8_t month() const { return m_month; }
+	inline uint8_t day() const { return m_day; }
+	inline uint8_t hour() const { return m_hour; }
+	inline uint8_t minute() const { return m_minute; }
+	inline uint8_t second() const { return m_second; }
+	inline uint8_t dayOfTheWeek() const { return (m_unixtime / 86400UL + 4) % 7; }	// 0 is Sunday
+	inline uint32_t unixtime() const { return m_unixtime; }
+private:
+	void split();
+
+	uint32_t m_unixtime;
+	uint16_t m_year;
+	uint8_t m_month;
+	uint8_t m_day;
+	uint8_t m_hour;
+	uint8_t m_minute;
+	uint8_t m_second;
+};
+
+// The DS1307 counts from the host clock at the rate set with hostRtcDrift(),
+// its NVRAM lasts as long as the process
+class RTC_DS1307 {
+public:
+	bool begin(TwoWire *wire = &Wire);
+	uint8_t isrunning();
+	void adjust(const DateTime &dt);
+	DateTime now();
+
+	uint8_t readnvram(uint8_t address);
+	void readnvram(uint8_t *buf, uint8_t size, uint8_t address);
+	void writenvram(uint8_t address, uint8_t data);
+	void writenvram(uint8_t address, const uint8_t *buf, uint8_t size);
+};
+
+#endif
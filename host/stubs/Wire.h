@@ -0,0 +1,69 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: Wire.h
+ * Created on: 19 Oct 2026
+ * Description: Arduino I2C API for the host build (see ../Host.cpp)
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#ifndef _THIMO_HOST_WIRE_H_
+#define _THIMO_HOST_WIRE_H_
+
+#include <Arduino.h>
+#include <pthread.h>
+
+#define I2C_BUFFER_LENGTH			128		// as on ESP32
+#define I2C_DEVICES					128
+
+// What answers at an address: takes the bytes of a write transaction, hands
+// out the bytes of a read. Called from the thread making the transaction.
+class WireDevice {
+public:
+	virtual ~WireDevice() {}
+
+	virtual void write(const uint8_t *data, size_t n) = 0;
+	virtual size_t read(uint8_t *data, size_t n) { return 0; }
+};
+
+// Transactions go to the device attached at their address, an address
+// nobody answers is NACKed. Like the ESP32 core a transaction holds the bus
+// from beginTransmission() to endTransmission(), so threads can share it.
+class TwoWire : public Stream {
+public:
+	TwoWire();
+
+	void begin();
+	void setClock(uint32_t frequency);
+	inline uint32_t clock() const { return m_clock; }
+	void attach(uint8_t address, WireDevice *device);
+
+	void beginTransmission(uint8_t address);
+	uint8_t endTransmission(bool stop = true);
+	uint8_t requestFrom(uint8_t address, uint8_t quantity);
+
+	virtual size_t write(uint8_t c);
+	virtual size_t write(const uint8_t *data, size_t n);
+	virtual int available();
+	virtual int read();
+	virtual int peek();
+
+	using Print::write;
+private:
+	pthread_mutex_t m_lock;
+	WireDevice *m_devices[I2C_DEVICES];
+	uint32_t m_clock;
+	uint8_t m_address;
+	uint8_t m_tx[I2C_BUFFER_LENGTH];
+	size_t m_txLength;
+	uint8_t m_rx[I2C_BUFFER_LENGTH];
+	size_t m_rxPos;
+	size_t m_rxLength;
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,138 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: tuning.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo host build, step response of the relay controllers
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Host.h"
+#include "Control.h"
+
+#define TUNING_STEP					10000UL	// ms per sample, about what the sensors give
+#define TUNING_SETBACK				160		// tenths of °C, night setpoint held before the step
+#define TUNING_SETPOINT				200		// tenths of °C, day setpoint stepped to
+#define TUNING_SETTLE				4		// h at the setback first
+#define TUNING_RUN					12		// h after the step
+#define TUNING_HOLD					6		// last h of them, cycles and error are counted over these
+#define TUNING_BAND					0.3f	// °C, settled once within it to the end
+#define TUNING_SEED					0x2545f491UL
+
+// The room of the simulation (see Simulator.h): SIM_HEATER_POWER into
+// SIM_CAPACITY, lost through SIM_LOSS to a steady outdoor temperature,
+// read through the sensor lag and noise in DHT22 steps
+struct Room {
+	float temperature;
+	float sensed;
+	uint32_t seed;
+};
+
+struct Response {
+	float overshoot;		// °C above the setpoint at the most
+	long settling;			// s from the step, -1 if it never stays in the band
+	float cycles;			// relay starts per hour over the hold
+	float deviation;		// mean |temperature - setpoint| over the hold, °C
+	float duty;				// relay on time over the hold
+};
+
+// xorshift32, uniform in [-1, 1)
+static float noise(uint32_t &seed) {
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+
+	return (float)(int32_t)seed / 2147483648.0f;
+}
+
+static void step(Room &room, bool heating, float outdoor) {
+	const float dt = TUNING_STEP / 1000.0f;
+	float power = heating ? SIM_HEATER_POWER : 0.0f;
+
+	room.temperature += (power - SIM_LOSS * (room.temperature - outdoor)) * dt / SIM_CAPACITY;
+	room.sensed += (room.temperature - room.sensed) * (1.0f - expf(-dt / SIM_SENSOR_LAG));
+}
+
+static int16_t measure(Room &room) {
+	return (int16_t)lroundf((room.sensed + SIM_SENSOR_NOISE * noise(room.seed)) * 10.0f);
+}
+
+// The room settles under the setback, then the setpoint steps up: how far
+// the air goes past it, when it stays within TUNING_BAND of it for good,
+// and how the relay works once it has
+static Response respond(Controller::Mode mode, float outdoor) {
+	const unsigned long samples = TUNING_RUN * 3600000UL / TUNING_STEP;
+	const unsigned long hold = (TUNING_RUN - TUNING_HOLD) * 3600000UL / TUNING_STEP;
+	Room room = { TUNING_SETBACK / 10.0f, TUNING_SETBACK / 10.0f, TUNING_SEED };
+	Controller controller;
+	Response response = { 0.0f, 0L, 0.0f, 0.0f, 0.0f };
+	unsigned long now = 0UL;
+	unsigned long outside = 0UL;
+	uint32_t cycles = 0;
+	uint32_t on = 0;
+	bool relay = false;
+
+	controller.begin(mode, false, now);
+	for (unsigned long i = 0; i < TUNING_SETTLE * 3600000UL / TUNING_STEP; i++) {
+		relay = controller.update(TUNING_SETBACK, measure(room), now);
+		step(room, relay, outdoor);
+		now += TUNING_STEP;
+	}
+
+	for (unsigned long i = 0; i < samples; i++) {
+		relay = controller.update(TUNING_SETPOINT, measure(room), now);
+		if (i == hold) {
+			cycles = controller.cycles();
+		}
+		step(room, relay, outdoor);
+		now += TUNING_STEP;
+
+		float error = room.temperature - TUNING_SETPOINT / 10.0f;
+		if (error > response.overshoot) {
+			response.overshoot = error;
+		}
+		if (fabsf(error) > TUNING_BAND) {
+			outside = i + 1;
+		}
+		if (i >= hold) {
+			response.deviation += fabsf(error);
+			on += relay;
+		}
+	}
+
+	response.settling = outside < samples ? (long)(outside * (TUNING_STEP / 1000UL)) : -1L;
+	response.cycles = (float)(controller.cycles() - cycles) / TUNING_HOLD;
+	response.deviation /= samples - hold;
+	response.duty = (float)on / (samples - hold);
+
+	return response;
+}
+
+// The day setpoint after the night one, for both controllers in a mild and
+// in a cold day, with the gains and times of config.h. Run it again after
+// changing them.
+int main() {
+	static const Controller::Mode modes[] = { Controller::HYSTERESIS, Controller::PID };
+	static const float outdoors[] = { 10.0f, 0.0f };
+
+	printf("%-10s %7s %9s %9s %9s %8s %6s\n", "mode", "outdoor", "overshoot", "settling", "cycles/h", "dev", "duty");
+	for (uint8_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+		for (uint8_t o = 0; o < sizeof(outdoors) / sizeof(outdoors[0]); o++) {
+			Response r = respond(modes[m], outdoors[o]);
+			char settling[16];
+
+			if (r.settling < 0) {
+				snprintf(settling, sizeof(settling), "never");
+			} else {
+				snprintf(settling, sizeof(settling), "%ldh%02ld'", r.settling / 3600, r.settling / 60 % 60);
+			}
+			printf("%-10s %5.1f C %7.2f C %9s %9.1f %6.2f C %5.0f%%\n", modes[m] == Controller::PID ? "pid" : "hysteresis",
+				outdoors[o], r.overshoot, settling, r.cycles, r.deviation, r.duty * 100.0f);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,86 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: window.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo host build, open window detection in a small room
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Devices.h"
+#include "Thimo.h"
+
+#define WINDOW_STEP					100000UL	// us of virtual time per loop pass
+#define WINDOW_START				1610690400UL	// 15 Jan 2021 06:00 UTC
+#define WINDOW_LEARN				8			// h the thermal model learns the room first
+#define WINDOW_CYCLES				12			// h of heating cycles then, none is a window
+#define WINDOW_OPEN					900000UL	// ms the window is open at last
+#define WINDOW_OPEN_LOSS			400.0f		// W/K on top of the walls while it is
+
+void setup();
+void loop();
+
+// The heating room of codec.cpp: 2 kW into 200 kJ/K, 80 W/K out to 5 °C.
+// With the heater off it cools by some 20 °C/h, past WINDOW_DROP.
+struct Room {
+	float temperature;
+	float loss;
+	uint32_t starts;
+};
+
+static DHTDevice dht;
+
+// The sketch on virtual time for ms, the room following its relay
+static void run(Room &room, unsigned long ms) {
+	const float dt = WINDOW_STEP / 1e6f;
+
+	for (unsigned long t = 0; t < ms; t += WINDOW_STEP / 1000UL) {
+		bool relay = digitalRead(RELAY_PIN) == HIGH;
+		hostAdvance(WINDOW_STEP);
+		loop();
+		bool on = digitalRead(RELAY_PIN) == HIGH;
+		room.starts += on && !relay;
+		room.temperature += ((on ? 2000.0f : 0.0f) - room.loss * (room.temperature - 5.0f)) * dt / 2.0e5f;
+		dht.set(room.temperature, 45.0f);
+	}
+}
+
+// The room held at 20 °C all day. Once the model has learned it, the
+// cooling after each heating cycle must not be taken for an open window,
+// a window opened at last must be.
+int main() {
+	static const uint8_t table[24] = {
+		20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20,
+		20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20
+	};
+	const Zone &zone = Thimo.zone(0);
+	Room room = { 18.0f, 80.0f, 0 };
+
+	hostVirtualTime();
+	hostQuiet();
+	hostAttach(DHT_PIN, &dht);
+	dht.set(room.temperature, 45.0f);
+	RTC.adjust(DateTime(WINDOW_START));
+	setup();
+	Thimo.timetable(0, table);
+
+	run(room, WINDOW_LEARN * 3600000UL);
+	uint32_t learned = zone.window.detections();
+	uint32_t starts = room.starts;
+	run(room, WINDOW_CYCLES * 3600000UL);
+	uint32_t cycles = room.starts - starts;
+	uint32_t detections = zone.window.detections() - learned;
+
+	room.loss += WINDOW_OPEN_LOSS;
+	run(room, WINDOW_OPEN);
+	bool seen = zone.window.detections() - learned > detections;
+
+	printf("model %s, %.1f C/h off at 20 C; %u heating cycles in %u h, %u open windows; %u while learning; window %s\n",
+		zone.model.ready() ? "ready" : "not ready", zone.model.rate(0.0f, 20.0f), cycles, WINDOW_CYCLES, detections,
+		learned, seen ? "seen" : "missed");
+
+	return zone.model.ready() && cycles > 0 && detections == 0 && seen ? 0 : 1;
+}
@@ -0,0 +1,50 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: zones.cpp
+ * Created on: 19 Oct 2026
+ * Description: Thimo host build, benchmarks the control pass by zone count
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#include "Host.h"
+#include "Simulator.h"
+#include "Thimo.h"
+
+#define ZONES_DAYS					60		// simulated, unless given
+
+void setup();
+
+// Built once per zone list (see zones.h): the simulator runs every zone on
+// the day and night schedule of sim.txt, one sample per zone and step.
+// Reports the control time per pass and per step; per step it has to grow
+// linearly with the zones, a pass has to stay the same.
+//
+//   ./zones-N [days]
+int main(int argc, char **argv) {
+	static const uint8_t table[24] = {
+		16, 16, 16, 16, 16, 16, 20, 20, 20, 20, 20, 20,
+		20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 16, 16
+	};
+	uint16_t days = argc > 1 ? strtoul(argv[1], NULL, 10) : ZONES_DAYS;
+
+	setup();
+	for (uint8_t z = 0; z < ZONE_COUNT; z++) {
+		Thimo.timetable(z, table);
+	}
+
+	uint64_t start = hostMicros();
+	Simulator.run(days);
+	uint64_t elapsed = hostMicros() - start;
+	uint32_t steps = days * (86400000UL / SIM_STEP);
+	uint32_t passes = Simulator.passes();
+	double time = Simulator.passTime();
+
+	printf("%2u zones: %u steps, %u control passes, %.3f us per pass, %.3f us per step, %.3f us per zone and step, run %.2f us per step\n",
+		ZONE_COUNT, steps, passes, passes ? time / passes : 0.0, time / steps, time / steps / ZONE_COUNT, (double)elapsed / steps);
+
+	return passes >= steps * ZONE_COUNT ? 0 : 1;
+}
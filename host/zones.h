@@ -0,0 +1,34 @@
+/**
+ *
+ * THIMO IoT remote programmable termostat
+ *
+ * Filename: zones.h
+ * Created on: 19 Oct 2026
+ * Description: Thimo host build, the zone lists of the zones benchmark
+ *
+ * Copyright (C) 2020-2021 Marco Rossi (aka Mark Reds) <marco@markreds.it>
+ *
+ */
+
+#ifndef _THIMO_HOST_ZONES_H_
+#define _THIMO_HOST_ZONES_H_
+
+// Given before config.h with -include and HOST_ZONES set to 4 or 16, any
+// other count keeps the list in config.h. The zones past the first have
+// their sensors on pins 34 up and their relays on pins 49 up, clear of the
+// display and the buttons.
+#define HOST_ZONE(X, n)				X(ZONE_DHT(33 + n), 48 + n)
+
+#if HOST_ZONES == 4
+#define ZONES(X) \
+	X(ZONE_DHT(DHT_PIN), RELAY_PIN) \
+	HOST_ZONE(X, 1) HOST_ZONE(X, 2) HOST_ZONE(X, 3)
+#elif HOST_ZONES == 16
+#define ZONES(X) \
+	X(ZONE_DHT(DHT_PIN), RELAY_PIN) \
+	HOST_ZONE(X, 1) HOST_ZONE(X, 2) HOST_ZONE(X, 3) HOST_ZONE(X, 4) HOST_ZONE(X, 5) \
+	HOST_ZONE(X, 6) HOST_ZONE(X, 7) HOST_ZONE(X, 8) HOST_ZONE(X, 9) HOST_ZONE(X, 10) \
+	HOST_ZONE(X, 11) HOST_ZONE(X, 12) HOST_ZONE(X, 13) HOST_ZONE(X, 14) HOST_ZONE(X, 15)
+#endif
+
+#endif